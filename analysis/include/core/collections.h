@@ -1,13 +1,29 @@
 #ifndef CORE_COLLECTIONS_H
 #define CORE_COLLECTIONS_H
 
+// STL
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <exception>
 // RAPIDO
 #include "arbol.h"
 #include "arbusto.h"
 #include "cutflow.h"
 #include "hepcli.h"
+// VBS
+#include "core/lhe.h"           // LHE::Cache
+#include "core/sumweights.h"    // SumOfWeights
+#include "core/soa.h"           // SoA::Event
+#include "core/triggers.h"      // Triggers::Resolver
+#include "core/vetomaps.h"      // VetoMaps::Engine, VetoMaps::HEM
+#include "core/composites.h"    // Composites::Cache
+#include "core/input.h"         // Input::Looper
+#include "core/eventindex.h"    // EventIndex::Writer
+#include "core/output.h"        // Output::setCompression
 // ROOT
 #include "TString.h"
+#include "TDirectory.h"
 // NanoCORE
 #include "Nano.h"
 #include "Config.h"             // gconf
@@ -27,45 +43,150 @@ struct Skimmer
     Nano& nt;
     HEPCLI& cli;
     Cutflow& cutflow;
-    TList* runs;
-    TList* lumis;
+    TTree* runs;                            // Runs of all input files so far, in the output file
+    TTree* lumis;                           // LuminosityBlocks of all input files so far, in the output file
+    EventIndex::SkimFormat format;
+    int compression;
+    EventIndex::Writer index;
+    std::vector<Long64_t> kept_entries;     // passing entries of the current file (fast skims)
+    int n_files_total;
+    int n_files_cloned;
+    int n_clusters_total;
+    int n_clusters_full;
+    Long64_t n_events_cloned;               // events written by fast-cloning whole files...
+    Long64_t n_events_copied;               // ...and one by one, and the time each took
+    double clone_seconds;
+    double copy_seconds;
 
-    Skimmer(Arbusto& arbusto_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref) 
-    : arbusto(arbusto_ref), nt(nt_ref), cli(cli_ref), cutflow(cutflow_ref)
+    Skimmer(Arbusto& arbusto_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref,
+            EventIndex::SkimFormat new_format = EventIndex::CopySkim,
+            int new_compression = Output::DefaultCompression) 
+    : arbusto(arbusto_ref), nt(nt_ref), cli(cli_ref), cutflow(cutflow_ref), format(new_format),
+      compression(new_compression), n_files_total(0), n_files_cloned(0), n_clusters_total(0), n_clusters_full(0),
+      n_events_cloned(0), n_events_copied(0), clone_seconds(0.), copy_seconds(0.)
     {
         gconf.nanoAOD_ver = 9;
-        runs = new TList();
-        lumis = new TList();
+        runs = nullptr;
+        lumis = nullptr;
+        Output::setCompression(arbusto.tfile, nullptr, compression);
+        if (format == EventIndex::IndexSkim) { index.attach(arbusto.tfile, compression); }
     };
 
     virtual void init(TTree* ttree)
     {
-        arbusto.init(ttree);
+        if (format == EventIndex::IndexSkim) { index.newFile(ttree); }
+        else
+        {
+            arbusto.init(ttree);
+            // The branches are cloned from the input, along with its compression
+            Output::setCompression(arbusto.tfile, arbusto.ttree, compression);
+        }
+        kept_entries.clear();
         gconf.GetConfigs(nt.year());
 
         TString file_name = ttree->GetCurrentFile()->GetName();
         gconf.isAPV = (file_name.Contains("HIPM_UL2016") || file_name.Contains("NanoAODAPV") || file_name.Contains("UL16APV"));
 
         // Store metadata ttrees
-        TTree* runtree = ((TTree*)ttree->GetCurrentFile()->Get("Runs"))->CloneTree();
-        runtree->SetDirectory(0);
-        runs->Add(runtree);
-        TTree* lumitree = ((TTree*)ttree->GetCurrentFile()->Get("LuminosityBlocks"))->CloneTree();
-        lumitree->SetDirectory(0);
-        lumis->Add(lumitree);
+        streamMetadata(runs, (TTree*) ttree->GetCurrentFile()->Get("Runs"));
+        streamMetadata(lumis, (TTree*) ttree->GetCurrentFile()->Get("LuminosityBlocks"));
     };
 
-    virtual void write()
+    /* Append the entries of a metadata TTree of the current input file to its copy in the output
+       file, booked from the first input file. The entries (genEventSumw and all) are copied as they
+       are, the same way TTree::MergeTrees would, but the baskets go to the output file as they fill
+       up, so memory does not grow with the number of input files. */
+    void streamMetadata(TTree*& output, TTree* input)
+    {
+        TDirectory::TContext context(arbusto.tfile); // the current directory is restored on return
+        if (output == nullptr)
+        {
+            output = input->CloneTree(0);
+            output->SetDirectory(arbusto.tfile);
+            Output::setCompression(arbusto.tfile, output, compression);
+            // Detach the copy from the input, which is deleted along with its file
+            input->GetListOfClones()->Remove(output);
+            input->ResetBranchAddresses();
+            output->ResetBranchAddresses();
+        }
+        output->CopyEntries(input, -1, "", true);
+    };
+
+    /* Keep the given entry of the current input file */
+    virtual void fill(int entry)
+    {
+        switch (format)
+        {
+        case EventIndex::CopySkim:
+            arbusto.fill(entry);
+            break;
+        case EventIndex::FastSkim:
+            kept_entries.push_back(entry);
+            break;
+        case EventIndex::IndexSkim:
+            index.fill(entry);
+            break;
+        }
+    };
+
+    /* End of an input file (see Input::Looper::run): for fast skims, the whole file is fast-cloned
+       (its baskets copied as they are, without decompressing them) if all of its events passed, and
+       the passing events are copied one by one otherwise. TTreeCloner only clones whole trees, so
+       this is done file by file rather than cluster by cluster; the clusters that passed in full
+       are counted all the same, to show how much a finer-grained clone would gain. The baskets of
+       a cloned file keep the compression of the input, whatever the compression of the skim. Both
+       paths are timed, so that write() can compare their throughput (with --verbose). */
+    virtual void finish(TTree* ttree)
     {
-        TTree* merged_runs = TTree::MergeTrees(runs);
-        merged_runs->SetName("Runs");
-        TTree* merged_lumis = TTree::MergeTrees(lumis);
-        merged_lumis->SetName("LuminosityBlocks");
+        if (format != EventIndex::FastSkim) { return; }
+        n_files_total++;
+        std::vector<EventIndex::Cluster> clusters = EventIndex::Reader::plan(ttree, kept_entries);
+        for (auto& cluster : clusters)
+        {
+            if ((Long64_t) cluster.entries.size() == cluster.end - cluster.start) { n_clusters_full++; }
+        }
+        TTree::TClusterIterator cluster_iter = ttree->GetClusterIterator(0);
+        while (cluster_iter() < ttree->GetEntries()) { n_clusters_total++; }
+
+        auto start = std::chrono::steady_clock::now();
+        if ((Long64_t) kept_entries.size() == ttree->GetEntries())
+        {
+            arbusto.ttree->CopyEntries(ttree, -1, "fast");
+            n_files_cloned++;
+            n_events_cloned += kept_entries.size();
+            clone_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        else
+        {
+            for (Long64_t entry : kept_entries) { arbusto.fill(entry); }
+            n_events_copied += kept_entries.size();
+            copy_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        kept_entries.clear();
+    };
 
+    virtual void write()
+    {
         arbusto.tfile->cd();
-        merged_runs->Write();
-        merged_lumis->Write();
-        arbusto.write();
+        if (runs != nullptr) { runs->Write("", TObject::kOverwrite); }
+        if (lumis != nullptr) { lumis->Write("", TObject::kOverwrite); }
+        if (format == EventIndex::IndexSkim)
+        {
+            // The Arbusto was never initialized, so there is no TTree of its own to write
+            index.write(arbusto.tfile);
+            arbusto.tfile->Close();
+        }
+        else { arbusto.write(); }
+        if (format == EventIndex::FastSkim && cli.verbose)
+        {
+            std::cout << "Core::Skimmer: " << n_files_cloned << " of " << n_files_total << " files fast-cloned, "
+                      << n_clusters_full << " of " << n_clusters_total << " clusters passed in full" << std::endl;
+            // Throughput of the fast clone against the event-by-event copy of the other files
+            std::cout << "Core::Skimmer: " << n_events_cloned << " events fast-cloned in " << clone_seconds << " s ("
+                      << ((clone_seconds > 0) ? n_events_cloned/clone_seconds : 0) << " events/s), "
+                      << n_events_copied << " events copied one by one in " << copy_seconds << " s ("
+                      << ((copy_seconds > 0) ? n_events_copied/copy_seconds : 0) << " events/s)" << std::endl;
+        }
     };
 };
 
@@ -75,20 +196,26 @@ struct Analysis
     Nano& nt;
     HEPCLI& cli;
     Cutflow& cutflow;
+    SumOfWeights sum_of_weights;
+    SoA::Event soa;
+    Triggers::Resolver triggers;
+    VetoMaps::Engine veto_maps;
+    Composites::Cache composites;
+    LHE::Cache lhe;
 
     Analysis(Arbol& arbol_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref) 
     : arbol(arbol_ref), nt(nt_ref), cli(cli_ref), cutflow(cutflow_ref)
     {
         // Lepton globals
-        cutflow.globals.newVar<LorentzVectors>("veto_lep_p4s", {});
+        cutflow.globals.newVar<SoA::P4Views>("veto_lep_p4s", {});
         cutflow.globals.newVar<Integers>("veto_lep_pdgIDs", {});
         cutflow.globals.newVar<Integers>("veto_lep_idxs", {});
         cutflow.globals.newVar<Integers>("veto_lep_jet_idxs", {});
         // Jet globals
-        cutflow.globals.newVar<LorentzVectors>("good_jet_p4s", {});
+        cutflow.globals.newVar<SoA::P4Views>("good_jet_p4s", {});
         cutflow.globals.newVar<Integers>("good_jet_idxs", {});
         // Fat jet (AK8) globals
-        cutflow.globals.newVar<LorentzVectors>("good_fatjet_p4s", {});
+        cutflow.globals.newVar<SoA::P4Views>("good_fatjet_p4s", {});
         cutflow.globals.newVar<Integers>("good_fatjet_idxs", {});
         cutflow.globals.newVar<Doubles>("good_fatjet_wqqtags", {});    // ParticleNet tagger
         cutflow.globals.newVar<Doubles>("good_fatjet_zqqtags", {});    // ParticleNet tagger
@@ -105,6 +232,18 @@ struct Analysis
         cutflow.globals.newVar<LorentzVector>("tr_vbsjet_p4");
         cutflow.globals.newVar<int>("ld_vbsjet_idx");
         cutflow.globals.newVar<int>("tr_vbsjet_idx");
+        // Eta-phi maps applied to the jets
+        veto_maps.set(VetoMaps::HEM());
+    };
+
+    /* The sums of weights of MC jobs are written next to the cutflow when the job is done (but not
+       if it ends with an exception, since they would be incomplete) */
+    virtual ~Analysis()
+    {
+        if (!cli.is_data && std::uncaught_exceptions() == 0)
+        {
+            sum_of_weights.write(cli.output_dir+"/"+cli.output_name+"_SumOfWeights.json");
+        }
     };
 
     virtual void initBranches()
@@ -149,6 +288,8 @@ struct Analysis
         arbol.newBranch<double>("trig_sf", -999);
         arbol.newBranch<double>("trig_sf_up", -999);
         arbol.newBranch<double>("trig_sf_dn", -999);
+        arbol.newBranch<int>("run", -999);
+        arbol.newBranch<int>("luminosityBlock", -999);
         arbol.newBranch<int>("event", -999);
         arbol.newBranch<int>("year", -999);
         arbol.newBranch<double>("MET", -999);
@@ -181,6 +322,18 @@ struct Analysis
         );
         gconf.GetConfigs(nt.year());
 
+        // HLT paths and LHE branches present in this file
+        triggers.init(cli.input_tchain->GetTree(), nt.year());
+        lhe.init(cli.input_tchain->GetTree());
+
+        // Sums of weights of all generated events, from the Runs tree (see core/sumweights.h)
+        if (!nt.isData())
+        {
+            TTree* runs = (TTree*) cli.input_tchain->GetCurrentFile()->Get("Runs");
+            if (runs == nullptr) { sum_of_weights.skip(file_name.Data()); }
+            else { sum_of_weights.add(runs); }
+        }
+
         // Golden JSON
         if (nt.isData())
         {
@@ -0,0 +1,279 @@
+#ifndef CORE_COLUMNS_H
+#define CORE_COLUMNS_H
+
+// STL
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+// RAPIDO
+#include "arbol.h"
+// ROOT
+#include "TTree.h"
+#include "TBranch.h"
+#include "TBranchElement.h"
+#include "TLeaf.h"
+#include "TString.h"
+
+/* Columnar flat-binary copy of an Arbol: every leaf is written to its own file of raw
+   little-endian values, one per filled entry, and a schema.json lists the files, the numpy dtype
+   of each and the number of entries, so that Python reads a column with np.memmap and no parsing
+   (see utils/columns.py):
+
+       {output_dir}/{output_name}_columns/
+           schema.json
+           M_jj.bin                 <- n_entries values
+           morph_coefs.offsets      <- n_entries + 1 int64, starting at 0
+           morph_coefs.data         <- offsets[-1] values
+
+   The Writer mirrors the branches of the Arbol's TTree, so it is created (and filled) next to
+   the Arbol it copies, after all of its branches are booked:
+
+       Columns::Writer columns = Columns::Writer(arbol, cli.output_dir + "/" + cli.output_name + "_columns");
+       ...
+       if (checkpoints.at(0)) { arbol.fill(); columns.fill(); }
+       ...
+       arbol.write();
+       columns.write();
+*/
+namespace Columns
+{
+
+/* Bytes kept in memory per column before they are appended to its file */
+const size_t flush_size = 1 << 20;
+
+/* Appends the values of a std::vector leaf to a buffer and returns their number */
+typedef size_t (*VectorAppender)(const char* object, std::vector<char>& buffer);
+
+struct Column
+{
+    std::string name;
+    std::string dtype;       // numpy dtype string, e.g. "<f8"
+    size_t item_size;
+    bool is_vector;
+    TBranch* branch;
+    VectorAppender append_vector; // vector columns
+    int64_t n_items;         // total number of values written (vector columns)
+    std::vector<char> data;
+    std::vector<char> offsets;
+
+    std::string dataFile() const { return (is_vector) ? name + ".data" : name + ".bin"; };
+    std::string offsetsFile() const { return name + ".offsets"; };
+};
+
+class Writer
+{
+private:
+    TTree* ttree;
+    std::string output_dir;
+    std::vector<Column> columns;
+    bool initialized;
+    int64_t n_entries;
+
+    static bool isLittleEndian()
+    {
+        uint16_t one = 1;
+        unsigned char first_byte;
+        std::memcpy(&first_byte, &one, 1);
+        return first_byte == 1;
+    };
+
+    /* Numpy dtype and size of a ROOT leaf type or of the element type of a std::vector */
+    static std::string dtype(std::string type_name, size_t& item_size)
+    {
+        if (type_name == "Double_t" || type_name == "double") { item_size = 8; return "<f8"; }
+        if (type_name == "Float_t" || type_name == "float") { item_size = 4; return "<f4"; }
+        if (type_name == "Long64_t" || type_name == "long long" || type_name == "Long_t" || type_name == "long")
+        {
+            item_size = 8;
+            return "<i8";
+        }
+        if (type_name == "ULong64_t" || type_name == "unsigned long long" || type_name == "ULong_t"
+            || type_name == "unsigned long")
+        {
+            item_size = 8;
+            return "<u8";
+        }
+        if (type_name == "Int_t" || type_name == "int") { item_size = 4; return "<i4"; }
+        if (type_name == "UInt_t" || type_name == "unsigned int") { item_size = 4; return "<u4"; }
+        if (type_name == "Short_t" || type_name == "short") { item_size = 2; return "<i2"; }
+        if (type_name == "UShort_t" || type_name == "unsigned short") { item_size = 2; return "<u2"; }
+        if (type_name == "Char_t" || type_name == "char") { item_size = 1; return "|i1"; }
+        if (type_name == "UChar_t" || type_name == "unsigned char") { item_size = 1; return "|u1"; }
+        if (type_name == "Bool_t" || type_name == "bool") { item_size = 1; return "|b1"; }
+        throw std::runtime_error("Columns::Writer::dtype - unsupported type " + type_name);
+    };
+
+    static void append(std::vector<char>& buffer, const void* bytes, size_t n_bytes)
+    {
+        const char* first = static_cast<const char*>(bytes);
+        buffer.insert(buffer.end(), first, first + n_bytes);
+    };
+
+    template<typename Type>
+    static size_t appendVector(const char* object, std::vector<char>& buffer)
+    {
+        const std::vector<Type>& values = *reinterpret_cast<const std::vector<Type>*>(object);
+        append(buffer, values.data(), values.size()*sizeof(Type));
+        return values.size();
+    };
+
+    static size_t appendVectorBool(const char* object, std::vector<char>& buffer)
+    {
+        // std::vector<bool> is packed, so it is copied value by value
+        const std::vector<bool>& values = *reinterpret_cast<const std::vector<bool>*>(object);
+        for (bool value : values) { buffer.push_back((value) ? 1 : 0); }
+        return values.size();
+    };
+
+    static VectorAppender vectorAppender(std::string dtype)
+    {
+        if (dtype == "<f8") { return &appendVector<double>; }
+        if (dtype == "<f4") { return &appendVector<float>; }
+        if (dtype == "<i8") { return &appendVector<int64_t>; }
+        if (dtype == "<u8") { return &appendVector<uint64_t>; }
+        if (dtype == "<i4") { return &appendVector<int32_t>; }
+        if (dtype == "<u4") { return &appendVector<uint32_t>; }
+        if (dtype == "<i2") { return &appendVector<int16_t>; }
+        if (dtype == "<u2") { return &appendVector<uint16_t>; }
+        if (dtype == "|i1") { return &appendVector<int8_t>; }
+        if (dtype == "|u1") { return &appendVector<uint8_t>; }
+        return &appendVectorBool;
+    };
+
+    void flush(std::string file_name, std::vector<char>& buffer)
+    {
+        if (buffer.empty()) { return; }
+        std::ofstream output_stream(output_dir + "/" + file_name, std::ios::binary | std::ios::app);
+        output_stream.write(buffer.data(), buffer.size());
+        if (!output_stream)
+        {
+            throw std::runtime_error("Columns::Writer::flush - could not write " + output_dir + "/" + file_name);
+        }
+        buffer.clear();
+    };
+
+    /* Book one column per branch of the TTree (on the first fill, once all branches exist) */
+    void init()
+    {
+        mkdir(output_dir.c_str(), 0755);
+        TObjArray* branches = ttree->GetListOfBranches();
+        for (int branch_i = 0; branch_i < branches->GetEntriesFast(); ++branch_i)
+        {
+            Column column;
+            column.branch = (TBranch*) branches->At(branch_i);
+            column.name = column.branch->GetName();
+            column.n_items = 0;
+            column.append_vector = nullptr;
+            TBranchElement* branch_element = dynamic_cast<TBranchElement*>(column.branch);
+            if (branch_element)
+            {
+                TString class_name = branch_element->GetClassName();
+                if (!class_name.BeginsWith("vector<") || !class_name.EndsWith(">"))
+                {
+                    throw std::runtime_error(
+                        "Columns::Writer::init - unsupported class " + std::string(class_name.Data())
+                        + " of branch " + column.name
+                    );
+                }
+                TString element_type = class_name(7, class_name.Length() - 8);
+                column.is_vector = true;
+                column.dtype = dtype(element_type.Data(), column.item_size);
+                column.append_vector = vectorAppender(column.dtype);
+                // Offsets start at 0, so that offsets[i]:offsets[i + 1] are the values of entry i
+                append(column.offsets, &column.n_items, sizeof(int64_t));
+            }
+            else
+            {
+                TLeaf* leaf = (TLeaf*) column.branch->GetListOfLeaves()->At(0);
+                if (column.branch->GetListOfLeaves()->GetEntriesFast() != 1 || leaf->GetLeafCount()
+                    || leaf->GetLen() != 1)
+                {
+                    throw std::runtime_error("Columns::Writer::init - branch " + column.name + " is not a scalar");
+                }
+                column.is_vector = false;
+                column.dtype = dtype(leaf->GetTypeName(), column.item_size);
+            }
+            // Start from empty files
+            std::ofstream(output_dir + "/" + column.dataFile(), std::ios::binary | std::ios::trunc);
+            if (column.is_vector)
+            {
+                std::ofstream(output_dir + "/" + column.offsetsFile(), std::ios::binary | std::ios::trunc);
+            }
+            columns.push_back(column);
+        }
+        initialized = true;
+    };
+
+public:
+    Writer(Arbol& arbol, std::string new_output_dir)
+    : ttree(arbol.ttree), output_dir(new_output_dir), initialized(false), n_entries(0)
+    {
+        if (!isLittleEndian())
+        {
+            throw std::runtime_error("Columns::Writer - only little-endian hosts are supported");
+        }
+    };
+
+    /* Append the current values of all leaves of the Arbol */
+    void fill()
+    {
+        if (!initialized) { init(); }
+        for (auto& column : columns)
+        {
+            if (column.is_vector)
+            {
+                const char* object = static_cast<TBranchElement*>(column.branch)->GetObject();
+                column.n_items += column.append_vector(object, column.data);
+                append(column.offsets, &column.n_items, sizeof(int64_t));
+            }
+            else
+            {
+                // Query the address every time, in case the Arbol moved its leaves
+                append(column.data, column.branch->GetAddress(), column.item_size);
+            }
+            if (column.data.size() >= flush_size) { flush(column.dataFile(), column.data); }
+            if (column.offsets.size() >= flush_size) { flush(column.offsetsFile(), column.offsets); }
+        }
+        n_entries++;
+    };
+
+    /* Flush all columns and write the schema */
+    void write()
+    {
+        if (!initialized) { init(); }
+        for (auto& column : columns)
+        {
+            flush(column.dataFile(), column.data);
+            if (column.is_vector) { flush(column.offsetsFile(), column.offsets); }
+        }
+        std::ofstream output_stream(output_dir + "/schema.json");
+        output_stream << "{\n";
+        output_stream << "    \"format\": \"columns\",\n";
+        output_stream << "    \"version\": 1,\n";
+        output_stream << "    \"ttree\": \"" << ttree->GetName() << "\",\n";
+        output_stream << "    \"n_entries\": " << n_entries << ",\n";
+        output_stream << "    \"columns\": [\n";
+        for (unsigned int column_i = 0; column_i < columns.size(); ++column_i)
+        {
+            const Column& column = columns.at(column_i);
+            output_stream << "        {\"name\": \"" << column.name << "\", "
+                          << "\"dtype\": \"" << column.dtype << "\", "
+                          << "\"data\": \"" << column.dataFile() << "\"";
+            if (column.is_vector)
+            {
+                output_stream << ", \"offsets\": \"" << column.offsetsFile() << "\"";
+            }
+            output_stream << "}" << ((column_i + 1 == columns.size()) ? "\n" : ",\n");
+        }
+        output_stream << "    ]\n";
+        output_stream << "}\n";
+    };
+};
+
+} // End namespace Columns;
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef CORE_COMPOSITES_H
+#define CORE_COMPOSITES_H
+
+// STL
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+// NanoCORE
+#include "Nano.h"
+
+/* Per-event cache of multi-object systems (e.g. the VBS jj or the VVH system). Cuts set the p4
+   of each role they select once per event ("ld_vbsjet", "hbbfatjet", ...); a composite candidate
+   is declared once, at construction, as the sum of some roles, and its p4 (and so its mass, pt,
+   eta and phi) and ST are computed on first use and reused by every later cut and leaf. Setting
+   a role again invalidates the candidates it is part of, and Core::Bookkeeping clears the roles
+   at the start of each event.
+
+       unsigned int vvh_i = composites.declare("VVH", {"hbbfatjet", "ld_vqqfatjet", "tr_vqqfatjet"});
+       ...
+       composites.setRole("hbbfatjet", hbbfatjet_p4);                // in the cut selecting it
+       ...
+       arbol.setLeaf<double>("M_VVH", composites.M(vvh_i));
+
+   The p4 is summed in the order of the roles, starting from the first one (not from a zero
+   vector), so it is exactly the same as the expression role_1 + role_2 + ... it replaces.
+*/
+namespace Composites
+{
+
+typedef uint64_t Roles; // bit i <-> role i
+
+struct Candidate
+{
+    std::string name;
+    std::vector<unsigned int> roles; // in the order they are summed
+    Roles mask;
+    bool computed;
+    LorentzVector p4;
+    double st;
+};
+
+class Cache
+{
+private:
+    std::vector<std::string> role_names;
+    std::vector<LorentzVector> role_p4s;
+    Roles set_roles;
+    std::vector<Candidate> candidates;
+
+    void compute(Candidate& candidate)
+    {
+        if (!has(candidate))
+        {
+            throw std::runtime_error("Composites::Cache::compute - not all roles of " + candidate.name + " are set");
+        }
+        candidate.p4 = role_p4s[candidate.roles.front()];
+        candidate.st = candidate.p4.pt();
+        for (unsigned int role_i = 1; role_i < candidate.roles.size(); ++role_i)
+        {
+            const LorentzVector& role_p4 = role_p4s[candidate.roles[role_i]];
+            candidate.p4 += role_p4;
+            candidate.st += role_p4.pt();
+        }
+        candidate.computed = true;
+    };
+
+    bool has(const Candidate& candidate) const { return (set_roles & candidate.mask) == candidate.mask; };
+
+    const Candidate& get(unsigned int cand_i)
+    {
+        Candidate& candidate = candidates.at(cand_i);
+        if (!candidate.computed) { compute(candidate); }
+        return candidate;
+    };
+
+public:
+    Cache() : set_roles(0) {};
+
+    /* Index of a role, added if new */
+    unsigned int addRole(std::string role_name)
+    {
+        unsigned int role_i = getRole(role_name, false);
+        if (role_i < role_names.size()) { return role_i; }
+        if (role_names.size() == 8*sizeof(Roles))
+        {
+            throw std::runtime_error("Composites::Cache::addRole - too many roles");
+        }
+        role_names.push_back(role_name);
+        role_p4s.push_back(LorentzVector());
+        return role_names.size() - 1;
+    };
+
+    unsigned int getRole(std::string role_name, bool required = true) const
+    {
+        for (unsigned int role_i = 0; role_i < role_names.size(); ++role_i)
+        {
+            if (role_names.at(role_i) == role_name) { return role_i; }
+        }
+        if (required)
+        {
+            throw std::runtime_error("Composites::Cache::getRole - no role named " + role_name);
+        }
+        return role_names.size();
+    };
+
+    /* Declare a candidate as the sum of the given roles; declaring the same one twice (e.g. from
+       two cuts) returns the same index */
+    unsigned int declare(std::string cand_name, std::vector<std::string> cand_role_names)
+    {
+        if (cand_role_names.empty())
+        {
+            throw std::runtime_error("Composites::Cache::declare - " + cand_name + " has no roles");
+        }
+        std::vector<unsigned int> roles;
+        Roles mask = 0;
+        for (auto& role_name : cand_role_names)
+        {
+            unsigned int role_i = addRole(role_name);
+            roles.push_back(role_i);
+            mask |= (Roles(1) << role_i);
+        }
+        for (unsigned int cand_i = 0; cand_i < candidates.size(); ++cand_i)
+        {
+            if (candidates.at(cand_i).name != cand_name) { continue; }
+            if (candidates.at(cand_i).roles != roles)
+            {
+                throw std::runtime_error("Composites::Cache::declare - " + cand_name + " already declared with other roles");
+            }
+            return cand_i;
+        }
+        candidates.push_back({cand_name, roles, mask, false, LorentzVector(), 0.});
+        return candidates.size() - 1;
+    };
+
+    unsigned int getCandidate(std::string cand_name) const
+    {
+        for (unsigned int cand_i = 0; cand_i < candidates.size(); ++cand_i)
+        {
+            if (candidates.at(cand_i).name == cand_name) { return cand_i; }
+        }
+        throw std::runtime_error("Composites::Cache::getCandidate - no candidate named " + cand_name);
+    };
+
+    /* Forget all roles (at the start of each event) */
+    void clear()
+    {
+        set_roles = 0;
+        for (auto& candidate : candidates) { candidate.computed = false; }
+    };
+
+    void setRole(unsigned int role_i, const LorentzVector& p4)
+    {
+        role_p4s.at(role_i) = p4;
+        Roles role_bit = (Roles(1) << role_i);
+        set_roles |= role_bit;
+        for (auto& candidate : candidates)
+        {
+            if (candidate.mask & role_bit) { candidate.computed = false; }
+        }
+    };
+
+    void setRole(std::string role_name, const LorentzVector& p4) { setRole(addRole(role_name), p4); };
+
+    bool hasRole(unsigned int role_i) const { return set_roles & (Roles(1) << role_i); };
+
+    const LorentzVector& role(unsigned int role_i) const
+    {
+        if (!hasRole(role_i))
+        {
+            throw std::runtime_error("Composites::Cache::role - " + role_names.at(role_i) + " is not set");
+        }
+        return role_p4s[role_i];
+    };
+
+    const LorentzVector& role(std::string role_name) const { return role(getRole(role_name)); };
+
+    /* Whether all roles of a candidate are set in this event */
+    bool has(unsigned int cand_i) const { return has(candidates.at(cand_i)); };
+
+    const LorentzVector& p4(unsigned int cand_i) { return get(cand_i).p4; };
+    double M(unsigned int cand_i) { return get(cand_i).p4.M(); };
+    double pt(unsigned int cand_i) { return get(cand_i).p4.pt(); };
+    double eta(unsigned int cand_i) { return get(cand_i).p4.eta(); };
+    double phi(unsigned int cand_i) { return get(cand_i).p4.phi(); };
+
+    /* Scalar sum of the pt of the roles */
+    double ST(unsigned int cand_i) { return get(cand_i).st; };
+};
+
+} // End namespace Composites;
+
+#endif
@@ -9,7 +9,15 @@
 #include "utilities.h"          // Utilities::Variables
 // VBS
 #include "core/collections.h"   // Core::Core::Analysis, Core::Skimmer
-#include "core/pku.h"           // PKU::IDLevel, PKU::passesElecID, PKU::passesMuonID
+#include "core/pku.h"           // PKU::IDLevel, PKU::passesElecID, PKU::passesMuonID, PKU::elecIDMask, PKU::muonIDMask
+#include "core/leptonid.h"      // LeptonID::Mask, LeptonID::evaluate
+#include "core/lhe.h"           // LHE::Cache
+#include "core/sumweights.h"    // SumOfWeights
+#include "core/soa.h"           // SoA::Event
+#include "core/overlap.h"       // Overlap::keepMask, Overlap::fillKeepMask
+#include "core/pairs.h"         // Pairs::findBestPairs
+#include "core/jetcorrections.h" // JetCorrections::Corrector
+#include "core/particlenet.h"   // ParticleNet::Discriminants
 #include "corrections/all.h"    // PileUpSFs, LeptonSFsTTH/PKU, BTagSFs, JetEnergyScales
 // ROOT
 #include "TString.h"
@@ -46,9 +54,15 @@ public:
     Nano& nt;
     HEPCLI& cli;
     Utilities::Variables& globals;
+    SoA::Event& soa;
+    Triggers::Resolver& triggers;
+    VetoMaps::Engine& veto_maps;
+    Composites::Cache& composites;
+    LHE::Cache& lhe;
 
     AnalysisCut(std::string new_name, Core::Analysis& a) 
-    : Cut(new_name), arbol(a.arbol), nt(a.nt), cli(a.cli), globals(a.cutflow.globals)
+    : Cut(new_name), arbol(a.arbol), nt(a.nt), cli(a.cli), globals(a.cutflow.globals), soa(a.soa), 
+      triggers(a.triggers), veto_maps(a.veto_maps), composites(a.composites), lhe(a.lhe)
     {
         // Do nothing
     };
@@ -58,15 +72,23 @@ class Bookkeeping : public AnalysisCut
 {
 public:
     PileUpSFs* pu_sfs;
+    SumOfWeights& sum_of_weights;
 
     Bookkeeping(std::string name, Core::Analysis& analysis, PileUpSFs* pu_sfs = nullptr) 
-    : AnalysisCut(name, analysis) 
+    : AnalysisCut(name, analysis), sum_of_weights(analysis.sum_of_weights)
     {
         this->pu_sfs = pu_sfs;
     };
 
     bool evaluate()
     {
+        // Start a new event; the object collections and the LHE hard process are then read when they
+        // are first used
+        soa.reset(nt);
+        lhe.reset(nt);
+        composites.clear();
+        arbol.setLeaf<int>("run", nt.run());
+        arbol.setLeaf<int>("luminosityBlock", nt.luminosityBlock());
         arbol.setLeaf<int>("event", nt.event());
         arbol.setLeaf<double>("xsec_sf", (nt.isData()) ? 1. : cli.scale_factor*nt.genWeight());
         arbol.setLeaf<double>("prefire_sf", (nt.isData()) ? 1. : nt.L1PreFiringWeight_Nom());
@@ -85,6 +107,9 @@ public:
             arbol.setLeaf<double>("pu_sf_up", 1.);
             arbol.setLeaf<double>("pu_sf_dn", 1.);
         }
+        // The events are also counted, to cross-check the sums of weights of the Runs trees on
+        // unskimmed input
+        if (!nt.isData()) { sum_of_weights.fill(nt, lhe.hasLHE()); }
         return (nt.isData()) ? goodrun(nt.run(), nt.luminosityBlock()) : true;
     };
 
@@ -123,39 +148,36 @@ public:
         return ttH::muonID(muon_i, ttH::IDveto, nt.year());
     };
 
+    virtual LeptonID::Mask getVetoElecMask()
+    {
+        return LeptonID::evaluate(soa.electrons().size(), [&](int elec_i) { return passesVetoElecID(elec_i); });
+    };
+
+    virtual LeptonID::Mask getVetoMuonMask()
+    {
+        return LeptonID::evaluate(soa.muons().size(), [&](int muon_i) { return passesVetoMuonID(muon_i); });
+    };
+
     bool evaluate()
     {
-        LorentzVectors veto_lep_p4s;
-        Integers veto_lep_pdgIDs;
-        Integers veto_lep_idxs;
-        Integers veto_lep_jet_idxs;
-        // Loop over electrons
-        for (unsigned int i = 0; i < nt.nElectron(); ++i)
+        SoA::Leptons& veto_leps = soa.veto_leptons;
+        veto_leps.clear();
+        // Evaluate the IDs of all leptons first
+        LeptonID::Mask veto_elecs = getVetoElecMask();
+        LeptonID::Mask veto_muons = getVetoMuonMask();
+        for (unsigned int i = 0; i < veto_elecs.size(); ++i)
         {
-            if (!passesVetoElecID(i)) { continue; }
-            LorentzVector el_p4 = nt.Electron_p4().at(i);
-            // Store basic info
-            veto_lep_p4s.push_back(el_p4);
-            veto_lep_pdgIDs.push_back(-nt.Electron_charge().at(i)*11);
-            veto_lep_idxs.push_back(i);
-            veto_lep_jet_idxs.push_back(nt.Electron_jetIdx().at(i));
+            if (veto_elecs[i]) { veto_leps.push(soa.electrons(), i); }
         }
-        // Loop over muons
-        for (unsigned int i = 0; i < nt.nMuon(); ++i)
+        for (unsigned int i = 0; i < veto_muons.size(); ++i)
         {
-            if (!passesVetoMuonID(i)) { continue; }
-            LorentzVector mu_p4 = nt.Muon_p4().at(i);
-            // Store basic info
-            veto_lep_p4s.push_back(mu_p4);
-            veto_lep_pdgIDs.push_back(-nt.Muon_charge().at(i)*13);
-            veto_lep_idxs.push_back(i);
-            veto_lep_jet_idxs.push_back(nt.Muon_jetIdx().at(i));
+            if (veto_muons[i]) { veto_leps.push(soa.muons(), i); }
         }
 
-        globals.setVal<LorentzVectors>("veto_lep_p4s", veto_lep_p4s);
-        globals.setVal<Integers>("veto_lep_pdgIDs", veto_lep_pdgIDs);
-        globals.setVal<Integers>("veto_lep_idxs", veto_lep_idxs);
-        globals.setVal<Integers>("veto_lep_jet_idxs", veto_lep_jet_idxs);
+        globals.setVal<SoA::P4Views>("veto_lep_p4s", SoA::P4Views(veto_leps));
+        globals.setVal<Integers>("veto_lep_pdgIDs", veto_leps.pdgIDs);
+        globals.setVal<Integers>("veto_lep_idxs", veto_leps.idxs);
+        globals.setVal<Integers>("veto_lep_jet_idxs", veto_leps.jet_idxs);
 
         return true;
     };
@@ -179,6 +201,16 @@ public:
     {
         return PKU::passesMuonID(muon_i, PKU::IDveto);
     };
+
+    LeptonID::Mask getVetoElecMask()
+    {
+        return PKU::elecIDMask(nt, PKU::IDveto);
+    };
+
+    LeptonID::Mask getVetoMuonMask()
+    {
+        return PKU::muonIDMask(nt, PKU::IDveto);
+    };
 };
 
 class SelectJets : public AnalysisCut
@@ -187,8 +219,8 @@ public:
     JetEnergyScales* jes;
     BTagSFs* btag_sfs;
     PileUpJetIDSFs* puid_sfs;
-    LorentzVectors veto_lep_p4s;
-    Integers veto_lep_jet_idxs;
+    Overlap::Mask lep_keep_mask;
+    JetCorrections::Corrector jet_corrector;
 
     SelectJets(std::string name, Core::Analysis& analysis, JetEnergyScales* jes = nullptr, BTagSFs* btag_sfs = nullptr,
                PileUpJetIDSFs* puid_sfs = nullptr) 
@@ -202,51 +234,62 @@ public:
     virtual bool isGoodJet(int jet_i, LorentzVector jet_p4)
     {
         if (jet_p4.pt() <= 20) { return false; }
-        int jet_id = nt.Jet_jetId().at(jet_i);
+        int jet_id = soa.jets().jet_id[jet_i];
         if (nt.year() == 2016 && jet_id < 1) { return false; }
         if (nt.year() > 2016 && jet_id < 2) { return false; }
         if (jet_p4.pt() < 50)
         {
-            if (nt.Jet_puId().at(jet_i) == 0) { return false; }
+            if (soa.jets().pu_id[jet_i] == 0) { return false; }
         }
         return true;
     };
 
+    /* Called once the corrected jet kinematics are in soa.jets(); computes the overlap masks */
     virtual void loadOverlapVars()
     {
-        veto_lep_p4s = globals.getVal<LorentzVectors>("veto_lep_p4s");
-        veto_lep_jet_idxs = globals.getVal<Integers>("veto_lep_jet_idxs");
+        lep_keep_mask = getLeptonKeepMask();
     };
 
-    bool overlapsLepton(int jet_i, LorentzVector jet_p4)
+    Overlap::Mask getLeptonKeepMask()
     {
-        for (unsigned int lep_i = 0; lep_i < veto_lep_p4s.size(); ++lep_i)
+        const SoA::Jets& jets = soa.jets();
+        const SoA::Leptons& veto_leps = soa.veto_leptons;
+        Overlap::Mask keep(jets.size(), 1);
+        // Leptons matched to a jet remove that jet, unmatched leptons remove jets within dR < 0.4
+        SoA::Leptons unmatched_leps;
+        for (unsigned int lep_i = 0; lep_i < veto_leps.size(); ++lep_i)
         {
-            int lep_jet_idx = veto_lep_jet_idxs.at(lep_i);
+            int lep_jet_idx = veto_leps.jet_idxs[lep_i];
             if (lep_jet_idx == -999)
             {
-                LorentzVector lep_p4 = veto_lep_p4s.at(lep_i);
-                if (ROOT::Math::VectorUtil::DeltaR(lep_p4, jet_p4) < 0.4) 
-                {
-                    return true;
-                }
+                unmatched_leps.push(veto_leps, lep_i);
             }
-            else if (lep_jet_idx == int(jet_i))
+            else if (lep_jet_idx >= 0 && lep_jet_idx < int(keep.size()))
             {
-                return true;
+                keep[lep_jet_idx] = 0;
             }
         }
-        return false;
+        Overlap::fillKeepMask(
+            jets.eta.data(), jets.phi.data(), jets.size(),
+            unmatched_leps.eta.data(), unmatched_leps.phi.data(), unmatched_leps.size(),
+            0.4, keep.data()
+        );
+        return keep;
+    };
+
+    bool overlapsLepton(int jet_i)
+    {
+        return !lep_keep_mask[jet_i];
     };
 
     virtual bool isOverlap(int jet_i, LorentzVector jet_p4)
     {
-        return overlapsLepton(jet_i, jet_p4);
+        return overlapsLepton(jet_i);
     };
 
     bool evaluate()
     {
-        loadOverlapVars();
+        SoA::Jets& jets = soa.jets();
         int n_loose_b_jets = 0;
         int n_medium_b_jets = 0;
         int n_tight_b_jets = 0;
@@ -258,63 +301,29 @@ public:
         double puid_sf_up = 1.;
         double puid_sf_dn = 1.;
         double ht = 0.;
-        LorentzVectors good_jet_p4s;
         Integers good_jet_idxs;
         int jer_seed = (
             1 + (nt.run() << 20) 
             + (nt.luminosityBlock() << 10) 
             + nt.event() 
-            + (nt.nJet() > 0 ? nt.Jet_eta().at(0)/0.01 : 0)
+            + (jets.size() > 0 ? jets.eta[0]/0.01 : 0)
         );
         double met_x = nt.MET_pt()*std::cos(nt.MET_phi());
         double met_y = nt.MET_pt()*std::sin(nt.MET_phi());
-        for (unsigned int jet_i = 0; jet_i < nt.nJet(); ++jet_i)
+        // HEM, JEC and JER in one pass over the jets; MET is propagated for HEM and JEC
+        jet_corrector.correctAK4(jets, nt, veto_maps, jes, jer_seed, met_x, met_y);
+        // Overlap removal runs on the corrected kinematics of all jets at once
+        loadOverlapVars();
+        for (unsigned int jet_i = 0; jet_i < jets.size(); ++jet_i)
         {
-            LorentzVector jet_p4 = nt.Jet_p4().at(jet_i);
-            // Subtract uncorrected jet pt
-            met_x -= jet_p4.px();
-            met_y -= jet_p4.py();
-            // Apply HEM prescription
-            if (!nt.isData()
-                && nt.year() == 2018
-                && nt.event() % 1961 < 1286 
-                && jet_p4.phi() > -1.57 && jet_p4.phi() < -0.87)
-            {
-                double jet_eta = jet_p4.eta();
-                if (jet_eta > -2.5 && jet_eta < -1.3)
-                {
-                    jet_p4 *= 0.8;
-                }
-                else if (jet_eta > -3.0 && jet_eta < -2.5)
-                {
-                    jet_p4 *= 0.65;
-                }
-            }
-            // Apply JECs
-            if (jes != nullptr)
-            {
-                jet_p4 = jes->applyAK4JEC(jet_p4);
-            }
-            // Add corrected jet pt
-            met_x += jet_p4.px();
-            met_y += jet_p4.py();
-            // Apply JERs
-            if (!nt.isData() && jes != nullptr)
-            {
-                jet_p4 = jes->applyJER(
-                    jer_seed, 
-                    jet_p4, 
-                    nt.fixedGridRhoFastjetAll(), 
-                    nt.GenJet_p4()
-                );
-            }
+            LorentzVector jet_p4 = jets.p4(jet_i);
             // Select good jets
             if (!isGoodJet(jet_i, jet_p4)) { continue; }
             if (isOverlap(jet_i, jet_p4)) { continue; }
             // Apply PU jet ID scale factors
             double jet_pt = jet_p4.pt();
             double jet_eta = jet_p4.eta();
-            if (!nt.isData() && puid_sfs != nullptr && jet_pt < 50 && nt.Jet_puId().at(jet_i) > 0)
+            if (!nt.isData() && puid_sfs != nullptr && jet_pt < 50 && jets.pu_id[jet_i] > 0)
             {
                 for (auto genjet_p4 : nt.GenJet_p4())
                 {
@@ -331,7 +340,7 @@ public:
             if (fabs(jet_p4.eta()) < 2.4 && jet_p4.pt() > 20) 
             {
                 // Check DeepJet vs. working points in NanoCORE global config (gconf)
-                double deepflav_btag = nt.Jet_btagDeepFlavB().at(jet_i);
+                double deepflav_btag = jets.btag_deepflav[jet_i];
                 if (deepflav_btag > gconf.WP_DeepFlav_tight) 
                 {
                     n_tight_b_jets++;
@@ -345,7 +354,7 @@ public:
                     // Apply DeepJet b-tagging scale factor (for a VETO using the medium WP)
                     if (!nt.isData() && btag_sfs != nullptr)
                     {
-                        int flavor = nt.Jet_hadronFlavour().at(jet_i);
+                        int flavor = jets.hadron_flavour[jet_i];
                         double jet_abseta = fabs(jet_eta);
                         double sf = btag_sfs->getSF(flavor, jet_pt, jet_abseta);
                         double sf_up = btag_sfs->getSFUp(flavor, jet_pt, jet_abseta);
@@ -364,7 +373,6 @@ public:
             // Save additional jet info
             n_jets++;
             ht += jet_p4.pt();
-            good_jet_p4s.push_back(jet_p4);
             good_jet_idxs.push_back(jet_i);
         }
         double met = std::sqrt(std::pow(met_x, 2) + std::pow(met_y, 2));
@@ -380,8 +388,9 @@ public:
         arbol.setLeaf<double>("MET_up", met_up);
         arbol.setLeaf<double>("MET_dn", met_dn);
 
-        globals.setVal<LorentzVectors>("good_jet_p4s", good_jet_p4s);
+        globals.setVal<SoA::P4Views>("good_jet_p4s", SoA::P4Views(jets, good_jet_idxs));
         globals.setVal<Integers>("good_jet_idxs", good_jet_idxs);
+        jets.good_idxs = good_jet_idxs;
 
         arbol.setLeaf<double>("HT", ht);
         arbol.setLeaf<int>("n_loose_b_jets", n_loose_b_jets);
@@ -420,6 +429,7 @@ class SelectFatJets : public AnalysisCut
 {
 public:
     JetEnergyScales* jes;
+    JetCorrections::Corrector jet_corrector;
 
     SelectFatJets(std::string name, Core::Analysis& analysis, JetEnergyScales* jes = nullptr) 
     : AnalysisCut(name, analysis) 
@@ -432,14 +442,13 @@ public:
         if (fatjet_p4.pt() <= 300) { return false; }
         if (fabs(fatjet_p4.eta()) >= 2.5) { return false; }
         if (fatjet_p4.mass() <= 50) { return false; }
-        if (nt.FatJet_msoftdrop().at(fatjet_i) <= 40) { return false; }
-        if (nt.FatJet_jetId().at(fatjet_i) <= 0) { return false; }
+        if (soa.fatjets().msoftdrop[fatjet_i] <= 40) { return false; }
+        if (soa.fatjets().jet_id[fatjet_i] <= 0) { return false; }
         return true;
     };
 
     bool evaluate()
     {
-        LorentzVectors good_fatjet_p4s;
         Integers good_fatjet_idxs;
         Doubles good_fatjet_wqqtags;
         Doubles good_fatjet_zqqtags;
@@ -452,68 +461,39 @@ public:
         Doubles good_fatjet_masses;
         Doubles good_fatjet_msoftdrops;
         double ht = 0.;
-        LorentzVectors veto_lep_p4s = globals.getVal<LorentzVectors>("veto_lep_p4s");
-        for (unsigned int fatjet_i = 0; fatjet_i < nt.nFatJet(); ++fatjet_i)
+        SoA::FatJets& fatjets = soa.fatjets();
+        // HEM and JEC in one pass over the fat jets
+        jet_corrector.correctAK8(fatjets, nt, veto_maps, jes);
+        // Lepton overlap (dR < 0.8) on the corrected kinematics of all fat jets at once
+        Overlap::Mask lep_keep_mask = Overlap::keepMask(fatjets, soa.veto_leptons, 0.8);
+        // ParticleNet discriminants of all fat jets at once
+        ParticleNet::Discriminants pnet;
+        pnet.fill(fatjets);
+        for (unsigned int fatjet_i = 0; fatjet_i < fatjets.size(); ++fatjet_i)
         {
-            LorentzVector fatjet_p4 = nt.FatJet_p4().at(fatjet_i);
-            // Apply HEM prescription
-            if (!nt.isData()
-                && nt.year() == 2018
-                && nt.event() % 1961 < 1286 
-                && fatjet_p4.phi() > -1.57 && fatjet_p4.phi() < -0.87)
-            {
-                double fatjet_eta = fatjet_p4.eta();
-                if (fatjet_eta > -2.5 && fatjet_eta < -1.3)
-                {
-                    fatjet_p4 *= 0.8;
-                }
-                else if (fatjet_eta > -3.0 && fatjet_eta < -2.5)
-                {
-                    fatjet_p4 *= 0.65;
-                }
-            }
-            // Apply jet energy corrections
-            if (jes != nullptr)
-            {
-                fatjet_p4 = jes->applyAK8JEC(fatjet_p4);
-            }
+            LorentzVector fatjet_p4 = fatjets.p4(fatjet_i);
 
             // Basic requirements
             if (!isGoodFatJet(fatjet_i, fatjet_p4)) { continue; }
 
             // Remove lepton overlap
-            bool is_overlap = false;
-            for (auto& lep_p4 : veto_lep_p4s)
-            {
-                if (ROOT::Math::VectorUtil::DeltaR(lep_p4, fatjet_p4) < 0.8) 
-                {
-                    is_overlap = true;
-                    break;
-                }
-            }
-            if (is_overlap) { continue; }
-
-            double pnet_xbb = nt.FatJet_particleNetMD_Xbb().at(fatjet_i);
-            double pnet_xqq = nt.FatJet_particleNetMD_Xqq().at(fatjet_i);
-            double pnet_xcc = nt.FatJet_particleNetMD_Xcc().at(fatjet_i);
-            double pnet_qcd = nt.FatJet_particleNetMD_QCD().at(fatjet_i);
+            if (!lep_keep_mask[fatjet_i]) { continue; }
 
             // Store good fat jets
-            good_fatjet_p4s.push_back(fatjet_p4);
             good_fatjet_idxs.push_back(fatjet_i);
-            good_fatjet_wqqtags.push_back(nt.FatJet_particleNet_WvsQCD().at(fatjet_i));
-            good_fatjet_zqqtags.push_back(nt.FatJet_particleNet_ZvsQCD().at(fatjet_i));
-            good_fatjet_hbbtags.push_back(nt.FatJet_particleNet_HbbvsQCD().at(fatjet_i));
-            good_fatjet_xbbtags.push_back(pnet_xbb/(pnet_xbb + pnet_qcd));
-            good_fatjet_xqqtags.push_back(pnet_xqq/(pnet_xqq + pnet_qcd));
-            good_fatjet_xcctags.push_back(pnet_xcc/(pnet_xcc + pnet_qcd));
-            good_fatjet_xwqqtags.push_back((pnet_xcc + pnet_xqq)/(pnet_xcc + pnet_xqq + pnet_qcd));
-            good_fatjet_xvqqtags.push_back((pnet_xbb + pnet_xcc + pnet_xqq)/(pnet_xbb + pnet_xcc + pnet_xqq + pnet_qcd));
-            good_fatjet_masses.push_back(nt.FatJet_particleNet_mass().at(fatjet_i));
-            good_fatjet_msoftdrops.push_back(nt.FatJet_msoftdrop().at(fatjet_i));
+            good_fatjet_wqqtags.push_back(fatjets.pnet_wvsqcd[fatjet_i]);
+            good_fatjet_zqqtags.push_back(fatjets.pnet_zvsqcd[fatjet_i]);
+            good_fatjet_hbbtags.push_back(fatjets.pnet_hbbvsqcd[fatjet_i]);
+            good_fatjet_xbbtags.push_back(pnet.xbb[fatjet_i]);
+            good_fatjet_xqqtags.push_back(pnet.xqq[fatjet_i]);
+            good_fatjet_xcctags.push_back(pnet.xcc[fatjet_i]);
+            good_fatjet_xwqqtags.push_back(pnet.xwqq[fatjet_i]);
+            good_fatjet_xvqqtags.push_back(pnet.xvqq[fatjet_i]);
+            good_fatjet_masses.push_back(fatjets.pnet_mass[fatjet_i]);
+            good_fatjet_msoftdrops.push_back(fatjets.msoftdrop[fatjet_i]);
             ht += fatjet_p4.pt();
         }
-        globals.setVal<LorentzVectors>("good_fatjet_p4s", good_fatjet_p4s);
+        globals.setVal<SoA::P4Views>("good_fatjet_p4s", SoA::P4Views(fatjets, good_fatjet_idxs));
         globals.setVal<Integers>("good_fatjet_idxs", good_fatjet_idxs);
         globals.setVal<Doubles>("good_fatjet_wqqtags", good_fatjet_wqqtags);
         globals.setVal<Doubles>("good_fatjet_zqqtags", good_fatjet_zqqtags);
@@ -525,73 +505,109 @@ public:
         globals.setVal<Doubles>("good_fatjet_xvqqtags", good_fatjet_xvqqtags);
         globals.setVal<Doubles>("good_fatjet_masses", good_fatjet_masses);
         globals.setVal<Doubles>("good_fatjet_msoftdrops", good_fatjet_msoftdrops);
+        fatjets.good_idxs = good_fatjet_idxs;
 
-        arbol.setLeaf<int>("n_fatjets", good_fatjet_p4s.size());
+        arbol.setLeaf<int>("n_fatjets", good_fatjet_idxs.size());
         arbol.setLeaf<double>("HT_fat", ht);
 
         return true;
     };
 };
 
-class SelectVBSJets : public AnalysisCut
+/* Event-level veto: fails events with a jet in a region vetoed by any Veto map in the engine
+   (e.g. the JME jet veto maps); must come after SelectJets, which corrects the jet kinematics
+*/
+class PassesVetoMaps : public AnalysisCut
 {
 public:
-    SelectVBSJets(std::string name, Core::Analysis& analysis) : AnalysisCut(name, analysis) 
+    PassesVetoMaps(std::string name, Core::Analysis& analysis) : AnalysisCut(name, analysis) 
     {
         // Do nothing
     };
 
+    /* Jets considered for the veto (JME recommendation: pt > 15 GeV with tight ID) */
+    virtual bool isVetoMapJet(int jet_i)
+    {
+        return (soa.jets().pt[jet_i] > 15 && soa.jets().jet_id[jet_i] >= 2);
+    };
+
+    bool evaluate()
+    {
+        const SoA::Jets& jets = soa.jets();
+        SoA::Ints veto_map_jet_idxs;
+        for (unsigned int jet_i = 0; jet_i < jets.size(); ++jet_i)
+        {
+            if (isVetoMapJet(jet_i)) { veto_map_jet_idxs.push_back(jet_i); }
+        }
+        return !veto_maps.anyVetoed(jets, veto_map_jet_idxs, nt);
+    };
+};
+
+class SelectVBSJets : public AnalysisCut
+{
+public:
+    Pairs::Preselection vbsjet_presel;
+    unsigned int ld_vbsjet_role;
+    unsigned int tr_vbsjet_role;
+    unsigned int vbs_jj;
+
+    SelectVBSJets(std::string name, Core::Analysis& analysis, 
+                  Pairs::Preselection vbsjet_presel = Pairs::Preselection(30., 4.7)) 
+    : AnalysisCut(name, analysis) 
+    {
+        this->vbsjet_presel = vbsjet_presel;
+        ld_vbsjet_role = composites.addRole("ld_vbsjet");
+        tr_vbsjet_role = composites.addRole("tr_vbsjet");
+        vbs_jj = composites.declare("vbs_jj", {"ld_vbsjet", "tr_vbsjet"});
+    };
+
     virtual std::vector<unsigned int> getVBSCandidates()
     {
-        LorentzVectors good_jet_p4s = globals.getVal<LorentzVectors>("good_jet_p4s");
+        const SoA::Jets& jets = soa.jets();
         std::vector<unsigned int> vbsjet_cand_idxs;
         // getting the vqq globals to use it to skip vqq jets candidates
         int ld_vqqjet_idx = globals.getVal<int>("ld_vqqjet_idx");
         int tr_vqqjet_idx = globals.getVal<int>("tr_vqqjet_idx");
-        for (unsigned int jet_i = 0; jet_i < good_jet_p4s.size(); ++jet_i)
+        for (unsigned int jet_i = 0; jet_i < jets.good_idxs.size(); ++jet_i)
         {
-
-            LorentzVector jet_p4 = good_jet_p4s.at(jet_i);
             // Skip Vqq jets candidates
-            if (jet_i == ld_vqqjet_idx || jet_i == tr_vqqjet_idx) { continue; }
-            
-            if (jet_p4.pt() >= 30. && fabs(jet_p4.eta()) < 4.7) 
+            if (int(jet_i) == ld_vqqjet_idx || int(jet_i) == tr_vqqjet_idx) { continue; }
+            int nano_jet_i = jets.good_idxs[jet_i];
+            if (vbsjet_presel.passes(jets.pt[nano_jet_i], jets.eta[nano_jet_i]))
             {
                 vbsjet_cand_idxs.push_back(jet_i); 
             }
-
-            
         }
         return vbsjet_cand_idxs;
     };
 
+    /* Run the pair search over the given candidates (idxs in the good jet collection) */
+    Pairs::Result findVBSPairs(const std::vector<unsigned int>& vbsjet_cand_idxs)
+    {
+        SoA::Ints nano_jet_idxs;
+        nano_jet_idxs.reserve(vbsjet_cand_idxs.size());
+        for (auto& jet_i : vbsjet_cand_idxs) { nano_jet_idxs.push_back(soa.jets().good_idxs.at(jet_i)); }
+        Pairs::Preselection pair_presel;
+        pair_presel.opposite_hemispheres = vbsjet_presel.opposite_hemispheres;
+        return Pairs::findBestPairs(soa.jets(), nano_jet_idxs, pair_presel);
+    };
+
+    std::pair<unsigned int, unsigned int> toVBSPair(const std::vector<unsigned int>& vbsjet_cand_idxs, 
+                                                    const Pairs::Pair& best)
+    {
+        if (!best.isValid()) { return std::make_pair(0, 0); }
+        return std::make_pair(vbsjet_cand_idxs.at(best.first), vbsjet_cand_idxs.at(best.second));
+    };
+
     virtual std::pair<unsigned int, unsigned int> getVBSPair(std::vector<unsigned int> vbsjet_cand_idxs)
     {
-        LorentzVectors good_jet_p4s = globals.getVal<LorentzVectors>("good_jet_p4s");
-        double max_detajj = -999;
-        std::pair<unsigned int, unsigned int> vbsjet_idxs;
-        for (unsigned int _jet_i = 0; _jet_i < vbsjet_cand_idxs.size(); ++_jet_i)
-        {
-            unsigned int jet_i = vbsjet_cand_idxs.at(_jet_i);
-            for (unsigned int _jet_j = _jet_i + 1; _jet_j < vbsjet_cand_idxs.size(); ++_jet_j)
-            {
-                unsigned int jet_j = vbsjet_cand_idxs.at(_jet_j);
-                LorentzVector jet1_p4 = good_jet_p4s.at(jet_i);
-                LorentzVector jet2_p4 = good_jet_p4s.at(jet_j);
-                double detajj = fabs(jet1_p4.eta() - jet2_p4.eta());
-                if (detajj > max_detajj)
-                {
-                    max_detajj = detajj;
-                    vbsjet_idxs = std::make_pair(jet_i, jet_j);
-                }
-            }
-        }
-        return vbsjet_idxs;
+        Pairs::Result pairs = findVBSPairs(vbsjet_cand_idxs);
+        return toVBSPair(vbsjet_cand_idxs, pairs.best[Pairs::MaxDEta]);
     };
 
     bool evaluate()
     {
-        LorentzVectors good_jet_p4s = globals.getVal<LorentzVectors>("good_jet_p4s");
+        SoA::P4Views good_jet_p4s = globals.getVal<SoA::P4Views>("good_jet_p4s");
 
         // Get VBS jet candidates
         std::vector<unsigned int> vbsjet_cand_idxs = getVBSCandidates();
@@ -617,6 +633,8 @@ public:
         LorentzVector tr_vbsjet_p4 = good_jet_p4s.at(tr_vbsjet_idx);
 
         // Save VBS jet globals
+        composites.setRole(ld_vbsjet_role, ld_vbsjet_p4);
+        composites.setRole(tr_vbsjet_role, tr_vbsjet_p4);
         globals.setVal<LorentzVector>("ld_vbsjet_p4", ld_vbsjet_p4);
         globals.setVal<int>("ld_vbsjet_idx", ld_vbsjet_idx);
         globals.setVal<LorentzVector>("tr_vbsjet_p4", tr_vbsjet_p4);
@@ -628,10 +646,10 @@ public:
         arbol.setLeaf<double>("tr_vbsjet_eta", tr_vbsjet_p4.eta());
         arbol.setLeaf<double>("ld_vbsjet_phi", ld_vbsjet_p4.phi());
         arbol.setLeaf<double>("tr_vbsjet_phi", tr_vbsjet_p4.phi());
-        arbol.setLeaf<double>("M_jj", (ld_vbsjet_p4 + tr_vbsjet_p4).M());
-        arbol.setLeaf<double>("pt_jj", (ld_vbsjet_p4 + tr_vbsjet_p4).pt());
-        arbol.setLeaf<double>("eta_jj", (ld_vbsjet_p4 + tr_vbsjet_p4).eta());
-        arbol.setLeaf<double>("phi_jj", (ld_vbsjet_p4 + tr_vbsjet_p4).phi());
+        arbol.setLeaf<double>("M_jj", composites.M(vbs_jj));
+        arbol.setLeaf<double>("pt_jj", composites.pt(vbs_jj));
+        arbol.setLeaf<double>("eta_jj", composites.eta(vbs_jj));
+        arbol.setLeaf<double>("phi_jj", composites.phi(vbs_jj));
         arbol.setLeaf<double>("deta_jj", ld_vbsjet_p4.eta() - tr_vbsjet_p4.eta());
         arbol.setLeaf<double>("abs_deta_jj", fabs(ld_vbsjet_p4.eta() - tr_vbsjet_p4.eta()));
         arbol.setLeaf<double>("dR_jj", ROOT::Math::VectorUtil::DeltaR(ld_vbsjet_p4, tr_vbsjet_p4));
@@ -643,102 +661,49 @@ public:
 class SelectVBSJetsMaxMjj : public SelectVBSJets
 {
 public:
-    SelectVBSJetsMaxMjj(std::string name, Core::Analysis& analysis) : SelectVBSJets(name, analysis) 
+    SelectVBSJetsMaxMjj(std::string name, Core::Analysis& analysis, 
+                        Pairs::Preselection vbsjet_presel = Pairs::Preselection(30., 4.7)) 
+    : SelectVBSJets(name, analysis, vbsjet_presel) 
     {
         // Do nothing
     };
 
     std::pair<unsigned int, unsigned int> getVBSPair(std::vector<unsigned int> vbsjet_cand_idxs)
     {
-        LorentzVectors good_jet_p4s = globals.getVal<LorentzVectors>("good_jet_p4s");
-        double max_Mjj = -999;
-        std::pair<unsigned int, unsigned int> vbsjet_idxs;
-        for (unsigned int _jet_i = 0; _jet_i < vbsjet_cand_idxs.size(); ++_jet_i)
-        {
-            unsigned int jet_i = vbsjet_cand_idxs.at(_jet_i);
-            for (unsigned int _jet_j = _jet_i + 1; _jet_j < vbsjet_cand_idxs.size(); ++_jet_j)
-            {
-                unsigned int jet_j = vbsjet_cand_idxs.at(_jet_j);
-                LorentzVector jet1_p4 = good_jet_p4s.at(jet_i);
-                LorentzVector jet2_p4 = good_jet_p4s.at(jet_j);
-                double Mjj = (jet1_p4 + jet2_p4).M();
-                if (Mjj > max_Mjj)
-                {
-                    max_Mjj = Mjj;
-                    vbsjet_idxs = std::make_pair(jet_i, jet_j);
-                }
-            }
-        }
-        return vbsjet_idxs;
+        Pairs::Result pairs = findVBSPairs(vbsjet_cand_idxs);
+        return toVBSPair(vbsjet_cand_idxs, pairs.best[Pairs::MaxMjj]);
     };
 };
 
 class SelectVBSJetsMaxE : public SelectVBSJets
 {
 public:
-    SelectVBSJetsMaxE(std::string name, Core::Analysis& analysis) : SelectVBSJets(name, analysis) 
+    SelectVBSJetsMaxE(std::string name, Core::Analysis& analysis, 
+                      Pairs::Preselection vbsjet_presel = Pairs::Preselection(30., 4.7)) 
+    : SelectVBSJets(name, analysis, vbsjet_presel) 
     {
         // Do nothing
     };
 
     std::pair<unsigned int, unsigned int> getVBSPair(std::vector<unsigned int> vbsjet_cand_idxs)
     {
-        LorentzVectors good_jet_p4s = globals.getVal<LorentzVectors>("good_jet_p4s");
-        // Sort candidates by pt
-        std::sort(
-            vbsjet_cand_idxs.begin(), vbsjet_cand_idxs.end(),
-            [&](int i, int j) -> bool { return good_jet_p4s.at(i).pt() > good_jet_p4s.at(j).pt(); }
-        );
-        // Process candidates
-        std::pair<unsigned int, unsigned int> vbsjet_idxs;
         if (vbsjet_cand_idxs.size() == 2)
         {
-            vbsjet_idxs = std::make_pair(vbsjet_cand_idxs.at(0), vbsjet_cand_idxs.at(1));
+            return std::make_pair(vbsjet_cand_idxs.at(0), vbsjet_cand_idxs.at(1));
+        }
+        /* Take the leading candidate (in P) from each eta hemisphere, i.e. the opposite-hemisphere
+           pair with the largest P_1 + P_2; if all candidates are in one hemisphere, take the two
+           leading candidates (in P) instead
+        */
+        Pairs::Result pairs = findVBSPairs(vbsjet_cand_idxs);
+        if (pairs.best_opposite[Pairs::MaxSumP].isValid())
+        {
+            return toVBSPair(vbsjet_cand_idxs, pairs.best_opposite[Pairs::MaxSumP]);
         }
         else
         {
-            // Collect jets in pos/neg eta hemispheres
-            Integers vbs_pos_eta_jet_idxs;
-            Integers vbs_neg_eta_jet_idxs;
-            for (auto& jet_i : vbsjet_cand_idxs)
-            {
-                const LorentzVector& jet_p4 = good_jet_p4s.at(jet_i);
-                if (jet_p4.eta() >= 0)
-                {
-                    vbs_pos_eta_jet_idxs.push_back(jet_i);
-                }
-                else
-                {
-                    vbs_neg_eta_jet_idxs.push_back(jet_i);
-                }
-            }
-            // Sort the jets in each hemisphere by P
-            std::sort(
-                vbs_pos_eta_jet_idxs.begin(), vbs_pos_eta_jet_idxs.end(),
-                [&](int i, int j) -> bool { return good_jet_p4s.at(i).P() > good_jet_p4s.at(j).P(); }
-            );
-            std::sort(
-                vbs_neg_eta_jet_idxs.begin(), vbs_neg_eta_jet_idxs.end(),
-                [&](int i, int j) -> bool { return good_jet_p4s.at(i).P() > good_jet_p4s.at(j).P(); }
-            );
-            // Select VBS jets
-            if (vbs_pos_eta_jet_idxs.size() == 0)
-            {
-                // All candidates are in the -eta hemisphere
-                vbsjet_idxs = std::make_pair(vbs_neg_eta_jet_idxs.at(0), vbs_neg_eta_jet_idxs.at(1));
-            }
-            else if (vbs_neg_eta_jet_idxs.size() == 0)
-            {
-                // All candidates are in the +eta hemisphere
-                vbsjet_idxs = std::make_pair(vbs_pos_eta_jet_idxs.at(0), vbs_pos_eta_jet_idxs.at(1));
-            }
-            else
-            {
-                // Take the leading candidate (in P) from each hemisphere
-                vbsjet_idxs = std::make_pair(vbs_pos_eta_jet_idxs.at(0), vbs_neg_eta_jet_idxs.at(0));
-            }
+            return toVBSPair(vbsjet_cand_idxs, pairs.best[Pairs::MaxSumP]);
         }
-        return vbsjet_idxs;
     };
 };
 
@@ -752,11 +717,8 @@ public:
 
     bool evaluate()
     {
-        if (nt.isData()) { return true; }
-
-        // Hard-coded blacklist for NanoAOD known to _not_ have LHE branches
-        TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
-        if (file_name.Contains("QCD_Pt")) { return true; }
+        // Data and some NanoAOD (e.g. QCD_Pt) have no LHE branches
+        if (nt.isData() || !lhe.hasLHE()) { return true; }
 
         /* From Events->GetListOfBranches()->ls("LHEScaleWeight*"):
            OBJ: TBranch   LHEScaleWeight  LHE scale variation weights (w_var / w_nominal); 
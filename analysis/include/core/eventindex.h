@@ -0,0 +1,306 @@
+#ifndef CORE_EVENTINDEX_H
+#define CORE_EVENTINDEX_H
+
+// STL
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+// VBS
+#include "core/output.h"        // Output::popOption
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TString.h"
+
+/* Skims as event-index sidecars: instead of a copy of every branch of the passing events, the skim
+   writes the (file, entry) of each passing event into a small TTree, EventIndex, along with a few
+   derived columns booked by the skim, next to the merged Runs and LuminosityBlocks trees as usual.
+   The files are numbered in the order they are skimmed, and their names are stored once each, in
+   the TTree EventIndexFiles, so that EventIndex only holds a file number and an entry per event.
+   Every input file also gets an entry of its own in EventIndex, with entry = -1, so that files
+   without any passing events are still visited (and their Runs counted) when the sidecar is read
+   back. Both trees are written to the output file as they fill up, with the compression of the
+   skim, so memory does not grow with the number of passing events. Chosen on the command line of
+   the skim:
+
+       ./bin/skim_vbsvvhjets --skim_format=index ...
+
+       copy     (default) a copy of the kept branches of the passing events, as before
+       fast     the same copy, but input files whose events all pass are fast-cloned (see Core::Skimmer)
+       index    the sidecar described above
+
+   Sidecars can be hadded like any other skim: file numbers start from 0 in each sidecar, and hadd
+   appends the two trees of each sidecar in the same order, so the entry of a file number 0 marks
+   the start of the files of the next sidecar in EventIndexFiles (see Reader::add).
+
+   Core::Skimmer does the rest (see core/collections.h): it fills the index instead of the Arbusto
+   and writes it to the output file of the Arbusto. Derived columns are booked and set through it:
+
+       skimmer.index.newColumn<double>("ht_ak8", -999);
+       ...
+       skimmer.index.setColumn<double>("ht_ak8", ht);   // before skimmer.fill(entry)
+
+   A sidecar is read back by Input::Looper (see core/input.h), which visits the original files at
+   the indexed entries only, in the order of a Reader::plan, so studies take sidecars as input
+   without any changes. The derived columns are meant for a quick re-skim with a tighter cut
+   (see studies/reindex), or for a look with uproot.
+*/
+namespace EventIndex
+{
+
+enum SkimFormat
+{
+    CopySkim,
+    FastSkim,
+    IndexSkim
+};
+
+/* Remove --skim_format=X or --skim_format X from the command line and return it */
+inline SkimFormat popSkimFormat(int& argc, char** argv)
+{
+    std::string format_name = Output::popOption(argc, argv, "--skim_format", "copy");
+    if (format_name == "copy") { return CopySkim; }
+    if (format_name == "fast") { return FastSkim; }
+    if (format_name == "index") { return IndexSkim; }
+    throw std::runtime_error("EventIndex::popSkimFormat - unknown skim format " + format_name + " (copy, fast, index)");
+};
+
+/* Whether the file is a sidecar written by EventIndex::Writer */
+inline bool isEventIndex(TFile* tfile)
+{
+    return (tfile->GetKey("EventIndex") != nullptr);
+};
+
+class Writer
+{
+private:
+    TTree* index;
+    TTree* files;
+    std::string file_name;
+    Int_t file_i;
+    Long64_t entry;
+    std::map<std::string, std::shared_ptr<void>> columns;
+    std::vector<std::function<void()>> resets;
+
+public:
+    Writer()
+    {
+        file_i = -1;
+        entry = -1;
+        // Kept in memory (and never filled) unless attached to an output file
+        index = new TTree("EventIndex", "EventIndex");
+        index->SetDirectory(0);
+        index->Branch("file_i", &file_i);
+        index->Branch("entry", &entry);
+        files = new TTree("EventIndexFiles", "EventIndexFiles");
+        files->SetDirectory(0);
+        files->Branch("file", &file_name);
+    };
+
+    /* Write the index to the given file as it fills up, with the given compression (see core/output.h);
+       the file then owns the trees */
+    void attach(TFile* tfile, int compression)
+    {
+        index->SetDirectory(tfile);
+        files->SetDirectory(tfile);
+        Output::setCompression(tfile, index, compression);
+        Output::setCompression(tfile, files, compression);
+    };
+
+    template<typename Type>
+    void newColumn(std::string name, Type default_value)
+    {
+        if (columns.count(name) == 1)
+        {
+            throw std::runtime_error("EventIndex::Writer::newColumn - column " + name + " already exists");
+        }
+        std::shared_ptr<Type> value = std::make_shared<Type>(default_value);
+        columns[name] = value;
+        resets.push_back([value, default_value]() { *value = default_value; });
+        index->Branch(name.c_str(), value.get());
+    };
+
+    template<typename Type>
+    void setColumn(std::string name, Type new_value)
+    {
+        if (columns.count(name) == 0)
+        {
+            throw std::runtime_error("EventIndex::Writer::setColumn - no column named " + name);
+        }
+        *static_cast<Type*>(columns[name].get()) = new_value;
+    };
+
+    /* Start indexing the entries of another input file */
+    void newFile(TTree* ttree)
+    {
+        file_name = ttree->GetCurrentFile()->GetName();
+        files->Fill();
+        file_i++;
+        entry = -1;
+        index->Fill();
+    };
+
+    /* Index the given entry of the current file, with the current values of the columns */
+    void fill(Long64_t new_entry)
+    {
+        entry = new_entry;
+        index->Fill();
+        for (auto& reset : resets) { reset(); }
+    };
+
+    void write(TFile* tfile)
+    {
+        tfile->cd();
+        index->Write("", TObject::kOverwrite);
+        files->Write("", TObject::kOverwrite);
+    };
+};
+
+/* Entries of one cluster of an input file, to be read in a row */
+struct Cluster
+{
+    Long64_t start;
+    Long64_t end;
+    std::vector<Long64_t> entries;
+};
+
+/* Entries of one input file, sorted and without duplicates (possibly none) */
+struct FileEntries
+{
+    std::string name;
+    std::vector<Long64_t> entries;
+};
+
+class Reader
+{
+public:
+    std::vector<FileEntries> files;
+
+    Reader()
+    {
+        // Do nothing
+    };
+
+    /* Add the entries indexed by a sidecar; entries of the same file in several sidecars are merged */
+    void add(TFile* tfile)
+    {
+        TTree* index = (TTree*) tfile->Get("EventIndex");
+        TTree* file_table = (TTree*) tfile->Get("EventIndexFiles");
+        if (index == nullptr || file_table == nullptr)
+        {
+            throw std::runtime_error(
+                "EventIndex::Reader::add - " + std::string(tfile->GetName()) + " is not an event index"
+            );
+        }
+        std::vector<std::string> file_names;
+        std::string* file_name = nullptr;
+        file_table->SetBranchAddress("file", &file_name);
+        for (Long64_t table_i = 0; table_i < file_table->GetEntries(); ++table_i)
+        {
+            file_table->GetEntry(table_i);
+            file_names.push_back(*file_name);
+        }
+        file_table->ResetBranchAddresses();
+        delete file_name;
+
+        std::map<std::string, unsigned int> file_positions;
+        for (unsigned int file_i = 0; file_i < files.size(); ++file_i)
+        {
+            file_positions[files.at(file_i).name] = file_i;
+        }
+        // Only the two index branches are read
+        Int_t file_i;
+        Long64_t entry;
+        index->SetBranchStatus("*", 0);
+        index->SetBranchStatus("file_i", 1);
+        index->SetBranchStatus("entry", 1);
+        index->SetBranchAddress("file_i", &file_i);
+        index->SetBranchAddress("entry", &entry);
+        // File numbers restart from 0 for each sidecar that was hadded into this one
+        unsigned int table_start = 0;
+        unsigned int n_section_files = 0;
+        auto position = file_positions.end();
+        for (Long64_t index_i = 0; index_i < index->GetEntries(); ++index_i)
+        {
+            index->GetEntry(index_i);
+            if (entry < 0 && file_i == 0 && n_section_files > 0)
+            {
+                table_start += n_section_files;
+                n_section_files = 0;
+            }
+            if (entry < 0) { n_section_files++; }
+            unsigned int table_i = table_start + file_i;
+            if (file_i < 0 || file_i >= (Int_t) n_section_files || table_i >= file_names.size())
+            {
+                throw std::runtime_error(
+                    "EventIndex::Reader::add - entry " + std::to_string(index_i) + " of " + tfile->GetName()
+                    + " has no file in EventIndexFiles"
+                );
+            }
+            const std::string& name = file_names.at(table_i);
+            if (position == file_positions.end() || files.at(position->second).name != name)
+            {
+                position = file_positions.find(name);
+                if (position == file_positions.end())
+                {
+                    position = file_positions.emplace(name, files.size()).first;
+                    files.push_back({name, {}});
+                }
+            }
+            if (entry >= 0) { files.at(position->second).entries.push_back(entry); }
+        }
+        index->ResetBranchAddresses();
+        for (auto& file : files)
+        {
+            std::sort(file.entries.begin(), file.entries.end());
+            file.entries.erase(std::unique(file.entries.begin(), file.entries.end()), file.entries.end());
+        }
+    };
+
+    Long64_t size()
+    {
+        Long64_t n_entries = 0;
+        for (auto& file : files) { n_entries += file.entries.size(); }
+        return n_entries;
+    };
+
+    /* Group sorted entries by the clusters of the TTree they come from; clusters without any of the
+       entries are left out, so their baskets are never read */
+    static std::vector<Cluster> plan(TTree* ttree, const std::vector<Long64_t>& entries)
+    {
+        std::vector<Cluster> clusters;
+        if (entries.empty()) { return clusters; }
+        if (entries.back() >= ttree->GetEntries())
+        {
+            throw std::runtime_error(
+                "EventIndex::Reader::plan - entry " + std::to_string(entries.back()) + " is beyond the end of "
+                + ttree->GetCurrentFile()->GetName()
+            );
+        }
+        TTree::TClusterIterator cluster_iter = ttree->GetClusterIterator(entries.front());
+        Long64_t start = cluster_iter();
+        Long64_t end = cluster_iter.GetNextEntry();
+        for (Long64_t entry : entries)
+        {
+            while (entry >= end)
+            {
+                start = cluster_iter();
+                end = cluster_iter.GetNextEntry();
+            }
+            if (clusters.empty() || clusters.back().start != start)
+            {
+                clusters.push_back({start, end, {}});
+            }
+            clusters.back().entries.push_back(entry);
+        }
+        return clusters;
+    };
+};
+
+} // End namespace EventIndex;
+
+#endif
@@ -0,0 +1,274 @@
+#ifndef CORE_FASTMATH_H
+#define CORE_FASTMATH_H
+
+// STL
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/* Branch-free exp, sinh, cosh, sin/cos and atan2 for float and double that inline into
+   #pragma omp simd loops, unlike the libm calls, which keep those loops scalar. Each function
+   reduces its argument exactly (Cody-Waite splits of ln2 and pi/2), evaluates a fixed-degree
+   Taylor polynomial on the reduced range, and undoes the reduction with selects instead of
+   branches. The errors against libm, in ulp of the libm result, are not derived: "measured" is
+   the maximum over 8 x 2^20 uniformly random values of the domain (for float and double alike;
+   the edge cases of studies/fastmath_bench stay within it), and studies/fastmath_bench fails if
+   either set exceeds "bound", which leaves 1 ulp of margin for values neither set has hit
+
+       function     float domain    double domain    measured    bound
+       exp          [-87, 88]       [-708, 709]      1 ulp       2 ulp
+       sinh, cosh   |x| < 80        |x| < 80         2 ulp       3 ulp
+       sin, cos     |x| < 6400      |x| < 1.6e6      2 ulp       3 ulp
+       atan2        finite          finite           3 ulp       4 ulp
+
+   Outside of its domain, exp (and so sinh and cosh) saturates at the value of the bound and
+   sin/cos lose accuracy; NaN propagates to the result. Kinematics (|eta| < 10, |phi| < pi) are
+   well inside.
+*/
+namespace FastMath
+{
+
+namespace Detail
+{
+
+/* sin and cos on [-pi/4, pi/4]: Taylor series up to x^9 (float) and x^17 (double) */
+inline float sinPoly(float x)
+{
+    float x2 = x*x;
+    return x + x*x2*(-1.f/6 + x2*(1.f/120 + x2*(-1.f/5040 + x2*(1.f/362880))));
+};
+inline float cosPoly(float x)
+{
+    float x2 = x*x;
+    return 1.f - 0.5f*x2 + x2*x2*(1.f/24 + x2*(-1.f/720 + x2*(1.f/40320 + x2*(-1.f/3628800))));
+};
+inline double sinPoly(double x)
+{
+    double x2 = x*x;
+    return x + x*x2*(
+        -1./6 + x2*(1./120 + x2*(-1./5040 + x2*(1./362880 + x2*(-1./39916800 + x2*(
+        1./6227020800 + x2*(-1./1307674368000 + x2*(1./355687428096000)))))))
+    );
+};
+inline double cosPoly(double x)
+{
+    double x2 = x*x;
+    return 1. - 0.5*x2 + x2*x2*(
+        1./24 + x2*(-1./720 + x2*(1./40320 + x2*(-1./3628800 + x2*(1./479001600 + x2*(
+        -1./87178291200 + x2*(1./20922789888000))))))
+    );
+};
+
+/* exp on [-ln2/2, ln2/2]: Taylor series up to x^7 (float) and x^13 (double) */
+inline float expPoly(float x)
+{
+    return 1.f + x*(1.f + x*(1.f/2 + x*(1.f/6 + x*(1.f/24 + x*(1.f/120 + x*(1.f/720 + x*(1.f/5040)))))));
+};
+inline double expPoly(double x)
+{
+    return 1. + x*(1. + x*(1./2 + x*(1./6 + x*(1./24 + x*(1./120 + x*(1./720 + x*(1./5040 + x*(
+        1./40320 + x*(1./362880 + x*(1./3628800 + x*(1./39916800 + x*(1./479001600 + x*(
+        1./6227020800)))))))))))));
+};
+
+/* sinh on [-1, 1]: Taylor series up to x^11 (float) and x^17 (double) */
+inline float sinhPoly(float x)
+{
+    float x2 = x*x;
+    return x + x*x2*(1.f/6 + x2*(1.f/120 + x2*(1.f/5040 + x2*(1.f/362880 + x2*(1.f/39916800)))));
+};
+inline double sinhPoly(double x)
+{
+    double x2 = x*x;
+    return x + x*x2*(
+        1./6 + x2*(1./120 + x2*(1./5040 + x2*(1./362880 + x2*(1./39916800 + x2*(
+        1./6227020800 + x2*(1./1307674368000 + x2*(1./355687428096000)))))))
+    );
+};
+
+/* atan on [-tan(pi/8), tan(pi/8)]: Taylor series up to x^19 (float) and x^41 (double) */
+inline float atanPoly(float x)
+{
+    float x2 = x*x;
+    return x + x*x2*(
+        -1.f/3 + x2*(1.f/5 + x2*(-1.f/7 + x2*(1.f/9 + x2*(-1.f/11 + x2*(1.f/13 + x2*(-1.f/15 + x2*(
+        1.f/17 + x2*(-1.f/19))))))))
+    );
+};
+inline double atanPoly(double x)
+{
+    double x2 = x*x;
+    return x + x*x2*(
+        -1./3 + x2*(1./5 + x2*(-1./7 + x2*(1./9 + x2*(-1./11 + x2*(1./13 + x2*(-1./15 + x2*(
+        1./17 + x2*(-1./19 + x2*(1./21 + x2*(-1./23 + x2*(1./25 + x2*(-1./27 + x2*(1./29 + x2*(
+        -1./31 + x2*(1./33 + x2*(-1./35 + x2*(1./37 + x2*(-1./39 + x2*(1./41)))))))))))))))))))
+    );
+};
+
+/* Adding round_magic (1.5*2^mantissa_bits) rounds x to the nearest integer k (ties to even) and
+   leaves k in the low bits of the mantissa, so k is used without a float -> int conversion,
+   which does not vectorize for double without AVX-512
+*/
+template<typename T>
+struct Constants;
+
+template<>
+struct Constants<float>
+{
+    typedef uint32_t Bits;
+    static constexpr float round_magic = 12582912.f;
+    static constexpr float log2e = 1.44269504f;
+    static constexpr float ln2_hi = 0.693115234375f;      // 12 bits, so k*ln2_hi is exact
+    static constexpr float ln2_lo = 3.19461833e-05f;
+    static constexpr float two_over_pi = 0.636619772f;
+    static constexpr float pio2_1 = 1.5703125f;           // 12 bits each, so q*pio2_i is exact
+    static constexpr float pio2_2 = 4.83751297e-04f;
+    static constexpr float pio2_3 = 7.54953362e-08f;
+    static constexpr float pio2_4 = 2.56334407e-12f;
+    static constexpr float exp_min = -87.f;
+    static constexpr float exp_max = 88.f;
+    static constexpr Bits exponent_bias = 127;
+    static constexpr int mantissa_bits = 23;
+    static float reducePio2(float x, float q) { return (((x - q*pio2_1) - q*pio2_2) - q*pio2_3) - q*pio2_4; };
+};
+
+template<>
+struct Constants<double>
+{
+    typedef uint64_t Bits;
+    static constexpr double round_magic = 6755399441055744.;
+    static constexpr double log2e = 1.4426950408889634;
+    static constexpr double ln2_hi = 0.6931471803691238;  // 32 bits, so k*ln2_hi is exact
+    static constexpr double ln2_lo = 1.9082149292705877e-10;
+    static constexpr double two_over_pi = 0.6366197723675814;
+    static constexpr double pio2_1 = 1.5707963267341256;  // 33 bits, so q*pio2_1 is exact
+    static constexpr double pio2_2 = 6.077100506303966e-11; // 33 bits
+    static constexpr double pio2_3 = 2.0222662487959506e-21;
+    static constexpr double exp_min = -708.;
+    static constexpr double exp_max = 709.;
+    static constexpr Bits exponent_bias = 1023;
+    static constexpr int mantissa_bits = 52;
+    static double reducePio2(double x, double q) { return ((x - q*pio2_1) - q*pio2_2) - q*pio2_3; };
+};
+
+template<typename T>
+inline typename Constants<T>::Bits toBits(T x)
+{
+    typename Constants<T>::Bits bits;
+    std::memcpy(&bits, &x, sizeof(x));
+    return bits;
+};
+
+template<typename T>
+inline T fromBits(typename Constants<T>::Bits bits)
+{
+    T x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+};
+
+template<typename T>
+inline T exp(T x)
+{
+    typedef Constants<T> C;
+    x = (x < C::exp_min) ? C::exp_min : x;
+    x = (x > C::exp_max) ? C::exp_max : x;
+    // x = k*ln2 + r with |r| <= ln2/2, exp(x) = 2^k*exp(r)
+    T shifted = x*C::log2e + C::round_magic;
+    T k = shifted - C::round_magic;
+    T r = (x - k*C::ln2_hi) - k*C::ln2_lo;
+    // 2^k from its exponent bits; the bits of round_magic are shifted out
+    T scale = fromBits<T>((toBits(shifted) + C::exponent_bias) << C::mantissa_bits);
+    return expPoly(r)*scale;
+};
+
+template<typename T>
+inline void sincos(T x, T& sin_x, T& cos_x)
+{
+    typedef Constants<T> C;
+    // x = q*pi/2 + r with |r| <= pi/4
+    T shifted = x*C::two_over_pi + C::round_magic;
+    T q = shifted - C::round_magic;
+    T r = C::reducePio2(x, q);
+    T s = sinPoly(r);
+    T c = cosPoly(r);
+    // Quadrant (q mod 4 in the lowest two bits) applied with bit operations only, since 64-bit
+    // integer compares do not vectorize without SSE4.1
+    typedef typename C::Bits Bits;
+    const int sign_bit = 8*sizeof(T) - 1;
+    Bits quadrant = toBits(shifted);
+    Bits swap = Bits(0) - (quadrant & 1); // all ones in odd quadrants
+    Bits sin_bits = (toBits(c) & swap) | (toBits(s) & ~swap);
+    Bits cos_bits = (toBits(s) & swap) | (toBits(c) & ~swap);
+    sin_x = fromBits<T>(sin_bits ^ ((quadrant & 2) << (sign_bit - 1)));       // - in quadrants 2, 3
+    cos_x = fromBits<T>(cos_bits ^ (((quadrant + 1) & 2) << (sign_bit - 1))); // - in quadrants 1, 2
+};
+
+template<typename T>
+inline T atan2(T y, T x)
+{
+    const T pi = T(M_PI);
+    T abs_x = std::fabs(x);
+    T abs_y = std::fabs(y);
+    T num = (abs_y < abs_x) ? abs_y : abs_x;
+    T den = (abs_y < abs_x) ? abs_x : abs_y;
+    T t = (den == 0) ? T(0) : num/den;
+    // atan(t) = pi/4 + atan((t - 1)/(t + 1)) for t > tan(pi/8)
+    bool shift = (t > T(0.41421356237309503));
+    t = shift ? (t - 1)/(t + 1) : t;
+    T angle = atanPoly(t) + (shift ? pi/4 : T(0));
+    angle = (abs_y > abs_x) ? pi/2 - angle : angle;
+    angle = (std::copysign(T(1), x) < 0) ? pi - angle : angle; // also for x = -0
+    return std::copysign(angle, y);
+};
+
+} // End namespace Detail;
+
+inline float exp(float x) { return Detail::exp(x); };
+inline double exp(double x) { return Detail::exp(x); };
+
+inline float cosh(float x) { float e = Detail::exp(std::fabs(x)); return 0.5f*(e + 1.f/e); };
+inline double cosh(double x) { double e = Detail::exp(std::fabs(x)); return 0.5*(e + 1./e); };
+
+template<typename T>
+inline T sinh(T x)
+{
+    T e = Detail::exp(std::fabs(x));
+    T sinh_large = std::copysign(T(0.5)*(e - 1/e), x);
+    return (std::fabs(x) < 1) ? Detail::sinhPoly(x) : sinh_large;
+};
+inline float sinh(float x) { return sinh<float>(x); };
+inline double sinh(double x) { return sinh<double>(x); };
+
+inline void sincos(float x, float& sin_x, float& cos_x) { Detail::sincos(x, sin_x, cos_x); };
+inline void sincos(double x, double& sin_x, double& cos_x) { Detail::sincos(x, sin_x, cos_x); };
+
+inline float atan2(float y, float x) { return Detail::atan2(y, x); };
+inline double atan2(double y, double x) { return Detail::atan2(y, x); };
+
+/* pt, eta, phi -> px, py, pz (and |p|, if p is not null) for n objects */
+template<typename T>
+inline void fillPxPyPz(const float* __restrict pt, const float* __restrict eta, const float* __restrict phi,
+                       unsigned int n, T* __restrict px, T* __restrict py, T* __restrict pz,
+                       T* __restrict p = nullptr)
+{
+    #pragma omp simd
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        T sin_phi, cos_phi;
+        sincos(T(phi[i]), sin_phi, cos_phi);
+        px[i] = pt[i]*cos_phi;
+        py[i] = pt[i]*sin_phi;
+        pz[i] = pt[i]*sinh(T(eta[i]));
+    }
+    if (p == nullptr) { return; }
+    #pragma omp simd
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        p[i] = pt[i]*cosh(T(eta[i]));
+    }
+};
+
+} // End namespace FastMath;
+
+#endif
@@ -0,0 +1,585 @@
+#ifndef CORE_INPUT_H
+#define CORE_INPUT_H
+
+// STL
+#include <map>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <functional>
+// VBS
+#include "core/rntuple.h"       // RNTuples::API
+#include "core/eventindex.h"    // EventIndex::Reader
+// RAPIDO
+#include "looper.h"
+#include "hepcli.h"
+// ROOT
+#include "TKey.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TChain.h"
+#include "TBranch.h"
+#include "TString.h"
+#ifdef RNTUPLE_SUPPORTED
+#include <ROOT/RNTupleReader.hxx>
+#include <ROOT/RNTupleView.hxx>
+#endif
+#include "stdio.h"
+
+/* NanoAOD RNTuples read through the generated Nano accessors. The Nano class only needs a TTree
+   whose GetBranch returns branches that fill the addresses it sets on GetEntry, so Input::Tree is
+   a TTree without any baskets whose branches read the RNTuple instead: each branch wraps an
+   RNTupleView, so only the pages of the fields that are actually accessed are read, when they are
+   first accessed in an event (the same lazy loading as the Nano accessors on a TTree).
+
+   The branch names of NanoAOD are resolved against the fields of the RNTuple as follows:
+
+       Jet_pt      field Jet_pt (a scalar, or a std::vector/RVec as written by nano_to_rntuple)
+       nJet        size of the collection Jet (if there is no field nJet)
+       Jet_pt      member pt of the collection Jet (if there is no field Jet_pt), as in CMSSW
+
+   and GetBranch returns nullptr for names that match none of the above, as TTree::GetBranch does.
+
+   Input::Looper is a drop-in replacement for the Looper of rapido that uses Input::Tree when the
+   input files hold an RNTuple of the name of the input TChain, visits the indexed entries of the
+   original files when the input files are event-index sidecars (see core/eventindex.h), and uses
+   the Looper otherwise:
+
+       Input::Looper looper = Input::Looper(cli);
+       looper.run(
+           [&](TTree* ttree) { nt.Init(ttree); ... },
+           [&](int entry) { nt.GetEntry(entry); ... }
+       );
+
+   A third function can also be given, which is called after the last entry of every file while
+   the file is still open (Core::Skimmer::finish uses it to fast-clone files, see core/collections.h);
+   TTree inputs are then looped over here rather than by the Looper of rapido.
+
+   While it runs over RNTuples or sidecars, cli.input_tchain is an Input::Chain, so that
+   cli.input_tchain->GetCurrentFile() and cli.input_tchain->GetTree() still return the current
+   (original) file and its (Input::)Tree. Skims that copy events cannot run over RNTuples (Arbusto
+   clones the input TTree, which has no baskets there), but index skims can. RNTuples need ROOT
+   6.32 or later.
+
+   The entries of a sidecar are read file by file and, within a file, cluster by cluster (see
+   EventIndex::Reader::plan), with the TTreeCache limited to the current cluster: each cluster with
+   any indexed entry is read at once, and the others are not read at all.
+*/
+namespace Input
+{
+
+/* Whether the file holds an RNTuple (rather than a TTree) of the given name */
+inline bool isRNTuple(TFile* tfile, std::string name)
+{
+    TKey* key = tfile->GetKey(name.c_str());
+    return (key != nullptr && TString(key->GetClassName()).Contains("RNTuple"));
+};
+
+#ifdef RNTUPLE_SUPPORTED
+namespace API = RNTuples::API;
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,34,0)
+typedef API::RNTupleCollectionView CollectionView;
+
+inline CollectionView getCollectionView(API::RNTupleReader& reader, std::string name)
+{
+    return reader.GetCollectionView(name);
+};
+#else
+typedef API::RNTupleViewCollection CollectionView;
+
+inline CollectionView getCollectionView(API::RNTupleReader& reader, std::string name)
+{
+    return reader.GetViewCollection(name);
+};
+#endif
+
+/* Branch that fills its address from the RNTuple rather than from baskets */
+class Branch : public TBranch
+{
+protected:
+    virtual Int_t read(Long64_t entry) = 0;
+
+public:
+    Branch(std::string name)
+    {
+        SetName(name.c_str());
+    };
+
+    void SetAddress(void* address) override
+    {
+        fAddress = static_cast<char*>(address);
+    };
+
+    Int_t GetEntry(Long64_t entry, Int_t getall = 0) override
+    {
+        if (fAddress == nullptr) { return 0; }
+        return read(entry);
+    };
+};
+
+template<typename Type>
+class ScalarBranch : public Branch
+{
+private:
+    API::RNTupleView<Type> view;
+
+protected:
+    Int_t read(Long64_t entry) override
+    {
+        *reinterpret_cast<Type*>(fAddress) = view(entry);
+        return sizeof(Type);
+    };
+
+public:
+    ScalarBranch(API::RNTupleReader& reader, std::string name)
+    : Branch(name), view(reader.GetView<Type>(name))
+    {
+        // Do nothing
+    };
+};
+
+/* Values of one member of a collection, written to the address as a leaf-count array would be; the
+   address is a fixed-size array of the Nano class, so a collection with more than max_size items
+   is an error rather than a write past its end
+*/
+template<typename Type>
+class ArrayBranch : public Branch
+{
+private:
+    CollectionView collection;
+    API::RNTupleView<Type> item;
+    unsigned int max_size;
+
+protected:
+    Int_t read(Long64_t entry) override
+    {
+        auto range = collection.GetCollectionRange(entry);
+        unsigned int n_values = range.size();
+        if (n_values > max_size)
+        {
+            throw std::runtime_error(
+                "Input::ArrayBranch::read - " + std::string(GetName()) + " has " + std::to_string(n_values)
+                + " values in entry " + std::to_string(entry) + ", more than the " + std::to_string(max_size)
+                + " that the arrays of the Nano class hold"
+            );
+        }
+        Type* values = reinterpret_cast<Type*>(fAddress);
+        unsigned int value_i = 0;
+        for (auto item_i : range)
+        {
+            values[value_i] = item(item_i);
+            value_i++;
+        }
+        return n_values*sizeof(Type);
+    };
+
+public:
+    ArrayBranch(API::RNTupleReader& reader, std::string name, std::string collection_name, std::string item_name,
+                unsigned int max_array_size)
+    : Branch(name), collection(getCollectionView(reader, collection_name)), item(reader.GetView<Type>(item_name)),
+      max_size(max_array_size)
+    {
+        // Do nothing
+    };
+};
+
+/* Size of a collection, written to the address as the (UInt_t) count leaf of NanoAOD */
+class CountBranch : public Branch
+{
+private:
+    CollectionView collection;
+
+protected:
+    Int_t read(Long64_t entry) override
+    {
+        *reinterpret_cast<UInt_t*>(fAddress) = static_cast<UInt_t>(collection(entry));
+        return sizeof(UInt_t);
+    };
+
+public:
+    CountBranch(API::RNTupleReader& reader, std::string name, std::string collection_name)
+    : Branch(name), collection(getCollectionView(reader, collection_name))
+    {
+        // Do nothing
+    };
+};
+
+/* New BranchType<T>(args...) for the type T of a field, as named in the RNTuple descriptor */
+template<template<typename> class BranchType, typename... Args>
+Branch* newBranch(std::string type_name, Args&&... args)
+{
+    if (type_name == "double") { return new BranchType<double>(args...); }
+    if (type_name == "float") { return new BranchType<float>(args...); }
+    if (type_name == "std::int64_t") { return new BranchType<std::int64_t>(args...); }
+    if (type_name == "std::uint64_t") { return new BranchType<std::uint64_t>(args...); }
+    if (type_name == "std::int32_t") { return new BranchType<std::int32_t>(args...); }
+    if (type_name == "std::uint32_t") { return new BranchType<std::uint32_t>(args...); }
+    if (type_name == "std::int16_t") { return new BranchType<std::int16_t>(args...); }
+    if (type_name == "std::uint16_t") { return new BranchType<std::uint16_t>(args...); }
+    if (type_name == "std::int8_t") { return new BranchType<std::int8_t>(args...); }
+    if (type_name == "std::uint8_t") { return new BranchType<std::uint8_t>(args...); }
+    if (type_name == "bool") { return new BranchType<bool>(args...); }
+    throw std::runtime_error("Input::newBranch - unsupported field type " + type_name);
+};
+#endif
+
+/* TTree that reads the RNTuple of the same name in a file (see above) */
+class Tree : public TTree
+{
+private:
+    TFile* tfile;
+#ifdef RNTUPLE_SUPPORTED
+    std::unique_ptr<API::RNTupleReader> reader;
+    // Input::Branch, since TTree::Branch hides the name within a TTree
+    std::map<std::string, std::unique_ptr<Input::Branch>> branches;
+
+    std::string typeName(API::DescriptorId_t field_id)
+    {
+        return reader->GetDescriptor().GetFieldDescriptor(field_id).GetTypeName();
+    };
+
+    Input::Branch* resolve(std::string name)
+    {
+        const auto& descriptor = reader->GetDescriptor();
+        // Field of the same name: a scalar, or a std::vector/RVec (whose items are the subfield _0)
+        API::DescriptorId_t field_id = descriptor.FindFieldId(name);
+        if (field_id != API::kInvalidDescriptorId)
+        {
+            API::DescriptorId_t item_id = descriptor.FindFieldId("_0", field_id);
+            if (item_id == API::kInvalidDescriptorId)
+            {
+                return newBranch<ScalarBranch>(typeName(field_id), *reader, name);
+            }
+            return newBranch<ArrayBranch>(typeName(item_id), *reader, name, name, name + "._0", max_array_size);
+        }
+        // nCollection
+        if (name.size() > 1 && name.at(0) == 'n' && descriptor.FindFieldId(name.substr(1)) != API::kInvalidDescriptorId)
+        {
+            return new CountBranch(*reader, name, name.substr(1));
+        }
+        // Collection_member, as a member of the collection itself or of its items
+        size_t split = name.find('_');
+        if (split == std::string::npos) { return nullptr; }
+        std::string collection_name = name.substr(0, split);
+        std::string member_name = name.substr(split + 1);
+        API::DescriptorId_t collection_id = descriptor.FindFieldId(collection_name);
+        if (collection_id == API::kInvalidDescriptorId) { return nullptr; }
+        API::DescriptorId_t member_id = descriptor.FindFieldId(member_name, collection_id);
+        std::string item_name = collection_name + "." + member_name;
+        if (member_id == API::kInvalidDescriptorId)
+        {
+            API::DescriptorId_t item_id = descriptor.FindFieldId("_0", collection_id);
+            if (item_id == API::kInvalidDescriptorId) { return nullptr; }
+            member_id = descriptor.FindFieldId(member_name, item_id);
+            item_name = collection_name + "._0." + member_name;
+        }
+        if (member_id == API::kInvalidDescriptorId) { return nullptr; }
+        return newBranch<ArrayBranch>(typeName(member_id), *reader, name, collection_name, item_name, max_array_size);
+    };
+#endif
+
+public:
+    /* Most items a collection may have in one entry; must not exceed the size of the fixed arrays
+       that the Nano class reads the branches of a collection into */
+    unsigned int max_array_size;
+
+    Tree(TFile* new_tfile, std::string name, unsigned int new_max_array_size = 1000)
+    : TTree(), tfile(new_tfile), max_array_size(new_max_array_size)
+    {
+#ifdef RNTUPLE_SUPPORTED
+        SetName(name.c_str());
+        reader = API::RNTupleReader::Open(name, tfile->GetName());
+        SetEntries(reader->GetNEntries());
+#else
+        throw std::runtime_error("Input::Tree - RNTuple input needs ROOT 6.32 or later");
+#endif
+    };
+
+    TBranch* GetBranch(const char* name) override
+    {
+#ifdef RNTUPLE_SUPPORTED
+        auto found = branches.find(name);
+        if (found == branches.end())
+        {
+            // Unknown names are kept too (as nullptr), so that they are only resolved once
+            found = branches.emplace(name, std::unique_ptr<Input::Branch>(resolve(name))).first;
+        }
+        return found->second.get();
+#else
+        return nullptr;
+#endif
+    };
+
+    TFile* GetCurrentFile() const override
+    {
+        return tfile;
+    };
+};
+
+/* TChain that stands in for cli.input_tchain while Input::Looper loops over RNTuples or sidecars */
+class Chain : public TChain
+{
+public:
+    TTree* tree;
+
+    Chain(TChain* tchain) : TChain(tchain->GetName()), tree(nullptr)
+    {
+        TObjArray* files = tchain->GetListOfFiles();
+        for (int file_i = 0; file_i < files->GetEntriesFast(); ++file_i)
+        {
+            Add(files->At(file_i)->GetTitle());
+        }
+    };
+
+    TTree* GetTree() const override
+    {
+        return tree;
+    };
+
+    TFile* GetCurrentFile() const override
+    {
+        return (tree == nullptr) ? nullptr : tree->GetCurrentFile();
+    };
+};
+
+class Looper : public ::Looper
+{
+private:
+    HEPCLI& cli;
+    bool stopped;
+
+    enum InputKind
+    {
+        TTreeInput,
+        RNTupleInput,
+        EventIndexInput
+    };
+
+    /* Kind of input, judged from the first input file */
+    InputKind inputKind()
+    {
+        TObjArray* files = cli.input_tchain->GetListOfFiles();
+        if (files->GetEntriesFast() == 0) { return TTreeInput; }
+        TFile* tfile = TFile::Open(files->At(0)->GetTitle());
+        if (tfile == nullptr) { return TTreeInput; }
+        InputKind kind = TTreeInput;
+        if (EventIndex::isEventIndex(tfile)) { kind = EventIndexInput; }
+        else if (isRNTuple(tfile, cli.input_tchain->GetName())) { kind = RNTupleInput; }
+        tfile->Close();
+        delete tfile;
+        return kind;
+    };
+
+    void runRNTuples(std::function<void(TTree* ttree)> init, std::function<void(int entry)> evaluate,
+                     std::function<void(TTree* ttree)> finish)
+    {
+        TChain* input_tchain = cli.input_tchain;
+        Chain chain = Chain(input_tchain);
+        std::string name = input_tchain->GetName();
+        TObjArray* files = input_tchain->GetListOfFiles();
+
+        // Open every file once, counting the events from their metadata for the progress bar
+        std::vector<TFile*> tfiles;
+        std::vector<std::unique_ptr<Tree>> trees;
+        n_events_total = 0;
+        for (int file_i = 0; file_i < files->GetEntriesFast(); ++file_i)
+        {
+            TFile* tfile = TFile::Open(files->At(file_i)->GetTitle());
+            if (tfile == nullptr || !isRNTuple(tfile, name))
+            {
+                delete tfile;
+                for (unsigned int open_i = 0; open_i < tfiles.size(); ++open_i)
+                {
+                    trees.at(open_i).reset();
+                    delete tfiles.at(open_i);
+                }
+                throw std::runtime_error(
+                    "Input::Looper::run - no RNTuple " + name + " in " + files->At(file_i)->GetTitle()
+                );
+            }
+            tfiles.push_back(tfile);
+            trees.emplace_back(new Tree(tfile, name, max_array_size));
+            n_events_total += trees.back()->GetEntries();
+        }
+
+        cli.input_tchain = &chain;
+        for (unsigned int file_i = 0; file_i < tfiles.size(); ++file_i)
+        {
+            Tree& tree = *trees.at(file_i);
+            if (!stopped)
+            {
+                chain.tree = &tree;
+                init(&tree);
+                for (Long64_t entry = 0; entry < tree.GetEntries() && !stopped; ++entry)
+                {
+                    n_events_processed++;
+                    evaluate(entry);
+                }
+                if (finish) { finish(&tree); }
+                chain.tree = nullptr;
+            }
+            trees.at(file_i).reset();
+            tfiles.at(file_i)->Close();
+            delete tfiles.at(file_i);
+        }
+        cli.input_tchain = input_tchain;
+    };
+
+    /* Same loop as the Looper of rapido, with a call to finish at the end of every file */
+    void runTTrees(std::function<void(TTree* ttree)> init, std::function<void(int entry)> evaluate,
+                   std::function<void(TTree* ttree)> finish)
+    {
+        TChain* input_tchain = cli.input_tchain;
+        Chain chain = Chain(input_tchain);
+        std::string name = input_tchain->GetName();
+        TObjArray* files = input_tchain->GetListOfFiles();
+        n_events_total = input_tchain->GetEntries();
+
+        cli.input_tchain = &chain;
+        for (int file_i = 0; file_i < files->GetEntriesFast() && !stopped; ++file_i)
+        {
+            TFile* tfile = TFile::Open(files->At(file_i)->GetTitle());
+            TTree* ttree = (tfile == nullptr) ? nullptr : (TTree*) tfile->Get(name.c_str());
+            if (ttree == nullptr)
+            {
+                cli.input_tchain = input_tchain;
+                throw std::runtime_error(
+                    "Input::Looper::run - no TTree " + name + " in " + files->At(file_i)->GetTitle()
+                );
+            }
+            chain.tree = ttree;
+            init(ttree);
+            for (Long64_t entry = 0; entry < ttree->GetEntries() && !stopped; ++entry)
+            {
+                n_events_processed++;
+                evaluate(entry);
+            }
+            finish(ttree);
+            chain.tree = nullptr;
+            tfile->Close();
+            delete tfile;
+        }
+        cli.input_tchain = input_tchain;
+    };
+
+    void runEventIndex(std::function<void(TTree* ttree)> init, std::function<void(int entry)> evaluate,
+                       std::function<void(TTree* ttree)> finish)
+    {
+        TChain* input_tchain = cli.input_tchain;
+        Chain chain = Chain(input_tchain);
+        std::string name = input_tchain->GetName();
+        TObjArray* sidecars = input_tchain->GetListOfFiles();
+
+        EventIndex::Reader reader;
+        for (int sidecar_i = 0; sidecar_i < sidecars->GetEntriesFast(); ++sidecar_i)
+        {
+            TFile* tfile = TFile::Open(sidecars->At(sidecar_i)->GetTitle());
+            if (tfile == nullptr)
+            {
+                throw std::runtime_error(
+                    "Input::Looper::run - could not open " + std::string(sidecars->At(sidecar_i)->GetTitle())
+                );
+            }
+            reader.add(tfile);
+            tfile->Close();
+            delete tfile;
+        }
+        n_events_total = reader.size();
+
+        int n_clusters_read = 0;
+        int n_clusters_total = 0;
+        cli.input_tchain = &chain;
+        for (unsigned int file_i = 0; file_i < reader.files.size() && !stopped; ++file_i)
+        {
+            EventIndex::FileEntries& file = reader.files.at(file_i);
+            TFile* tfile = TFile::Open(file.name.c_str());
+            TTree* ttree = (tfile == nullptr) ? nullptr : (TTree*) tfile->Get(name.c_str());
+            if (ttree == nullptr)
+            {
+                cli.input_tchain = input_tchain;
+                throw std::runtime_error("Input::Looper::run - no TTree " + name + " in " + file.name);
+            }
+            chain.tree = ttree;
+            init(ttree);
+            std::vector<EventIndex::Cluster> clusters = EventIndex::Reader::plan(ttree, file.entries);
+            for (unsigned int cluster_i = 0; cluster_i < clusters.size() && !stopped; ++cluster_i)
+            {
+                EventIndex::Cluster& cluster = clusters.at(cluster_i);
+                ttree->SetCacheEntryRange(cluster.start, cluster.end);
+                for (unsigned int entry_i = 0; entry_i < cluster.entries.size() && !stopped; ++entry_i)
+                {
+                    n_events_processed++;
+                    evaluate(cluster.entries.at(entry_i));
+                }
+            }
+            if (cli.verbose)
+            {
+                TTree::TClusterIterator cluster_iter = ttree->GetClusterIterator(0);
+                while (cluster_iter() < ttree->GetEntries()) { n_clusters_total++; }
+                n_clusters_read += clusters.size();
+            }
+            if (finish) { finish(ttree); }
+            chain.tree = nullptr;
+            tfile->Close();
+            delete tfile;
+        }
+        cli.input_tchain = input_tchain;
+        if (cli.verbose)
+        {
+            printf(
+                "Input::Looper: %d indexed events from %d files, in %d of %d clusters\n",
+                (int) n_events_total, (int) reader.files.size(), n_clusters_read, n_clusters_total
+            );
+        }
+    };
+
+public:
+    unsigned int max_array_size; // see Input::Tree
+
+    Looper(HEPCLI& cli_ref) : ::Looper(cli_ref), cli(cli_ref), stopped(false), max_array_size(1000)
+    {
+        // Do nothing
+    };
+
+    /* Loop over the input RNTuples or sidecars if there are any, otherwise over the input TChain as
+       usual; finish (if any) is called after the last entry of every file, while it is still open */
+    void run(std::function<void(TTree* ttree)> init, std::function<void(int entry)> evaluate,
+             std::function<void(TTree* ttree)> finish = nullptr)
+    {
+        auto start = std::chrono::steady_clock::now();
+        switch (inputKind())
+        {
+        case RNTupleInput:
+            runRNTuples(init, evaluate, finish);
+            break;
+        case EventIndexInput:
+            runEventIndex(init, evaluate, finish);
+            break;
+        case TTreeInput:
+            if (finish) { runTTrees(init, evaluate, finish); }
+            else { ::Looper::run(init, evaluate); }
+            break;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (cli.verbose)
+        {
+            printf(
+                "Input::Looper: %d events in %.2f s (%.0f events/s)\n",
+                (int) n_events_processed, elapsed.count(), n_events_processed/elapsed.count()
+            );
+        }
+    };
+
+    void stop()
+    {
+        stopped = true;
+        ::Looper::stop();
+    };
+};
+
+} // End namespace Input;
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef JETASSIGNMENT_H
+#define JETASSIGNMENT_H
+
+// STL
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+// VBS
+#include "core/soa.h"           // SoA::Kinematics, SoA::Ints
+#include "core/pairs.h"         // Pairs::Cache, Pairs::Preselection
+
+/* Joint assignment of AK4 jets to a V->qq pair and a VBS pair. Every partition of the jets into
+   two disjoint pairs is scored as
+
+       score = ((M_qq - vqq_mass)/vqq_mass_sigma)^2 - vbs_deta_weight*|deta_jj| - vbs_mjj_weight*M_jj/1000
+
+   (lower is better) and the best assignment is returned along with the runner-up score, which
+   measures how ambiguous the choice was. V pairs are visited in order of increasing chi2 and VBS
+   pairs in order of decreasing bonus, so the search stops as soon as neither the best nor the
+   runner-up can still be improved; with ~12 jets only a few hundred of the ~3000 partitions are
+   usually scored.
+*/
+namespace JetAssignment
+{
+
+struct Config
+{
+    double vqq_mass;
+    double vqq_mass_sigma;
+    double vbs_deta_weight;
+    double vbs_mjj_weight;  // per TeV
+    double min_vbs_deta;    // hard requirements on the VBS pair
+    double min_vbs_mjj;
+    Pairs::Preselection vqq_presel;
+    Pairs::Preselection vbs_presel;
+
+    Config()
+    {
+        vqq_mass = 85.;        // between W and Z
+        vqq_mass_sigma = 15.;
+        vbs_deta_weight = 1.;
+        vbs_mjj_weight = 1.;
+        min_vbs_deta = 0.;
+        min_vbs_mjj = 0.;
+        vqq_presel = Pairs::Preselection(20., 4.7);
+        vbs_presel = Pairs::Preselection(30., 4.7);
+    };
+};
+
+struct Assignment
+{
+    int vqq_first;  // positions in the list of candidate indices
+    int vqq_second;
+    int vbs_first;
+    int vbs_second;
+    double score;
+
+    Assignment() : vqq_first(-1), vqq_second(-1), vbs_first(-1), vbs_second(-1),
+                   score(std::numeric_limits<double>::max()) {};
+
+    bool isValid() const { return vqq_first >= 0; };
+};
+
+struct Result
+{
+    Assignment best;
+    double runnerup_score;
+    unsigned int n_scored;
+
+    Result() : runnerup_score(std::numeric_limits<double>::max()), n_scored(0) {};
+
+    bool hasRunnerUp() const { return runnerup_score < std::numeric_limits<double>::max(); };
+};
+
+struct ScoredPair
+{
+    unsigned int i;
+    unsigned int j;
+    double value;
+};
+
+inline Result solve(const SoA::Kinematics& jets, const SoA::Ints& idxs, const Config& config = Config())
+{
+    Result result;
+    const Pairs::Cache cache(jets, idxs);
+    const unsigned int n_jets = cache.size();
+    if (n_jets < 4) { return result; }
+
+    // Score all V->qq and VBS pair candidates once
+    std::vector<ScoredPair> vqq_pairs;
+    std::vector<ScoredPair> vbs_pairs;
+    for (unsigned int i = 0; i < n_jets; ++i)
+    {
+        bool i_is_vqq = config.vqq_presel.passes(cache.pt[i], cache.eta[i]);
+        bool i_is_vbs = config.vbs_presel.passes(cache.pt[i], cache.eta[i]);
+        for (unsigned int j = i + 1; j < n_jets; ++j)
+        {
+            double Mjj = cache.M(i, j);
+            if (i_is_vqq && config.vqq_presel.passes(cache.pt[j], cache.eta[j]))
+            {
+                double pull = (Mjj - config.vqq_mass)/config.vqq_mass_sigma;
+                vqq_pairs.push_back({i, j, pull*pull});
+            }
+            if (i_is_vbs && config.vbs_presel.passes(cache.pt[j], cache.eta[j]))
+            {
+                double deta = std::fabs(cache.eta[i] - cache.eta[j]);
+                if (deta < config.min_vbs_deta || Mjj < config.min_vbs_mjj) { continue; }
+                vbs_pairs.push_back({i, j, config.vbs_deta_weight*deta + config.vbs_mjj_weight*Mjj/1000.});
+            }
+        }
+    }
+    if (vqq_pairs.empty() || vbs_pairs.empty()) { return result; }
+    std::stable_sort(
+        vqq_pairs.begin(), vqq_pairs.end(),
+        [](const ScoredPair& a, const ScoredPair& b) { return a.value < b.value; }
+    );
+    std::stable_sort(
+        vbs_pairs.begin(), vbs_pairs.end(),
+        [](const ScoredPair& a, const ScoredPair& b) { return a.value > b.value; }
+    );
+    const double max_bonus = vbs_pairs.front().value;
+
+    for (auto& vqq : vqq_pairs)
+    {
+        // No VBS pair can bring this (or any later) V pair below the runner-up
+        if (vqq.value - max_bonus >= result.runnerup_score) { break; }
+        for (auto& vbs : vbs_pairs)
+        {
+            double score = vqq.value - vbs.value;
+            // VBS pairs only get worse from here on
+            if (score >= result.runnerup_score) { break; }
+            if (vbs.i == vqq.i || vbs.i == vqq.j || vbs.j == vqq.i || vbs.j == vqq.j) { continue; }
+            result.n_scored++;
+            if (score < result.best.score)
+            {
+                result.runnerup_score = result.best.score;
+                result.best.vqq_first = cache.positions[vqq.i];
+                result.best.vqq_second = cache.positions[vqq.j];
+                result.best.vbs_first = cache.positions[vbs.i];
+                result.best.vbs_second = cache.positions[vbs.j];
+                result.best.score = score;
+            }
+            else
+            {
+                result.runnerup_score = score;
+            }
+        }
+    }
+    return result;
+};
+
+} // End namespace JetAssignment;
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef JETCORRECTIONS_H
+#define JETCORRECTIONS_H
+
+// STL
+#include <cmath>
+#include <vector>
+// VBS
+#include "core/soa.h"           // SoA::Kinematics, SoA::Jets, SoA::FatJets
+#include "core/vetomaps.h"      // VetoMaps::Engine, VetoMaps::Map
+#include "corrections/jets.h"   // JetEnergyScales
+// NanoCORE
+#include "Nano.h"
+
+/* Per-event jet corrections applied in place to the SoA jet arrays, in one pass over the jets:
+   each jet gets the HEM (or any other Scale map in the VetoMaps::Engine) factor and the JEC
+   factor, its change is propagated to the MET, and it is smeared for the JER, before the next
+   jet is corrected. The Scale maps that apply to the event are collected once per event into a
+   buffer that the Corrector keeps from event to event, so the pass allocates nothing; the JER
+   smearing, which NanoCORE does on a LorentzVector, uses one on the stack per jet.
+
+   The arithmetic follows ROOT::Math::LorentzVector<PtEtaPhiM4D<float>> exactly: scaling a
+   four-vector multiplies pt and mass by the factor converted to float, and px = pt*cos(phi)
+   in float; the MET sums are accumulated in the same jet order as before. The corrected
+   kinematics are therefore bit-for-bit those of the old step-by-step code in Core::SelectJets
+   and Core::SelectFatJets for every variation.
+*/
+namespace JetCorrections
+{
+
+class Corrector
+{
+private:
+    std::vector<const VetoMaps::Map*> scale_maps;
+    const std::vector<LorentzVector> no_genjet_p4s;
+
+    /* Product of the values of the Scale maps of this event at (eta, phi) */
+    float mapScale(float eta, float phi) const
+    {
+        float factor = scale_maps[0]->get(eta, phi);
+        for (unsigned int map_i = 1; map_i < scale_maps.size(); ++map_i)
+        {
+            factor *= scale_maps[map_i]->get(eta, phi);
+        }
+        return factor;
+    };
+
+    static void scale(SoA::Kinematics& jets, unsigned int jet_i, float factor)
+    {
+        jets.pt[jet_i] *= factor;
+        jets.mass[jet_i] *= factor;
+    };
+
+public:
+    Corrector()
+    {
+        // Do nothing
+    };
+
+    /* HEM, JEC and JER for AK4 jets; met_x and met_y are corrected for the HEM and JEC changes */
+    void correctAK4(SoA::Jets& jets, Nano& nt, const VetoMaps::Engine& veto_maps,
+                    JetEnergyScales* jes, int jer_seed, double& met_x, double& met_y)
+    {
+        veto_maps.scaleMaps(nt, scale_maps);
+        const bool has_maps = !scale_maps.empty();
+        const bool has_jec = (jes != nullptr && abs(jes->jec_var) == 2);
+        const bool has_jer = (!nt.isData() && jes != nullptr);
+        const float rho = (has_jer) ? nt.fixedGridRhoFastjetAll() : 0.f;
+        const std::vector<LorentzVector>& genjet_p4s = (has_jer) ? nt.GenJet_p4() : no_genjet_p4s;
+        for (unsigned int jet_i = 0; jet_i < jets.size(); ++jet_i)
+        {
+            const float raw_px = jets.pt[jet_i]*std::cos(jets.phi[jet_i]);
+            const float raw_py = jets.pt[jet_i]*std::sin(jets.phi[jet_i]);
+            if (has_maps) { scale(jets, jet_i, mapScale(jets.eta[jet_i], jets.phi[jet_i])); }
+            if (has_jec) { scale(jets, jet_i, jes->getAK4JECScale(jets.pt[jet_i], jets.eta[jet_i])); }
+
+            // Swap the uncorrected jet for the corrected one in the MET
+            const float corr_px = jets.pt[jet_i]*std::cos(jets.phi[jet_i]);
+            const float corr_py = jets.pt[jet_i]*std::sin(jets.phi[jet_i]);
+            met_x -= raw_px;
+            met_y -= raw_py;
+            met_x += corr_px;
+            met_y += corr_py;
+
+            if (has_jer)
+            {
+                LorentzVector jet_p4 = jets.p4(jet_i);
+                jes->smearJER(jer_seed, jet_p4, rho, genjet_p4s);
+                jets.setP4(jet_i, jet_p4);
+            }
+        }
+    };
+
+    /* HEM and JEC for AK8 jets */
+    void correctAK8(SoA::FatJets& fatjets, Nano& nt, const VetoMaps::Engine& veto_maps,
+                    JetEnergyScales* jes)
+    {
+        veto_maps.scaleMaps(nt, scale_maps);
+        const bool has_maps = !scale_maps.empty();
+        const bool has_jec = (jes != nullptr && abs(jes->jec_var) == 2);
+        if (!has_maps && !has_jec) { return; }
+        for (unsigned int fatjet_i = 0; fatjet_i < fatjets.size(); ++fatjet_i)
+        {
+            if (has_maps) { scale(fatjets, fatjet_i, mapScale(fatjets.eta[fatjet_i], fatjets.phi[fatjet_i])); }
+            if (has_jec) { scale(fatjets, fatjet_i, jes->getAK8JECScale(fatjets.pt[fatjet_i], fatjets.eta[fatjet_i])); }
+        }
+    };
+};
+
+} // End namespace JetCorrections;
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef LEPTONID_H
+#define LEPTONID_H
+
+// STL
+#include <vector>
+
+/* Per-event lepton ID masks: mask[i] = 1 if lepton i (in the Electron or Muon collection)
+   passes the ID. Selections fill all the masks they need once per event and then only loop
+   over the masks; IDs with a batched implementation over the NanoAOD arrays (e.g. the PKU IDs,
+   see PKU::elecIDMask) fill them directly, any other ID is evaluated lepton by lepton through
+   LeptonID::evaluate.
+
+   The ttH and ttH_UL IDs (Core::SelectLeptons, VBSWH::FindLeptons) are deliberately left scalar:
+   they are implemented in NanoCORE (ttH::electronID, ttH::muonID, ...), including the lepton MVA
+   and its jet-related inputs, and a batched copy here would have to track every change made there
+   to give the same masks. Only the mask-filling loop is shared with the batched IDs.
+*/
+namespace LeptonID
+{
+
+typedef std::vector<unsigned char> Mask;
+
+template<typename ID>
+inline Mask evaluate(unsigned int n_leps, ID passes_id)
+{
+    Mask mask(n_leps);
+    for (unsigned int lep_i = 0; lep_i < n_leps; ++lep_i)
+    {
+        mask[lep_i] = passes_id(lep_i);
+    }
+    return mask;
+};
+
+} // End namespace LeptonID;
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef LHE_H
+#define LHE_H
+
+// STL
+#include <vector>
+#include <stdexcept>
+// ROOT
+#include "TTree.h"
+// NanoCORE
+#include "Nano.h"
+
+namespace LHE
+{
+
+inline int getChargeQx3(int q_pdgID)
+{
+    switch (abs(q_pdgID))
+    {
+    case 1:
+        return -1; // down
+    case 2:
+        return  2; // up
+    case 3:
+        return -1; // strange
+    case 4:
+        return  2; // charm
+    case 5:
+        return -1; // bottom
+    case 6:
+        return  2; // top
+    default:
+        return -999;
+    }
+};
+
+inline double getChargeQQ(int q1_pdgID, int q2_pdgID)
+{
+    int q1_sign = (q1_pdgID > 0) - (q1_pdgID < 0);
+    int q2_sign = (q2_pdgID > 0) - (q2_pdgID < 0);
+    return (q1_sign*getChargeQx3(q1_pdgID) + q2_sign*getChargeQx3(q2_pdgID)) / 3.;
+};
+
+struct Particle
+{
+    unsigned int idx;   // idx in LHEPart collection
+    int pdgID;
+    int status;
+    LorentzVector p4;
+};
+
+typedef std::vector<Particle> Particles;
+
+/* Hard-process record decoded from the LHEPart collection. Particles are stored in the
+   same order they appear in LHEPart, so e.g. the two outgoing quarks of an EWK W sample
+   (LHEPart[4], LHEPart[5]) land in quarks.at(0) and quarks.at(1) respectively.
+*/
+struct HardProcess
+{
+    bool is_decoded;
+    Particles incoming; // status -1
+    Particles quarks;   // outgoing d, u, s, c, b
+    Particles gluons;   // outgoing g
+    Particles bosons;   // outgoing t, gamma, Z, W, H
+    Particles leptons;  // outgoing e, mu, tau
+    Particles neutrinos;
+    // Commonly used composite systems (only set if the relevant particles exist)
+    LorentzVector qq_p4;
+    LorentzVector lnu_p4;
+    double M_qq;
+    double M_lnu;
+    double charge_qq;
+
+    HardProcess()
+    {
+        is_decoded = false;
+        M_qq = -999;
+        M_lnu = -999;
+        charge_qq = -999;
+    };
+
+    HardProcess(Nano& nt) : HardProcess()
+    {
+        decode(nt);
+    };
+
+    void decode(Nano& nt)
+    {
+        const std::vector<int>& pdgIDs = nt.LHEPart_pdgId();
+        const std::vector<int>& statuses = nt.LHEPart_status();
+        const std::vector<LorentzVector>& p4s = nt.LHEPart_p4();
+        for (unsigned int lhe_i = 0; lhe_i < pdgIDs.size(); ++lhe_i)
+        {
+            Particle particle = {lhe_i, pdgIDs.at(lhe_i), statuses.at(lhe_i), p4s.at(lhe_i)};
+            if (particle.status == -1)
+            {
+                incoming.push_back(particle);
+                continue;
+            }
+            switch (abs(particle.pdgID))
+            {
+            case 1:
+            case 2:
+            case 3:
+            case 4:
+            case 5:
+                quarks.push_back(particle);
+                break;
+            case 21:
+                gluons.push_back(particle);
+                break;
+            case 6:
+            case 22:
+            case 23:
+            case 24:
+            case 25:
+                bosons.push_back(particle);
+                break;
+            case 11:
+            case 13:
+            case 15:
+                leptons.push_back(particle);
+                break;
+            case 12:
+            case 14:
+            case 16:
+                neutrinos.push_back(particle);
+                break;
+            default:
+                break;
+            }
+        }
+        if (quarks.size() >= 2)
+        {
+            qq_p4 = quarks.at(0).p4 + quarks.at(1).p4;
+            M_qq = qq_p4.M();
+            charge_qq = getChargeQQ(quarks.at(0).pdgID, quarks.at(1).pdgID);
+        }
+        if (leptons.size() >= 1 && neutrinos.size() >= 1)
+        {
+            lnu_p4 = leptons.at(0).p4 + neutrinos.at(0).p4;
+            M_lnu = lnu_p4.M();
+        }
+        is_decoded = true;
+    };
+
+    Particles getBosons(int abs_pdgID) const
+    {
+        Particles matches;
+        for (auto& boson : bosons)
+        {
+            if (abs(boson.pdgID) == abs_pdgID) { matches.push_back(boson); }
+        }
+        return matches;
+    };
+
+    Particles getQuarks(int abs_pdgID) const
+    {
+        Particles matches;
+        for (auto& quark : quarks)
+        {
+            if (abs(quark.pdgID) == abs_pdgID) { matches.push_back(quark); }
+        }
+        return matches;
+    };
+};
+
+/* Hard process of the current event, decoded from LHEPart the first time it is asked for, so that
+   studies that never look at it do not pay for it. Whether the LHE branches exist at all (they do
+   not in data, nor in e.g. the QCD_Pt NanoAOD) is checked once per file; Core::Analysis owns one,
+   which Core::Bookkeeping resets every event:
+
+       if (lhe.hasLHE())
+       {
+           const LHE::HardProcess& hard_process = lhe.hardProcess();
+           ...
+       }
+*/
+class Cache
+{
+private:
+    Nano* nt;
+    bool has_lhe;
+    HardProcess hard_process;
+
+public:
+    Cache()
+    {
+        nt = nullptr;
+        has_lhe = false;
+    };
+
+    /* Check the branches of a new file */
+    void init(TTree* ttree)
+    {
+        has_lhe = (ttree->GetBranch("LHEPart_pdgId") != nullptr);
+    };
+
+    /* Start a new event */
+    void reset(Nano& nt_ref)
+    {
+        nt = &nt_ref;
+        hard_process.is_decoded = false;
+    };
+
+    bool hasLHE() const { return has_lhe; };
+
+    const HardProcess& hardProcess()
+    {
+        if (!has_lhe)
+        {
+            throw std::runtime_error("LHE::Cache::hardProcess - no LHE branches in this file");
+        }
+        if (!hard_process.is_decoded) { hard_process = HardProcess(*nt); }
+        return hard_process;
+    };
+};
+
+} // End namespace LHE;
+
+#endif
@@ -0,0 +1,391 @@
+#ifndef LHEFILE_H
+#define LHEFILE_H
+
+// STL
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+// POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+// zlib
+#include <zlib.h>
+
+namespace LHE
+{
+
+/* Hand-written number parsing for the whitespace-separated LHE columns. Each function reads
+   one token starting at (or after whitespace following) 'ptr' and advances 'ptr' past it.
+*/
+inline void skipSpace(const char*& ptr, const char* end)
+{
+    while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r')) { ptr++; }
+};
+
+inline long parseInt(const char*& ptr, const char* end)
+{
+    skipSpace(ptr, end);
+    bool negative = false;
+    if (ptr < end && (*ptr == '-' || *ptr == '+')) { negative = (*ptr == '-'); ptr++; }
+    long value = 0;
+    while (ptr < end && *ptr >= '0' && *ptr <= '9') { value = 10*value + (*ptr - '0'); ptr++; }
+    return (negative) ? -value : value;
+};
+
+inline double parseDouble(const char*& ptr, const char* end)
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    skipSpace(ptr, end);
+    bool negative = false;
+    if (ptr < end && (*ptr == '-' || *ptr == '+')) { negative = (*ptr == '-'); ptr++; }
+    // Accumulate up to 19 significant digits in an integer mantissa
+    uint64_t mantissa = 0;
+    int n_digits = 0;
+    int exponent = 0;
+    while (ptr < end && *ptr >= '0' && *ptr <= '9')
+    {
+        if (n_digits < 19) { mantissa = 10*mantissa + (*ptr - '0'); n_digits += (mantissa > 0); }
+        else { exponent++; }
+        ptr++;
+    }
+    if (ptr < end && *ptr == '.')
+    {
+        ptr++;
+        while (ptr < end && *ptr >= '0' && *ptr <= '9')
+        {
+            if (n_digits < 19) { mantissa = 10*mantissa + (*ptr - '0'); n_digits += (mantissa > 0); exponent--; }
+            ptr++;
+        }
+    }
+    // Fortran-style exponents (e.g. 1.0d+03) also appear in some LHE files
+    if (ptr < end && (*ptr == 'e' || *ptr == 'E' || *ptr == 'd' || *ptr == 'D'))
+    {
+        ptr++;
+        exponent += parseInt(ptr, end);
+    }
+    double value = double(mantissa);
+    while (exponent > 22) { value *= 1e22; exponent -= 22; }
+    while (exponent < -22) { value /= 1e22; exponent += 22; }
+    value = (exponent >= 0) ? value*pow10[exponent] : value/pow10[-exponent];
+    return (negative) ? -value : value;
+};
+
+inline const char* findTag(const char* begin, const char* end, const char* tag)
+{
+    size_t tag_len = strlen(tag);
+    if (end - begin < (long)tag_len) { return nullptr; }
+    const char* last = end - tag_len;
+    for (const char* ptr = begin; ptr <= last; ++ptr)
+    {
+        ptr = (const char*) memchr(ptr, tag[0], last - ptr + 1);
+        if (ptr == nullptr) { return nullptr; }
+        if (memcmp(ptr, tag, tag_len) == 0) { return ptr; }
+    }
+    return nullptr;
+};
+
+/* Position right after the '>' that closes the tag at 'ptr' */
+inline const char* skipTag(const char* ptr, const char* end, const char* tag)
+{
+    const char* tag_end = (const char*) memchr(ptr, '>', end - ptr);
+    if (tag_end == nullptr)
+    {
+        throw std::runtime_error("LHE::skipTag - unterminated " + std::string(tag) + " tag");
+    }
+    return tag_end + 1;
+};
+
+/* User Process Run common block (<init> ... </init>) */
+struct Init
+{
+    int IDBMUP[2];
+    double EBMUP[2];
+    int PDFGUP[2];
+    int PDFSUP[2];
+    int IDWTUP;
+    int NPRUP;
+    std::vector<double> XSECUP;
+    std::vector<double> XERRUP;
+    std::vector<double> XMAXUP;
+    std::vector<int> LPRUP;
+
+    void parse(const char* ptr, const char* end)
+    {
+        IDBMUP[0] = parseInt(ptr, end);
+        IDBMUP[1] = parseInt(ptr, end);
+        EBMUP[0] = parseDouble(ptr, end);
+        EBMUP[1] = parseDouble(ptr, end);
+        PDFGUP[0] = parseInt(ptr, end);
+        PDFGUP[1] = parseInt(ptr, end);
+        PDFSUP[0] = parseInt(ptr, end);
+        PDFSUP[1] = parseInt(ptr, end);
+        IDWTUP = parseInt(ptr, end);
+        NPRUP = parseInt(ptr, end);
+        for (int proc_i = 0; proc_i < NPRUP; ++proc_i)
+        {
+            XSECUP.push_back(parseDouble(ptr, end));
+            XERRUP.push_back(parseDouble(ptr, end));
+            XMAXUP.push_back(parseDouble(ptr, end));
+            LPRUP.push_back(parseInt(ptr, end));
+        }
+    };
+};
+
+/* User Process Event common block (<event> ... </event>); particle columns are stored as
+   contiguous arrays and are reused (not reallocated) from one event to the next.
+*/
+struct Event
+{
+    int NUP;
+    int IDPRUP;
+    double XWGTUP;
+    double SCALUP;
+    double AQEDUP;
+    double AQCDUP;
+    std::vector<int> IDUP;
+    std::vector<int> ISTUP;
+    std::vector<int> MOTHUP1;
+    std::vector<int> MOTHUP2;
+    std::vector<int> ICOLUP1;
+    std::vector<int> ICOLUP2;
+    std::vector<double> P_X;
+    std::vector<double> P_Y;
+    std::vector<double> P_Z;
+    std::vector<double> E;
+    std::vector<double> M;
+    std::vector<double> VTIMUP;
+    std::vector<double> SPINUP;
+    std::vector<double> weights;    // <rwgt> weights, in the order of LHE::File::weight_ids
+
+    void parse(const char* ptr, const char* end)
+    {
+        // Skip the remainder of the <event ...> tag (may carry attributes)
+        ptr = skipTag(ptr, end, "<event");
+        NUP = parseInt(ptr, end);
+        IDPRUP = parseInt(ptr, end);
+        XWGTUP = parseDouble(ptr, end);
+        SCALUP = parseDouble(ptr, end);
+        AQEDUP = parseDouble(ptr, end);
+        AQCDUP = parseDouble(ptr, end);
+        IDUP.resize(NUP);
+        ISTUP.resize(NUP);
+        MOTHUP1.resize(NUP);
+        MOTHUP2.resize(NUP);
+        ICOLUP1.resize(NUP);
+        ICOLUP2.resize(NUP);
+        P_X.resize(NUP);
+        P_Y.resize(NUP);
+        P_Z.resize(NUP);
+        E.resize(NUP);
+        M.resize(NUP);
+        VTIMUP.resize(NUP);
+        SPINUP.resize(NUP);
+        for (int part_i = 0; part_i < NUP; ++part_i)
+        {
+            IDUP[part_i] = parseInt(ptr, end);
+            ISTUP[part_i] = parseInt(ptr, end);
+            MOTHUP1[part_i] = parseInt(ptr, end);
+            MOTHUP2[part_i] = parseInt(ptr, end);
+            ICOLUP1[part_i] = parseInt(ptr, end);
+            ICOLUP2[part_i] = parseInt(ptr, end);
+            P_X[part_i] = parseDouble(ptr, end);
+            P_Y[part_i] = parseDouble(ptr, end);
+            P_Z[part_i] = parseDouble(ptr, end);
+            E[part_i] = parseDouble(ptr, end);
+            M[part_i] = parseDouble(ptr, end);
+            VTIMUP[part_i] = parseDouble(ptr, end);
+            SPINUP[part_i] = parseDouble(ptr, end);
+        }
+        // Reweighting block: <rwgt> <wgt id='rwgt_1'> 1.234e-05 </wgt> ... </rwgt>
+        weights.clear();
+        const char* rwgt_begin = findTag(ptr, end, "<rwgt>");
+        if (rwgt_begin == nullptr) { return; }
+        const char* rwgt_end = findTag(rwgt_begin, end, "</rwgt>");
+        if (rwgt_end == nullptr) { rwgt_end = end; }
+        ptr = rwgt_begin;
+        while ((ptr = findTag(ptr, rwgt_end, "<wgt")) != nullptr)
+        {
+            ptr = skipTag(ptr, rwgt_end, "<wgt");
+            weights.push_back(parseDouble(ptr, rwgt_end));
+        }
+    };
+};
+
+/* Streaming reader for (optionally gzip-compressed) LHE files. Plain files are memory-mapped
+   and parsed in place; gzip files are inflated into a window that slides over the file, so
+   memory use does not grow with the number of events (the window only grows to hold the whole
+   header, up to </init>, however long it is).
+*/
+class File
+{
+private:
+    std::string file_name;
+    bool is_gzip;
+    // Memory-mapped input
+    int fd;
+    const char* map_begin;
+    size_t map_size;
+    // Gzip input
+    gzFile gz_file;
+    std::vector<char> buffer;
+    size_t buffer_size;
+    bool gz_eof;
+    // Current read position
+    const char* cursor;
+    const char* data_end;
+
+    static const size_t chunk_size = 1 << 22; // 4 MB
+
+    void fillBuffer()
+    {
+        // Move unread bytes to the front of the buffer, then inflate more data behind them
+        size_t n_unread = data_end - cursor;
+        memmove(buffer.data(), cursor, n_unread);
+        if (buffer.size() < n_unread + chunk_size) { buffer.resize(n_unread + chunk_size); }
+        int n_read = gzread(gz_file, buffer.data() + n_unread, chunk_size);
+        if (n_read < 0)
+        {
+            throw std::runtime_error("LHE::File::fillBuffer - failed to inflate "+file_name);
+        }
+        gz_eof = (n_read == 0);
+        buffer_size = n_unread + n_read;
+        cursor = buffer.data();
+        data_end = buffer.data() + buffer_size;
+    };
+
+    /* Find the next block delimited by 'open_tag' ... 'close_tag'; returns false at EOF */
+    bool nextBlock(const char* open_tag, const char* close_tag, const char*& begin, const char*& end)
+    {
+        while (true)
+        {
+            begin = findTag(cursor, data_end, open_tag);
+            if (begin != nullptr)
+            {
+                end = findTag(begin, data_end, close_tag);
+                if (end != nullptr)
+                {
+                    cursor = end + strlen(close_tag);
+                    return true;
+                }
+            }
+            if (!is_gzip || gz_eof) { return false; }
+            // Block is incomplete (or not yet seen): keep the partial block and read more
+            if (begin != nullptr) { cursor = begin; }
+            else if (data_end - cursor > 16) { cursor = data_end - 16; }
+            fillBuffer();
+        }
+    };
+
+public:
+    Init init;
+    std::vector<std::string> weight_ids;
+    long n_events_read;
+
+    File(std::string new_file_name)
+    {
+        file_name = new_file_name;
+        is_gzip = (file_name.size() > 3 && file_name.compare(file_name.size() - 3, 3, ".gz") == 0);
+        fd = -1;
+        map_begin = nullptr;
+        map_size = 0;
+        gz_file = nullptr;
+        buffer_size = 0;
+        gz_eof = false;
+        n_events_read = 0;
+        if (is_gzip)
+        {
+            gz_file = gzopen(file_name.c_str(), "rb");
+            if (gz_file == nullptr)
+            {
+                throw std::runtime_error("LHE::File - could not open "+file_name);
+            }
+            gzbuffer(gz_file, chunk_size);
+            buffer.resize(chunk_size);
+            cursor = buffer.data();
+            data_end = buffer.data();
+            fillBuffer();
+        }
+        else
+        {
+            fd = open(file_name.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                throw std::runtime_error("LHE::File - could not open "+file_name);
+            }
+            struct stat file_stat;
+            fstat(fd, &file_stat);
+            map_size = file_stat.st_size;
+            void* map = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED)
+            {
+                throw std::runtime_error("LHE::File - could not memory-map "+file_name);
+            }
+            madvise(map, map_size, MADV_SEQUENTIAL);
+            map_begin = (const char*) map;
+            cursor = map_begin;
+            data_end = map_begin + map_size;
+        }
+        readHeader();
+    };
+
+    ~File()
+    {
+        if (map_begin != nullptr) { munmap((void*) map_begin, map_size); }
+        if (fd >= 0) { close(fd); }
+        if (gz_file != nullptr) { gzclose(gz_file); }
+    };
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    void readHeader()
+    {
+        const char* begin;
+        const char* end;
+        // The whole header must be in the window, however long its <header> and <initrwgt> blocks
+        while (is_gzip && !gz_eof && findTag(cursor, data_end, "</init>") == nullptr) { fillBuffer(); }
+        // Reweighting ids from <initrwgt>: <weight id='rwgt_1'> set param_card ... </weight>
+        const char* header_end = findTag(cursor, data_end, "<init>");
+        const char* initrwgt = (header_end != nullptr) ? findTag(cursor, header_end, "<initrwgt>") : nullptr;
+        if (initrwgt != nullptr)
+        {
+            const char* ptr = initrwgt;
+            while ((ptr = findTag(ptr, header_end, "<weight id=")) != nullptr)
+            {
+                ptr += 11;
+                if (ptr >= header_end) { break; }
+                char quote = *ptr++;
+                const char* id_end = (const char*) memchr(ptr, quote, header_end - ptr);
+                if (id_end == nullptr) { break; }
+                weight_ids.push_back(std::string(ptr, id_end));
+                ptr = id_end;
+            }
+        }
+        if (!nextBlock("<init>", "</init>", begin, end))
+        {
+            throw std::runtime_error("LHE::File::readHeader - no <init> block in "+file_name);
+        }
+        init.parse(begin + 6, end);
+    };
+
+    bool next(Event& event)
+    {
+        const char* begin;
+        const char* end;
+        if (!nextBlock("<event", "</event>", begin, end)) { return false; }
+        event.parse(begin, end);
+        n_events_read++;
+        return true;
+    };
+};
+
+} // End namespace LHE;
+
+#endif
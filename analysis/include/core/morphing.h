@@ -0,0 +1,282 @@
+#ifndef MORPHING_H
+#define MORPHING_H
+
+// STL
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+// ROOT
+#include "TString.h"
+#include "TMatrixD.h"
+#include "TVectorD.h"
+#include "TDecompSVD.h"
+
+typedef std::vector<int> Exponents;
+
+/* Morphing of the reweighting basis stored in LHEReweightingWeight onto a polynomial in the
+   couplings. The matrix element is a sum of amplitude terms, each a monomial in the couplings
+   (e.g. kW*C2V), so the event weight is a polynomial whose monomials are all pairwise products
+   of the amplitude terms. Given the coupling values at each reweighting point (one basis file
+   per sample), the least-squares projection from reweights to polynomial coefficients is
+   computed once per file; each event then only needs one matrix-vector product, and any
+   coupling point can be evaluated later as a dot product of the coefficients with the
+   monomials at that point (see CouplingMorphing::evaluate).
+
+   Basis files live in data/morphing_bases/{SAMPLE}.txt and contain one line per
+   LHEReweightingWeight index listing the coupling values in the order given by
+   'coupling_names'; '#' starts a comment. They are written from the reweight card of the sample
+   by utils/make_morphing_basis.py. A file uses the basis whose SAMPLE is exactly its sample name
+   (the name of its directory up to _Tune, as in bin/run), and otherwise the only basis whose
+   SAMPLE is a substring of its path; more than one such basis is an error.
+
+   Every event is also checked against its own reweights: the morphed weight at each basis point
+   is compared to the reweight of that point, and the largest relative difference is reported by
+   write(), so that a basis that does not match the reweight card of a sample shows up at once.
+*/
+struct CouplingMorphing
+{
+private:
+    TMatrixD projection; // n_monomials x n_points
+    std::vector<std::vector<double>> basis_points;
+    unsigned int n_files_active;
+    long n_events_checked;
+    double max_residual;
+
+    std::vector<std::vector<double>> readBasis(std::string basis_file)
+    {
+        std::vector<std::vector<double>> basis_points;
+        std::ifstream basis_stream(basis_file);
+        std::string line;
+        while (std::getline(basis_stream, line))
+        {
+            line = line.substr(0, line.find('#'));
+            std::istringstream line_stream(line);
+            std::vector<double> point;
+            double value;
+            while (line_stream >> value) { point.push_back(value); }
+            if (point.size() == 0) { continue; }
+            if (point.size() != coupling_names.size())
+            {
+                throw std::runtime_error(
+                    "CouplingMorphing::readBasis - wrong number of couplings in line '"+line+"' of "+basis_file
+                );
+            }
+            basis_points.push_back(point);
+        }
+        return basis_points;
+    };
+
+public:
+    std::vector<std::string> coupling_names;
+    std::vector<Exponents> monomials;
+    std::string basis_dir;
+    std::string basis_name;
+    unsigned int n_points;
+    bool is_active;
+
+    CouplingMorphing(std::vector<std::string> coupling_names, std::vector<Exponents> amplitude_terms,
+                     std::string basis_dir = "data/morphing_bases")
+    {
+        this->coupling_names = coupling_names;
+        this->basis_dir = basis_dir;
+        n_points = 0;
+        is_active = false;
+        n_files_active = 0;
+        n_events_checked = 0;
+        max_residual = 0.;
+        // Weight monomials are all (unique) pairwise products of the amplitude terms
+        for (unsigned int term_i = 0; term_i < amplitude_terms.size(); ++term_i)
+        {
+            for (unsigned int term_j = term_i; term_j < amplitude_terms.size(); ++term_j)
+            {
+                Exponents monomial;
+                for (unsigned int coupling_i = 0; coupling_i < coupling_names.size(); ++coupling_i)
+                {
+                    monomial.push_back(amplitude_terms.at(term_i).at(coupling_i) + amplitude_terms.at(term_j).at(coupling_i));
+                }
+                if (std::find(monomials.begin(), monomials.end(), monomial) == monomials.end())
+                {
+                    monomials.push_back(monomial);
+                }
+            }
+        }
+    };
+
+    static double evalMonomial(const Exponents& monomial, const std::vector<double>& couplings)
+    {
+        double value = 1.;
+        for (unsigned int coupling_i = 0; coupling_i < couplings.size(); ++coupling_i)
+        {
+            for (int power = 0; power < monomial.at(coupling_i); ++power) { value *= couplings.at(coupling_i); }
+        }
+        return value;
+    };
+
+    /* Basis file of the given input file: an exact match of its sample name, or else the only
+       basis whose name is a substring of its path ("" if there is none) */
+    std::string findBasis(TString file_name)
+    {
+        if (!std::filesystem::exists(basis_dir)) { return ""; }
+        std::filesystem::path file_path = file_name.Data();
+        std::string sample_name = file_path.parent_path().filename().string();
+        sample_name = sample_name.substr(0, sample_name.find("_Tune"));
+        std::vector<std::string> matches;
+        for (auto& entry : std::filesystem::directory_iterator(basis_dir))
+        {
+            if (entry.path().extension() != ".txt") { continue; }
+            std::string stem = entry.path().stem().string();
+            if (stem == sample_name) { return entry.path().string(); }
+            if (file_name.Contains(stem)) { matches.push_back(entry.path().string()); }
+        }
+        if (matches.size() > 1)
+        {
+            std::sort(matches.begin(), matches.end());
+            std::string match_list = matches.at(0);
+            for (unsigned int match_i = 1; match_i < matches.size(); ++match_i) { match_list += ", " + matches.at(match_i); }
+            throw std::runtime_error(
+                "CouplingMorphing::findBasis - "+std::string(file_name.Data())+" matches more than one basis ("
+                +match_list+"); name the basis after the sample"
+            );
+        }
+        return (matches.size() == 1) ? matches.at(0) : "";
+    };
+
+    void init(TString file_name)
+    {
+        is_active = false;
+        basis_name = findBasis(file_name);
+        if (basis_name == "") { return; }
+
+        // Build design matrix: one row per reweighting point, one column per monomial
+        basis_points = readBasis(basis_name);
+        n_points = basis_points.size();
+        unsigned int n_monomials = monomials.size();
+        if (n_points < n_monomials)
+        {
+            throw std::runtime_error(
+                "CouplingMorphing::init - "+basis_name+" has fewer points than the "
+                +std::to_string(n_monomials)+" monomials needed"
+            );
+        }
+        TMatrixD design(n_points, n_monomials);
+        for (unsigned int point_i = 0; point_i < n_points; ++point_i)
+        {
+            for (unsigned int mono_i = 0; mono_i < n_monomials; ++mono_i)
+            {
+                design(point_i, mono_i) = evalMonomial(monomials.at(mono_i), basis_points.at(point_i));
+            }
+        }
+
+        // Least-squares projection (pseudo-inverse) via SVD: P = V diag(1/sigma) U^T
+        TDecompSVD svd(design);
+        if (!svd.Decompose() || svd.Condition() < 0 || svd.Condition() > 1e12)
+        {
+            throw std::runtime_error(
+                "CouplingMorphing::init - basis in "+basis_name+" does not constrain all monomials"
+            );
+        }
+        const TMatrixD& U = svd.GetU();
+        const TMatrixD& V = svd.GetV();
+        const TVectorD& sigma = svd.GetSig();
+        projection.ResizeTo(n_monomials, n_points);
+        for (unsigned int mono_i = 0; mono_i < n_monomials; ++mono_i)
+        {
+            for (unsigned int point_i = 0; point_i < n_points; ++point_i)
+            {
+                double value = 0.;
+                for (unsigned int sig_i = 0; sig_i < n_monomials; ++sig_i)
+                {
+                    value += V(mono_i, sig_i)*U(point_i, sig_i)/sigma(sig_i);
+                }
+                projection(mono_i, point_i) = value;
+            }
+        }
+        is_active = true;
+        n_files_active++;
+    };
+
+    std::vector<double> getCoefs(const std::vector<float>& reweights)
+    {
+        if (reweights.size() != n_points)
+        {
+            throw std::runtime_error(
+                "CouplingMorphing::getCoefs - expected "+std::to_string(n_points)+" reweights from "
+                +basis_name+", got "+std::to_string(reweights.size())
+            );
+        }
+        std::vector<double> coefs(projection.GetNrows(), 0.);
+        const double* data = projection.GetMatrixArray(); // row-major
+        for (int mono_i = 0; mono_i < projection.GetNrows(); ++mono_i)
+        {
+            const double* row = data + mono_i*n_points;
+            double coef = 0.;
+            for (unsigned int point_i = 0; point_i < n_points; ++point_i)
+            {
+                coef += row[point_i]*reweights[point_i];
+            }
+            coefs[mono_i] = coef;
+        }
+        return coefs;
+    };
+
+    double evaluate(const std::vector<double>& coefs, const std::vector<double>& couplings)
+    {
+        double weight = 0.;
+        for (unsigned int mono_i = 0; mono_i < monomials.size(); ++mono_i)
+        {
+            weight += coefs.at(mono_i)*evalMonomial(monomials.at(mono_i), couplings);
+        }
+        return weight;
+    };
+
+    /* Index of the basis point with the given couplings, or -1 if there is none */
+    int findPoint(const std::vector<double>& couplings)
+    {
+        for (unsigned int point_i = 0; point_i < basis_points.size(); ++point_i)
+        {
+            if (basis_points.at(point_i) == couplings) { return point_i; }
+        }
+        return -1;
+    };
+
+    /* Compare the morphed weight at every basis point with the reweight of that point */
+    void check(const std::vector<double>& coefs, const std::vector<float>& reweights)
+    {
+        for (unsigned int point_i = 0; point_i < n_points; ++point_i)
+        {
+            double morphed = evaluate(coefs, basis_points.at(point_i));
+            double residual = std::abs(morphed - reweights[point_i])/std::max(std::abs(double(reweights[point_i])), 1e-12);
+            max_residual = std::max(max_residual, residual);
+        }
+        n_events_checked++;
+    };
+
+    /* Write the monomial layout of the stored coefficients, e.g. "C2V kW kZ" then "0 2 0"; nothing
+       is written if no input file had a basis */
+    void write(std::string output_file)
+    {
+        if (n_files_active == 0) { return; }
+        std::cout << "CouplingMorphing: " << n_events_checked << " events morphed, largest relative difference "
+                  << "from the reweights at the basis points: " << max_residual << std::endl;
+        std::ofstream output_stream(output_file);
+        for (unsigned int coupling_i = 0; coupling_i < coupling_names.size(); ++coupling_i)
+        {
+            output_stream << coupling_names.at(coupling_i) << ((coupling_i + 1 < coupling_names.size()) ? " " : "\n");
+        }
+        for (auto& monomial : monomials)
+        {
+            for (unsigned int coupling_i = 0; coupling_i < monomial.size(); ++coupling_i)
+            {
+                output_stream << monomial.at(coupling_i) << ((coupling_i + 1 < monomial.size()) ? " " : "\n");
+            }
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef CORE_OUTPUT_H
+#define CORE_OUTPUT_H
+
+// STL
+#include <string>
+#include <cstring>
+#include <stdexcept>
+// VBS
+#include "core/columns.h"       // Columns::Writer
+#include "core/rntuple.h"       // RNTuples::Writer
+// RAPIDO
+#include "arbol.h"
+#include "hepcli.h"
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "Compression.h"
+
+/* Output format of the Arbol of a study, chosen on the command line:
+
+       ./bin/{STUDY} --output_format=rntuple ...
+
+       ttree    (default) the Arbol's TTree
+       rntuple  an RNTuple with the same name, leaves and types, in the same file (see core/rntuple.h)
+       columns  flat binary columns in {output_dir}/{output_name}_columns (see core/columns.h)
+
+   HEPCLI does not know this option, so it is taken out of argv before HEPCLI parses it:
+
+       Output::Format output_format = Output::popFormat(argc, argv);
+       HEPCLI cli = HEPCLI(argc, argv);
+       Arbol arbol = Arbol(cli);
+       Output::Writer output = Output::Writer(arbol, cli, output_format);
+       ...
+       if (checkpoints.at(0)) { output.fill(); }     // instead of arbol.fill()
+       ...
+       output.write();                               // instead of arbol.write()
+
+   The Arbol still opens the ROOT file (histograms and the like are still written to it), but for
+   the other formats its TTree is left empty (columns) or not written at all (rntuple).
+
+   The compression of the output is chosen the same way, as an algorithm with an optional level
+   (1-9, higher is smaller and slower to write):
+
+       ./bin/{STUDY} --compression=zstd:5 ...
+
+       default  (default) ROOT's default for each format (zlib:1 for TTrees, zstd:5 for RNTuples)
+       zstd     zstd, level 5 unless given
+       lz4      lz4, level 4 unless given (fastest to read)
+       zlib     zlib, level 1 unless given
+       lzma     lzma, level 7 unless given (smallest)
+       none     no compression
+
+       int compression = Output::popCompression(argc, argv);
+       ...
+       Output::Writer output = Output::Writer(arbol, cli, output_format, compression);
+
+   It applies to everything written to the ROOT file (the TTree or RNTuple, histograms and the
+   like), but not to columns, which are never compressed. studies/compression_bench compares the
+   settings on a given baby or skim.
+*/
+namespace Output
+{
+
+enum Format
+{
+    TTreeFormat,
+    RNTupleFormat,
+    ColumnsFormat
+};
+
+inline Format getFormat(std::string format_name)
+{
+    if (format_name == "ttree") { return TTreeFormat; }
+    if (format_name == "rntuple") { return RNTupleFormat; }
+    if (format_name == "columns") { return ColumnsFormat; }
+    throw std::runtime_error("Output::getFormat - unknown output format " + format_name + " (ttree, rntuple, columns)");
+};
+
+/* Remove --{option}=X or --{option} X from the command line and return X (default_value if absent) */
+inline std::string popOption(int& argc, char** argv, std::string option, std::string default_value)
+{
+    std::string value = default_value;
+    int arg_i = 1;
+    while (arg_i < argc)
+    {
+        std::string arg = argv[arg_i];
+        int n_args = 0;
+        if (arg == option)
+        {
+            if (arg_i + 1 == argc)
+            {
+                throw std::runtime_error("Output::popOption - " + option + " needs a value");
+            }
+            value = argv[arg_i + 1];
+            n_args = 2;
+        }
+        else if (arg.rfind(option + "=", 0) == 0)
+        {
+            value = arg.substr(option.size() + 1);
+            n_args = 1;
+        }
+        if (n_args == 0)
+        {
+            arg_i++;
+            continue;
+        }
+        for (int shift_i = arg_i; shift_i + n_args <= argc; ++shift_i)
+        {
+            argv[shift_i] = argv[shift_i + n_args]; // also moves the terminating nullptr
+        }
+        argc -= n_args;
+    }
+    return value;
+};
+
+/* Remove --output_format=X or --output_format X from the command line and return it */
+inline Format popFormat(int& argc, char** argv)
+{
+    return getFormat(popOption(argc, argv, "--output_format", "ttree"));
+};
+
+/* Compression settings that leave the defaults of ROOT as they are */
+const int DefaultCompression = -1;
+
+/* ROOT compression settings (100*algorithm + level) of {algorithm} or {algorithm}:{level} */
+inline int getCompression(std::string compression_name)
+{
+    if (compression_name == "default") { return DefaultCompression; }
+    if (compression_name == "none") { return 0; }
+    size_t colon = compression_name.find(':');
+    std::string algorithm_name = compression_name.substr(0, colon);
+    int level = -1;
+    if (colon != std::string::npos)
+    {
+        std::string level_name = compression_name.substr(colon + 1);
+        if (level_name.size() != 1 || level_name[0] < '1' || level_name[0] > '9')
+        {
+            throw std::runtime_error("Output::getCompression - level of " + compression_name + " is not 1-9");
+        }
+        level = level_name[0] - '0';
+    }
+    ROOT::RCompressionSetting::EAlgorithm::EValues algorithm;
+    if (algorithm_name == "zstd") { algorithm = ROOT::RCompressionSetting::EAlgorithm::kZSTD; }
+    else if (algorithm_name == "lz4") { algorithm = ROOT::RCompressionSetting::EAlgorithm::kLZ4; }
+    else if (algorithm_name == "zlib") { algorithm = ROOT::RCompressionSetting::EAlgorithm::kZLIB; }
+    else if (algorithm_name == "lzma") { algorithm = ROOT::RCompressionSetting::EAlgorithm::kLZMA; }
+    else
+    {
+        throw std::runtime_error(
+            "Output::getCompression - unknown compression " + compression_name + " (zstd, lz4, zlib, lzma, none)"
+        );
+    }
+    if (level < 0)
+    {
+        // Same as ROOT's presets (ROOT::RCompressionSetting::EDefaults)
+        switch (algorithm)
+        {
+        case ROOT::RCompressionSetting::EAlgorithm::kZSTD: level = 5; break;
+        case ROOT::RCompressionSetting::EAlgorithm::kLZ4: level = 4; break;
+        case ROOT::RCompressionSetting::EAlgorithm::kLZMA: level = 7; break;
+        default: level = 1; break;
+        }
+    }
+    return ROOT::CompressionSettings(algorithm, level);
+};
+
+/* Remove --compression=X or --compression X from the command line and return its settings */
+inline int popCompression(int& argc, char** argv)
+{
+    return getCompression(popOption(argc, argv, "--compression", "default"));
+};
+
+/* Compress everything written to the file from now on with the given settings, including the
+   baskets of the TTree (if any) that are not written yet: branches take the settings of their file
+   when they are created, so those that already exist are set as well */
+inline void setCompression(TFile* tfile, TTree* ttree, int compression)
+{
+    if (compression == DefaultCompression) { return; }
+    tfile->SetCompressionSettings(compression);
+    if (ttree == nullptr) { return; }
+    TIter next_branch(ttree->GetListOfBranches());
+    while (TBranch* branch = (TBranch*) next_branch())
+    {
+        branch->SetCompressionSettings(compression); // and its sub-branches
+    }
+};
+
+class Writer
+{
+private:
+    Arbol& arbol;
+    Format format;
+    Columns::Writer columns;
+    RNTuples::Writer rntuple;
+
+public:
+    Writer(Arbol& arbol_ref, HEPCLI& cli, Format new_format, int compression = DefaultCompression)
+    : arbol(arbol_ref), format(new_format),
+      columns(arbol_ref, cli.output_dir + "/" + cli.output_name + "_columns"),
+      rntuple(arbol_ref)
+    {
+#ifndef RNTUPLE_SUPPORTED
+        if (format == RNTupleFormat)
+        {
+            throw std::runtime_error("Output::Writer - RNTuple output needs ROOT 6.32 or later");
+        }
+#endif
+        setCompression(arbol.tfile, arbol.ttree, compression);
+        rntuple.setCompression(compression);
+    };
+
+    void fill()
+    {
+        switch (format)
+        {
+        case TTreeFormat:
+            arbol.fill();
+            break;
+        case RNTupleFormat:
+            rntuple.fill();
+            break;
+        case ColumnsFormat:
+            columns.fill();
+            break;
+        }
+    };
+
+    void write()
+    {
+        switch (format)
+        {
+        case TTreeFormat:
+            arbol.write();
+            break;
+        case RNTupleFormat:
+            // Commit the RNTuple and close the file without writing the (empty) TTree of the same name
+            rntuple.write();
+            arbol.tfile->Close();
+            break;
+        case ColumnsFormat:
+            columns.write();
+            arbol.write();
+            break;
+        }
+    };
+};
+
+} // End namespace Output;
+
+#endif
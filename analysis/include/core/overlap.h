@@ -0,0 +1,87 @@
+#ifndef OVERLAP_H
+#define OVERLAP_H
+
+// STL
+#include <cmath>
+#include <vector>
+// VBS
+#include "core/soa.h"           // SoA::Kinematics
+// NanoCORE
+#include "Nano.h"
+
+/* Vectorized delta-R overlap removal on eta/phi float arrays. The arithmetic mirrors
+   ROOT::Math::VectorUtil::DeltaR for float LorentzVectors exactly (float deta and dphi, dphi
+   wrapped into (-pi, pi] in double precision, float sum of squares), and the cut on
+   sqrt(dR^2) < dR_max is replaced by the equivalent cut dR^2 < threshold (see dR2Threshold),
+   so the keep masks are bit-for-bit the same selections as the old nested DeltaR loops while
+   the inner loop over objects compiles to SIMD instructions.
+*/
+namespace Overlap
+{
+
+typedef std::vector<unsigned char> Mask; // 1 = keep, 0 = overlaps a cleaning object
+
+/* Smallest float dR^2 for which the float sqrt is no longer below dR_max */
+inline float dR2Threshold(double dR_max)
+{
+    if (dR_max <= 0) { return 0.f; }
+    float threshold = float(dR_max*dR_max);
+    // sqrtf is correctly rounded and monotonic, so walk to the exact boundary
+    while (threshold > 0.f && std::sqrt(std::nextafter(threshold, 0.f)) >= dR_max)
+    {
+        threshold = std::nextafter(threshold, 0.f);
+    }
+    while (std::sqrt(threshold) < dR_max)
+    {
+        threshold = std::nextafter(threshold, HUGE_VALF);
+    }
+    return threshold;
+};
+
+/* keep[i] &= (dR(object i, every cleaning object) >= dR_max) */
+inline void fillKeepMask(const float* __restrict eta, const float* __restrict phi, unsigned int n_objects,
+                         const float* clean_eta, const float* clean_phi, unsigned int n_clean,
+                         double dR_max, unsigned char* __restrict keep)
+{
+    const float dR2_max = dR2Threshold(dR_max);
+    for (unsigned int clean_i = 0; clean_i < n_clean; ++clean_i)
+    {
+        const float ceta = clean_eta[clean_i];
+        const float cphi = clean_phi[clean_i];
+        #pragma omp simd
+        for (unsigned int obj_i = 0; obj_i < n_objects; ++obj_i)
+        {
+            float dphi = phi[obj_i] - cphi;
+            // Branch-free wrap; at most one of the two shifts applies
+            float dphi_dn = float(dphi - 2.0*M_PI);
+            float dphi_up = float(dphi + 2.0*M_PI);
+            dphi = (dphi > M_PI) ? dphi_dn : dphi;
+            dphi = (dphi <= -M_PI) ? dphi_up : dphi;
+            float deta = eta[obj_i] - ceta;
+            float dR2 = dphi*dphi + deta*deta;
+            keep[obj_i] &= (unsigned char)(dR2 >= dR2_max);
+        }
+    }
+};
+
+inline Mask keepMask(const SoA::Kinematics& objects, const SoA::Kinematics& cleaners, double dR_max)
+{
+    Mask keep(objects.size(), 1);
+    fillKeepMask(
+        objects.eta.data(), objects.phi.data(), objects.size(),
+        cleaners.eta.data(), cleaners.phi.data(), cleaners.size(),
+        dR_max, keep.data()
+    );
+    return keep;
+};
+
+inline Mask keepMask(const SoA::Kinematics& objects, const std::vector<LorentzVector>& cleaner_p4s, double dR_max)
+{
+    SoA::Kinematics cleaners;
+    for (auto& p4 : cleaner_p4s) { cleaners.pushP4(p4); }
+    return keepMask(objects, cleaners, dR_max);
+};
+
+} // End namespace Overlap;
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef PAIRS_H
+#define PAIRS_H
+
+// STL
+#include <cmath>
+#include <vector>
+// VBS
+#include "core/soa.h"           // SoA::Kinematics, SoA::Ints
+#include "core/precision.h"     // Real, Reals
+#include "core/fastmath.h"      // FastMath::fillPxPyPz, FastMath::cosh
+
+/* Single-pass search for the best jet pair under several criteria at once. Per-jet quantities
+   (px, py, pz, E, |p|) are computed once in SIMD loops (with FastMath, within 3 ulp of libm),
+   then for each jet the metrics of all pairs it forms with later jets are computed in a SIMD
+   loop and scanned for the maxima. Pairs are scanned in the same (i < j) order as a nested loop
+   and only replaced on a strictly larger value, so ties resolve to the first pair exactly like
+   the old per-cut loops did.
+*/
+namespace Pairs
+{
+
+enum Criterion
+{
+    MaxDEta = 0, // max |eta_i - eta_j|
+    MaxMjj,      // max invariant mass
+    MaxSumP,     // max |p_i| + |p_j|
+    n_criteria
+};
+
+struct Preselection
+{
+    float min_pt;
+    float max_abs_eta;
+    bool opposite_hemispheres; // only consider pairs with eta_i*eta_j < 0 (eta = 0 counts as +)
+
+    Preselection(float min_pt = 0., float max_abs_eta = 999., bool opposite_hemispheres = false)
+    {
+        this->min_pt = min_pt;
+        this->max_abs_eta = max_abs_eta;
+        this->opposite_hemispheres = opposite_hemispheres;
+    };
+
+    bool passes(float pt, float eta) const
+    {
+        return (pt >= min_pt && std::fabs(eta) < max_abs_eta);
+    };
+};
+
+struct Pair
+{
+    int first;  // position in the list of candidate indices
+    int second;
+    double value;
+
+    Pair() : first(-1), second(-1), value(-999) {};
+
+    bool isValid() const { return first >= 0; };
+};
+
+struct Result
+{
+    Pair best[n_criteria];          // over all pairs passing the preselection
+    Pair best_opposite[n_criteria]; // same, restricted to opposite-hemisphere pairs
+};
+
+/* Per-object quantities needed for pair metrics, gathered once from the SoA arrays */
+struct Cache
+{
+    std::vector<int> positions; // position in the list of candidate indices
+    std::vector<float> pt;
+    std::vector<float> eta;
+    std::vector<float> phi;
+    Reals px, py, pz, E, P;
+
+    Cache(const SoA::Kinematics& objects, const SoA::Ints& idxs, const Preselection& presel = Preselection())
+    {
+        positions.reserve(idxs.size());
+        std::vector<float> mass;
+        for (unsigned int pos = 0; pos < idxs.size(); ++pos)
+        {
+            int i = idxs[pos];
+            if (!presel.passes(objects.pt[i], objects.eta[i])) { continue; }
+            positions.push_back(pos);
+            pt.push_back(objects.pt[i]);
+            eta.push_back(objects.eta[i]);
+            phi.push_back(objects.phi[i]);
+            mass.push_back(objects.mass[i]);
+        }
+        const unsigned int n_cands = positions.size();
+        px.resize(n_cands);
+        py.resize(n_cands);
+        pz.resize(n_cands);
+        E.resize(n_cands);
+        P.resize(n_cands);
+        FastMath::fillPxPyPz(pt.data(), eta.data(), phi.data(), n_cands, px.data(), py.data(), pz.data());
+        #pragma omp simd
+        for (unsigned int i = 0; i < n_cands; ++i)
+        {
+            Real m = mass[i];
+            E[i] = std::sqrt(px[i]*px[i] + py[i]*py[i] + pz[i]*pz[i] + m*m);
+            P[i] = pt[i]*FastMath::cosh(eta[i]); // float, like LorentzVector::P()
+        }
+    };
+
+    unsigned int size() const { return positions.size(); };
+
+    Real M(unsigned int i, unsigned int j) const
+    {
+        Real sum_px = px[i] + px[j];
+        Real sum_py = py[i] + py[j];
+        Real sum_pz = pz[i] + pz[j];
+        Real sum_E = E[i] + E[j];
+        Real mjj2 = sum_E*sum_E - sum_px*sum_px - sum_py*sum_py - sum_pz*sum_pz;
+        return (mjj2 > 0) ? std::sqrt(mjj2) : Real(0);
+    };
+};
+
+/* Search all pairs of objects.at(idxs); objects failing the per-object preselection are skipped */
+inline Result findBestPairs(const SoA::Kinematics& objects, const SoA::Ints& idxs,
+                            const Preselection& presel = Preselection())
+{
+    Result result;
+    // Gather candidates into contiguous arrays
+    const Cache cache(objects, idxs, presel);
+    const std::vector<int>& positions = cache.positions;
+    const std::vector<float>& eta = cache.eta;
+    const Reals& px = cache.px;
+    const Reals& py = cache.py;
+    const Reals& pz = cache.pz;
+    const Reals& E = cache.E;
+    const Reals& P = cache.P;
+    const unsigned int n_cands = positions.size();
+    if (n_cands < 2) { return result; }
+
+    Reals detas(n_cands), mjj2s(n_cands), sum_ps(n_cands);
+    std::vector<unsigned char> opposite(n_cands);
+    for (unsigned int i = 0; i + 1 < n_cands; ++i)
+    {
+        const float eta_i = eta[i];
+        const Real px_i = px[i], py_i = py[i], pz_i = pz[i], E_i = E[i], P_i = P[i];
+        const bool pos_i = (eta_i >= 0);
+        // Metrics of all (i, j > i) pairs
+        #pragma omp simd
+        for (unsigned int j = i + 1; j < n_cands; ++j)
+        {
+            Real sum_px = px_i + px[j];
+            Real sum_py = py_i + py[j];
+            Real sum_pz = pz_i + pz[j];
+            Real sum_E = E_i + E[j];
+            Real mjj2 = sum_E*sum_E - sum_px*sum_px - sum_py*sum_py - sum_pz*sum_pz;
+            detas[j] = std::fabs(eta_i - eta[j]);
+            mjj2s[j] = (mjj2 > 0) ? mjj2 : Real(0); // compare M^2 so the loop has no sqrt
+            sum_ps[j] = P_i + P[j];
+            opposite[j] = (pos_i != (eta[j] >= 0));
+        }
+        // Scan for maxima in nested-loop order
+        for (unsigned int j = i + 1; j < n_cands; ++j)
+        {
+            if (presel.opposite_hemispheres && !opposite[j]) { continue; }
+            const Real values[n_criteria] = {detas[j], mjj2s[j], sum_ps[j]};
+            for (unsigned int crit = 0; crit < n_criteria; ++crit)
+            {
+                Pair& best = result.best[crit];
+                if (values[crit] > best.value)
+                {
+                    best.first = positions[i];
+                    best.second = positions[j];
+                    best.value = values[crit];
+                }
+                if (!opposite[j]) { continue; }
+                Pair& best_opposite = result.best_opposite[crit];
+                if (values[crit] > best_opposite.value)
+                {
+                    best_opposite.first = positions[i];
+                    best_opposite.second = positions[j];
+                    best_opposite.value = values[crit];
+                }
+            }
+        }
+    }
+    for (auto best : {&result.best[MaxMjj], &result.best_opposite[MaxMjj]})
+    {
+        if (best->isValid()) { best->value = std::sqrt(best->value); }
+    }
+    return result;
+};
+
+} // End namespace Pairs;
+
+#endif
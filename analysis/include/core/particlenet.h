@@ -0,0 +1,87 @@
+#ifndef CORE_PARTICLENET_H
+#define CORE_PARTICLENET_H
+
+// STL
+#include <vector>
+// VBS
+#include "core/soa.h"           // SoA::FatJets
+#include "core/precision.h"     // Real, Reals
+
+/* The one definition of the ParticleNet mass-decorrelated discriminants used in this repo, built
+   from the raw NanoAOD scores (FatJet_particleNetMD_{Xbb,Xqq,Xcc,QCD}) as X/(X + QCD):
+
+       xbb  = Xbb/(Xbb + QCD)
+       xqq  = Xqq/(Xqq + QCD)
+       xcc  = Xcc/(Xcc + QCD)
+       xwqq = (Xcc + Xqq)/(Xcc + Xqq + QCD)          W-like
+       xvqq = (Xbb + Xcc + Xqq)/(Xbb + Xcc + Xqq + QCD) W/Z-like
+
+   The scores are promoted to Real (double unless built with SINGLE_PRECISION) before summing.
+   A zero denominator gives NaN, as it always has; such jets fail every cut on the discriminants.
+*/
+namespace ParticleNet
+{
+
+inline Real xbb(Real pnet_xbb, Real pnet_qcd) { return pnet_xbb/(pnet_xbb + pnet_qcd); };
+inline Real xqq(Real pnet_xqq, Real pnet_qcd) { return pnet_xqq/(pnet_xqq + pnet_qcd); };
+inline Real xcc(Real pnet_xcc, Real pnet_qcd) { return pnet_xcc/(pnet_xcc + pnet_qcd); };
+
+inline Real xwqq(Real pnet_xqq, Real pnet_xcc, Real pnet_qcd)
+{
+    return (pnet_xcc + pnet_xqq)/(pnet_xcc + pnet_xqq + pnet_qcd);
+};
+
+inline Real xvqq(Real pnet_xbb, Real pnet_xqq, Real pnet_xcc, Real pnet_qcd)
+{
+    return (pnet_xbb + pnet_xcc + pnet_xqq)/(pnet_xbb + pnet_xcc + pnet_xqq + pnet_qcd);
+};
+
+/* All discriminants for every fat jet in the event, computed in one SIMD loop */
+struct Discriminants
+{
+    Reals xbb;
+    Reals xqq;
+    Reals xcc;
+    Reals xwqq;
+    Reals xvqq;
+
+    void fill(const float* __restrict pnet_xbb, const float* __restrict pnet_xqq,
+              const float* __restrict pnet_xcc, const float* __restrict pnet_qcd, unsigned int n_fatjets)
+    {
+        xbb.resize(n_fatjets);
+        xqq.resize(n_fatjets);
+        xcc.resize(n_fatjets);
+        xwqq.resize(n_fatjets);
+        xvqq.resize(n_fatjets);
+        Real* __restrict out_xbb = xbb.data();
+        Real* __restrict out_xqq = xqq.data();
+        Real* __restrict out_xcc = xcc.data();
+        Real* __restrict out_xwqq = xwqq.data();
+        Real* __restrict out_xvqq = xvqq.data();
+        #pragma omp simd
+        for (unsigned int fatjet_i = 0; fatjet_i < n_fatjets; ++fatjet_i)
+        {
+            Real bb = pnet_xbb[fatjet_i];
+            Real qq = pnet_xqq[fatjet_i];
+            Real cc = pnet_xcc[fatjet_i];
+            Real qcd = pnet_qcd[fatjet_i];
+            out_xbb[fatjet_i] = ParticleNet::xbb(bb, qcd);
+            out_xqq[fatjet_i] = ParticleNet::xqq(qq, qcd);
+            out_xcc[fatjet_i] = ParticleNet::xcc(cc, qcd);
+            out_xwqq[fatjet_i] = ParticleNet::xwqq(qq, cc, qcd);
+            out_xvqq[fatjet_i] = ParticleNet::xvqq(bb, qq, cc, qcd);
+        }
+    };
+
+    void fill(const SoA::FatJets& fatjets)
+    {
+        fill(
+            fatjets.pnetmd_xbb.data(), fatjets.pnetmd_xqq.data(),
+            fatjets.pnetmd_xcc.data(), fatjets.pnetmd_qcd.data(), fatjets.size()
+        );
+    };
+};
+
+} // End namespace ParticleNet;
+
+#endif
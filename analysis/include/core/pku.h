@@ -1,6 +1,10 @@
 #ifndef PKU_H
 #define PKU_H
 
+// STL
+#include <cmath>
+// VBS
+#include "core/leptonid.h"      // LeptonID::Mask
 // NanoCORE
 #include "Nano.h"
 
@@ -69,6 +73,63 @@ bool passesMuonID(unsigned int muon_i, IDLevel id_level)
     return true;
 };
 
+/* Same as passesElecID for all electrons at once */
+inline LeptonID::Mask elecIDMask(Nano& nt, IDLevel id_level)
+{
+    const std::vector<float>& pts = nt.Electron_pt();
+    const std::vector<float>& etas = nt.Electron_eta();
+    const std::vector<float>& deta_scs = nt.Electron_deltaEtaSC();
+    const std::vector<float>& dzs = nt.Electron_dz();
+    const std::vector<float>& dxys = nt.Electron_dxy();
+    const std::vector<int>& cut_baseds = nt.Electron_cutBased();
+    const unsigned int n_elecs = pts.size();
+    const bool tight = (id_level == IDtight);
+    LeptonID::Mask mask(n_elecs);
+    #pragma omp simd
+    for (unsigned int elec_i = 0; elec_i < n_elecs; ++elec_i)
+    {
+        // Cuts are written as !(fail condition) to treat NaNs exactly like passesElecID
+        bool passed = (!(pts[elec_i] <= 10) && cut_baseds[elec_i] >= 1);
+        float abs_eta_sc = std::fabs(etas[elec_i] + deta_scs[elec_i]);
+        float abs_dz = std::fabs(dzs[elec_i]);
+        float abs_dxy = std::fabs(dxys[elec_i]);
+        bool passes_ip = (
+            (abs_eta_sc >= 1.479) 
+            ? (!(abs_dz >= 0.2) && !(abs_dxy >= 0.1)) 
+            : (!(abs_dz >= 0.1) && !(abs_dxy >= 0.05))
+        );
+        bool passes_tight = (
+            !(pts[elec_i] <= 35) && cut_baseds[elec_i] >= 3 && !(abs_eta_sc >= 2.5) && passes_ip
+        );
+        mask[elec_i] = (passed && (!tight || passes_tight));
+    }
+    return mask;
+};
+
+/* Same as passesMuonID for all muons at once */
+inline LeptonID::Mask muonIDMask(Nano& nt, IDLevel id_level)
+{
+    const std::vector<float>& pts = nt.Muon_pt();
+    const std::vector<float>& etas = nt.Muon_eta();
+    const std::vector<float>& isos = nt.Muon_pfRelIso04_all();
+    const std::vector<bool>& tight_ids = nt.Muon_tightId();
+    const unsigned int n_muons = pts.size();
+    const bool tight = (id_level == IDtight);
+    // std::vector<bool> is bit-packed, so unpack it before the SIMD loop
+    LeptonID::Mask mask(n_muons);
+    for (unsigned int muon_i = 0; muon_i < n_muons; ++muon_i) { mask[muon_i] = tight_ids[muon_i]; }
+    #pragma omp simd
+    for (unsigned int muon_i = 0; muon_i < n_muons; ++muon_i)
+    {
+        bool passed = (mask[muon_i] && !(isos[muon_i] >= 0.4) && !(pts[muon_i] <= 10));
+        bool passes_tight = (
+            !(isos[muon_i] >= 0.15) && !(pts[muon_i] <= 26) && !(std::fabs(etas[muon_i]) >= 2.4)
+        );
+        mask[muon_i] = (passed && (!tight || passes_tight));
+    }
+    return mask;
+};
+
 };
 
 #endif
@@ -0,0 +1,21 @@
+#ifndef CORE_PRECISION_H
+#define CORE_PRECISION_H
+
+// STL
+#include <vector>
+
+/* Floating-point type of the per-object hot-path kernels (pair metrics, ParticleNet
+   discriminants). NanoAOD stores kinematics and scores as float and these kernels have always
+   promoted them to double; building with SINGLE_PRECISION defined (make study=... PRECISION=single)
+   keeps them in float instead, which doubles the width of their SIMD loops and halves their
+   memory traffic. Event weights, MET sums, cutflow counts and the output branches stay double
+   in both modes; utils/compare_precision.py reports the selection differences between the two.
+*/
+#ifdef SINGLE_PRECISION
+typedef float Real;
+#else
+typedef double Real;
+#endif
+typedef std::vector<Real> Reals;
+
+#endif
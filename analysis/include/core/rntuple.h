@@ -0,0 +1,303 @@
+#ifndef CORE_RNTUPLE_H
+#define CORE_RNTUPLE_H
+
+// STL
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+// RAPIDO
+#include "arbol.h"
+// ROOT
+#include "RVersion.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TBranchElement.h"
+#include "TLeaf.h"
+#include "TClass.h"
+#include "TString.h"
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,32,0)
+#define RNTUPLE_SUPPORTED
+#include <ROOT/RNTupleModel.hxx>
+#include <ROOT/RNTupleWriter.hxx>
+#endif
+
+/* RNTuple copy of an Arbol: one field per branch of its TTree, with the same name and type
+   (std::vector leaves become std::vector fields), written to the Arbol's file under the name of
+   its TTree, so that uproot reads it as before and hadd merges it. Used as an output format by
+   Output::Writer (see core/output.h); like Columns::Writer, the fields are booked on the first
+   fill, once all branches exist, and the values are copied from the branch addresses on every
+   fill. Needs ROOT 6.32 or later (and -lROOTNTuple, which the Makefile adds when available).
+
+   The Writer also copies a TTree read from a file (e.g. NanoAOD, whose leaf-count arrays such as
+   Jet_pt[nJet] become std::vector fields next to the nJet field), once InputBuffers has given
+   every branch an address (see studies/nano_to_rntuple):
+
+       RNTuples::InputBuffers buffers = RNTuples::InputBuffers(events);
+       RNTuples::Writer writer = RNTuples::Writer(events, output_tfile, "Events");
+       for (...) { events->GetEntry(entry); writer.fill(); }
+       writer.write();
+*/
+namespace RNTuples
+{
+
+#ifdef RNTUPLE_SUPPORTED
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,36,0)
+namespace API = ROOT;
+#else
+namespace API = ROOT::Experimental;
+#endif
+
+/* Copies the value of a branch into the value of its field */
+typedef void (*Copier)(TBranch* branch, void* value);
+
+enum Kind
+{
+    Scalar,
+    Vector, // std::vector branch
+    Array   // leaf-count array, e.g. Jet_pt[nJet]
+};
+
+struct Field
+{
+    TBranch* branch;
+    std::shared_ptr<void> value;
+    Copier copy;
+};
+#endif
+
+/* Addresses for every branch of a TTree read from a file, so that their values can be copied by
+   the Writer after each GetEntry: a buffer per scalar, one as large as the largest entry per
+   leaf-count array (from the maximum of its count leaf) and an object per std::vector branch */
+class InputBuffers
+{
+private:
+    std::vector<std::vector<char>> buffers;
+    std::vector<void*> objects;
+    std::vector<TClass*> classes;
+
+public:
+    InputBuffers(TTree* ttree)
+    {
+        TObjArray* branches = ttree->GetListOfBranches();
+        buffers.resize(branches->GetEntriesFast());
+        objects.resize(branches->GetEntriesFast(), nullptr);
+        classes.resize(branches->GetEntriesFast(), nullptr);
+        for (int branch_i = 0; branch_i < branches->GetEntriesFast(); ++branch_i)
+        {
+            TBranch* branch = (TBranch*) branches->At(branch_i);
+            TBranchElement* branch_element = dynamic_cast<TBranchElement*>(branch);
+            if (branch_element)
+            {
+                classes[branch_i] = TClass::GetClass(branch_element->GetClassName());
+                objects[branch_i] = classes[branch_i]->New();
+                branch->SetAddress(&objects[branch_i]);
+                continue;
+            }
+            TLeaf* leaf = (TLeaf*) branch->GetListOfLeaves()->At(0);
+            int n_values = leaf->GetLenStatic();
+            if (leaf->GetLeafCount())
+            {
+                n_values *= std::max(1, leaf->GetLeafCount()->GetMaximum());
+            }
+            buffers[branch_i].resize(n_values*std::max(1, leaf->GetLenType()));
+            branch->SetAddress(buffers[branch_i].data());
+        }
+    };
+
+    ~InputBuffers()
+    {
+        for (unsigned int object_i = 0; object_i < objects.size(); ++object_i)
+        {
+            if (objects[object_i]) { classes[object_i]->Destructor(objects[object_i]); }
+        }
+    };
+
+    InputBuffers(const InputBuffers&) = delete;
+    InputBuffers& operator=(const InputBuffers&) = delete;
+};
+
+class Writer
+{
+private:
+    TTree* ttree;
+    TFile* tfile;
+    std::string ntuple_name;
+    bool initialized;
+    int compression;
+#ifdef RNTUPLE_SUPPORTED
+    std::vector<Field> fields;
+    std::unique_ptr<API::RNTupleWriter> writer;
+
+    template<typename Type>
+    static void copyScalar(TBranch* branch, void* value)
+    {
+        *static_cast<Type*>(value) = *reinterpret_cast<Type*>(branch->GetAddress());
+    };
+
+    template<typename Type>
+    static void copyVector(TBranch* branch, void* value)
+    {
+        *static_cast<std::vector<Type>*>(value) = *reinterpret_cast<std::vector<Type>*>(
+            static_cast<TBranchElement*>(branch)->GetObject()
+        );
+    };
+
+    template<typename Type>
+    static void copyArray(TBranch* branch, void* value)
+    {
+        const Type* values = reinterpret_cast<const Type*>(branch->GetAddress());
+        TLeaf* leaf = (TLeaf*) branch->GetListOfLeaves()->At(0);
+        static_cast<std::vector<Type>*>(value)->assign(values, values + leaf->GetLen());
+    };
+
+    template<typename Type>
+    void addField(API::RNTupleModel& model, TBranch* branch, Kind kind)
+    {
+        Field field;
+        field.branch = branch;
+        switch (kind)
+        {
+        case Scalar:
+            field.value = model.MakeField<Type>(branch->GetName());
+            field.copy = &copyScalar<Type>;
+            break;
+        case Vector:
+            field.value = model.MakeField<std::vector<Type>>(branch->GetName());
+            field.copy = &copyVector<Type>;
+            break;
+        case Array:
+            field.value = model.MakeField<std::vector<Type>>(branch->GetName());
+            field.copy = &copyArray<Type>;
+            break;
+        }
+        fields.push_back(field);
+    };
+
+    /* Field of a ROOT leaf type or of the element type of a std::vector (as the fixed-width type of
+       the same size, which is what RNTuple stores) */
+    void addField(API::RNTupleModel& model, TBranch* branch, std::string type_name, Kind kind)
+    {
+        if (type_name == "Double_t" || type_name == "double") { addField<double>(model, branch, kind); }
+        else if (type_name == "Float_t" || type_name == "float") { addField<float>(model, branch, kind); }
+        else if (type_name == "Long64_t" || type_name == "long long" || type_name == "Long_t" || type_name == "long")
+        {
+            addField<std::int64_t>(model, branch, kind);
+        }
+        else if (type_name == "ULong64_t" || type_name == "unsigned long long" || type_name == "ULong_t"
+                 || type_name == "unsigned long")
+        {
+            addField<std::uint64_t>(model, branch, kind);
+        }
+        else if (type_name == "Int_t" || type_name == "int") { addField<std::int32_t>(model, branch, kind); }
+        else if (type_name == "UInt_t" || type_name == "unsigned int") { addField<std::uint32_t>(model, branch, kind); }
+        else if (type_name == "Short_t" || type_name == "short") { addField<std::int16_t>(model, branch, kind); }
+        else if (type_name == "UShort_t" || type_name == "unsigned short")
+        {
+            addField<std::uint16_t>(model, branch, kind);
+        }
+        else if (type_name == "Char_t" || type_name == "char") { addField<std::int8_t>(model, branch, kind); }
+        else if (type_name == "UChar_t" || type_name == "unsigned char") { addField<std::uint8_t>(model, branch, kind); }
+        else if (type_name == "Bool_t" || type_name == "bool") { addField<bool>(model, branch, kind); }
+        else
+        {
+            throw std::runtime_error("RNTuples::Writer::addField - unsupported type " + type_name);
+        }
+    };
+#endif
+
+    void init()
+    {
+#ifdef RNTUPLE_SUPPORTED
+        std::unique_ptr<API::RNTupleModel> model = API::RNTupleModel::Create();
+        TObjArray* branches = ttree->GetListOfBranches();
+        for (int branch_i = 0; branch_i < branches->GetEntriesFast(); ++branch_i)
+        {
+            TBranch* branch = (TBranch*) branches->At(branch_i);
+            TBranchElement* branch_element = dynamic_cast<TBranchElement*>(branch);
+            if (branch_element)
+            {
+                TString class_name = branch_element->GetClassName();
+                if (!class_name.BeginsWith("vector<") || !class_name.EndsWith(">"))
+                {
+                    throw std::runtime_error(
+                        "RNTuples::Writer::init - unsupported class " + std::string(class_name.Data())
+                        + " of branch " + branch->GetName()
+                    );
+                }
+                addField(*model, branch, class_name(7, class_name.Length() - 8).Data(), Vector);
+            }
+            else
+            {
+                TLeaf* leaf = (TLeaf*) branch->GetListOfLeaves()->At(0);
+                if (branch->GetListOfLeaves()->GetEntriesFast() != 1 || leaf->GetLenStatic() != 1)
+                {
+                    throw std::runtime_error(
+                        "RNTuples::Writer::init - branch " + std::string(branch->GetName())
+                        + " is neither a scalar nor a leaf-count array"
+                    );
+                }
+                addField(*model, branch, leaf->GetTypeName(), (leaf->GetLeafCount()) ? Array : Scalar);
+            }
+        }
+        API::RNTupleWriteOptions options;
+        if (compression >= 0) { options.SetCompression(compression); }
+        writer = API::RNTupleWriter::Append(std::move(model), ntuple_name, *tfile, options);
+#else
+        throw std::runtime_error("RNTuples::Writer::init - RNTuple output needs ROOT 6.32 or later");
+#endif
+        initialized = true;
+    };
+
+public:
+    Writer(TTree* new_ttree, TFile* new_tfile, std::string new_ntuple_name)
+    : ttree(new_ttree), tfile(new_tfile), ntuple_name(new_ntuple_name), initialized(false), compression(-1)
+    {
+        // Do nothing
+    };
+
+    Writer(Arbol& arbol) : Writer(arbol.ttree, arbol.tfile, arbol.ttree->GetName())
+    {
+        // Do nothing
+    };
+
+    /* ROOT compression settings of the RNTuple (e.g. from Output::getCompression), before the first
+       fill; negative values keep the RNTuple default (zstd, level 5) */
+    void setCompression(int new_compression)
+    {
+        if (initialized)
+        {
+            throw std::runtime_error("RNTuples::Writer::setCompression - the RNTuple is already booked");
+        }
+        compression = new_compression;
+    };
+
+    /* Append the current values of all leaves */
+    void fill()
+    {
+        if (!initialized) { init(); }
+#ifdef RNTUPLE_SUPPORTED
+        for (auto& field : fields)
+        {
+            field.copy(field.branch, field.value.get());
+        }
+        writer->Fill();
+#endif
+    };
+
+    /* Commit the RNTuple to the file (which stays open) */
+    void write()
+    {
+        if (!initialized) { init(); }
+#ifdef RNTUPLE_SUPPORTED
+        writer.reset();
+#endif
+    };
+};
+
+} // End namespace RNTuples;
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef ROLEASSIGNMENT_H
+#define ROLEASSIGNMENT_H
+
+// STL
+#include <cmath>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <functional>
+
+/* Assignment of candidates (e.g. the good fat jets) to a list of named roles (e.g. Hbb, V1, V2),
+   each with its own score function (higher is better). Two strategies are available:
+
+       Sequential: roles are filled in order, each taking the best-scoring candidate left over
+                   (this is what SelectVVHFatJets has always done: max xbb, then max pt twice)
+       Optimal:    the assignment maximizing the summed score over all roles
+
+   The optimal assignment is found by an exhaustive depth-first search over the
+   N!/(N - R)! injective assignments, pruned with the best score still reachable for the
+   remaining roles; with the handful of fat jets in an event this is cheaper than setting up
+   the Hungarian algorithm. In both strategies ties go to the lowest candidate index (for
+   Optimal: the lexicographically first assignment), and if there are fewer candidates than
+   roles only the first n_candidates roles are filled. NaN scores (e.g. a ParticleNet ratio with
+   a zero denominator) count as -inf, so every role that can be filled is, whatever the scores.
+*/
+namespace RoleAssignment
+{
+
+typedef std::function<double(unsigned int)> Score; // score of candidate i for a role
+
+enum Strategy
+{
+    Sequential = 0,
+    Optimal
+};
+
+struct Role
+{
+    std::string name;
+    Score score;
+};
+
+struct Result
+{
+    std::vector<int> candidates; // candidate assigned to each role, -1 if unfilled
+    std::vector<double> scores;  // score of that candidate for that role
+    double total;
+
+    Result(unsigned int n_roles = 0) : candidates(n_roles, -1), scores(n_roles, -999), total(0.) {};
+
+    bool isComplete() const
+    {
+        for (auto& cand_i : candidates)
+        {
+            if (cand_i < 0) { return false; }
+        }
+        return true;
+    };
+};
+
+struct Solver
+{
+private:
+    std::vector<std::vector<double>> score_matrix; // n_roles x n_candidates
+    std::vector<double> max_remaining;             // best possible sum of role r, r+1, ...
+    std::vector<int> current;
+    std::vector<bool> used;
+    Result best;
+
+    void search(unsigned int role_i, double current_total)
+    {
+        if (role_i == current.size())
+        {
+            if (current_total > best.total || best.candidates[0] < 0)
+            {
+                best.total = current_total;
+                best.candidates = current;
+            }
+            return;
+        }
+        // Even the best remaining scores cannot beat the best assignment found so far
+        if (current_total + max_remaining[role_i] < best.total) { return; }
+        for (unsigned int cand_i = 0; cand_i < used.size(); ++cand_i)
+        {
+            if (used[cand_i]) { continue; }
+            used[cand_i] = true;
+            current[role_i] = cand_i;
+            search(role_i + 1, current_total + score_matrix[role_i][cand_i]);
+            used[cand_i] = false;
+        }
+    };
+
+public:
+    Result assign(const std::vector<Role>& roles, unsigned int n_candidates, Strategy strategy)
+    {
+        unsigned int n_filled = std::min((unsigned int)roles.size(), n_candidates);
+        Result result(roles.size());
+        if (n_filled == 0) { return result; }
+
+        // Evaluate every score once
+        score_matrix.assign(n_filled, std::vector<double>(n_candidates));
+        for (unsigned int role_i = 0; role_i < n_filled; ++role_i)
+        {
+            for (unsigned int cand_i = 0; cand_i < n_candidates; ++cand_i)
+            {
+                double score = roles[role_i].score(cand_i);
+                score_matrix[role_i][cand_i] = (std::isnan(score)) ? -std::numeric_limits<double>::infinity() : score;
+            }
+        }
+
+        if (strategy == Sequential)
+        {
+            used.assign(n_candidates, false);
+            for (unsigned int role_i = 0; role_i < n_filled; ++role_i)
+            {
+                int best_cand_i = -1;
+                for (unsigned int cand_i = 0; cand_i < n_candidates; ++cand_i)
+                {
+                    if (used[cand_i]) { continue; }
+                    if (best_cand_i < 0 || score_matrix[role_i][cand_i] > score_matrix[role_i][best_cand_i])
+                    {
+                        best_cand_i = cand_i;
+                    }
+                }
+                used[best_cand_i] = true;
+                result.candidates[role_i] = best_cand_i;
+            }
+        }
+        else
+        {
+            max_remaining.assign(n_filled + 1, 0.);
+            for (int role_i = n_filled - 1; role_i >= 0; --role_i)
+            {
+                double max_score = -std::numeric_limits<double>::infinity();
+                for (auto& score : score_matrix[role_i]) { max_score = std::max(max_score, score); }
+                max_remaining[role_i] = max_remaining[role_i + 1] + max_score;
+            }
+            current.assign(n_filled, -1);
+            used.assign(n_candidates, false);
+            best = Result(n_filled);
+            best.total = -std::numeric_limits<double>::infinity();
+            search(0, 0.);
+            for (unsigned int role_i = 0; role_i < n_filled; ++role_i)
+            {
+                result.candidates[role_i] = best.candidates[role_i];
+            }
+        }
+
+        for (unsigned int role_i = 0; role_i < n_filled; ++role_i)
+        {
+            if (result.candidates[role_i] < 0) { continue; }
+            result.scores[role_i] = score_matrix[role_i][result.candidates[role_i]];
+            result.total += result.scores[role_i];
+        }
+        return result;
+    };
+};
+
+} // End namespace RoleAssignment;
+
+#endif
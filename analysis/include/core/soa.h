@@ -0,0 +1,337 @@
+#ifndef SOA_H
+#define SOA_H
+
+// STL
+#include <vector>
+// NanoCORE
+#include "Nano.h"
+
+namespace SoA
+{
+
+typedef std::vector<float> Floats;
+typedef std::vector<int> Ints;
+
+/* Contiguous pt/eta/phi/mass arrays for one object collection. The arrays are filled at most once
+   per event (see SoA::Event) straight from the NanoAOD branches, so kernels can loop over
+   plain floats instead of building LorentzVectors element by element.
+*/
+struct Kinematics
+{
+    Floats pt;
+    Floats eta;
+    Floats phi;
+    Floats mass;
+
+    unsigned int size() const { return pt.size(); };
+
+    LorentzVector p4(unsigned int i) const
+    {
+        return LorentzVector(pt[i], eta[i], phi[i], mass[i]);
+    };
+
+    std::vector<LorentzVector> p4s() const
+    {
+        std::vector<LorentzVector> all_p4s;
+        all_p4s.reserve(size());
+        for (unsigned int i = 0; i < size(); ++i) { all_p4s.push_back(p4(i)); }
+        return all_p4s;
+    };
+
+    std::vector<LorentzVector> p4s(const Ints& idxs) const
+    {
+        std::vector<LorentzVector> selected_p4s;
+        selected_p4s.reserve(idxs.size());
+        for (auto& i : idxs) { selected_p4s.push_back(p4(i)); }
+        return selected_p4s;
+    };
+
+    void setP4(unsigned int i, const LorentzVector& new_p4)
+    {
+        pt[i] = new_p4.pt();
+        eta[i] = new_p4.eta();
+        phi[i] = new_p4.phi();
+        mass[i] = new_p4.mass();
+    };
+
+    void pushP4(const LorentzVector& new_p4)
+    {
+        pt.push_back(new_p4.pt());
+        eta.push_back(new_p4.eta());
+        phi.push_back(new_p4.phi());
+        mass.push_back(new_p4.mass());
+    };
+
+    void clear()
+    {
+        pt.clear();
+        eta.clear();
+        phi.clear();
+        mass.clear();
+    };
+};
+
+/* Lazy four-vector of object i of a Kinematics collection: pt, eta, phi and mass are read
+   straight from the arrays, and a LorentzVector (for the Cartesian components, sums, etc.) is
+   only built when asked for
+*/
+struct P4View
+{
+    const Kinematics* kinematics;
+    unsigned int i;
+
+    P4View(const Kinematics* kinematics_ptr, unsigned int obj_i) : kinematics(kinematics_ptr), i(obj_i) {};
+
+    float pt() const { return kinematics->pt[i]; };
+    float eta() const { return kinematics->eta[i]; };
+    float phi() const { return kinematics->phi[i]; };
+    float mass() const { return kinematics->mass[i]; };
+    float M() const { return kinematics->mass[i]; };
+
+    float px() const { return p4().px(); };
+    float py() const { return p4().py(); };
+    float pz() const { return p4().pz(); };
+    float E() const { return p4().E(); };
+    float P() const { return p4().P(); };
+
+    LorentzVector p4() const { return kinematics->p4(i); };
+    operator LorentzVector() const { return p4(); };
+};
+
+/* Lazy collection of the objects idxs (in order) of a Kinematics collection, e.g. the good jets
+   among all jets; copying it copies the indices, not the four-vectors. The views read the
+   arrays when they are accessed, so they see the kinematics of the current event.
+*/
+struct P4Views
+{
+    const Kinematics* kinematics;
+    Ints idxs;
+
+    P4Views() : kinematics(nullptr) {};
+
+    P4Views(const Kinematics& objects, const Ints& obj_idxs) : kinematics(&objects), idxs(obj_idxs) {};
+
+    explicit P4Views(const Kinematics& objects) : kinematics(&objects), idxs(objects.size())
+    {
+        for (unsigned int i = 0; i < idxs.size(); ++i) { idxs[i] = i; }
+    };
+
+    struct Iterator
+    {
+        const P4Views* views;
+        unsigned int i;
+
+        P4View operator*() const { return (*views)[i]; };
+        Iterator& operator++() { ++i; return *this; };
+        bool operator!=(const Iterator& other) const { return i != other.i; };
+    };
+
+    unsigned int size() const { return idxs.size(); };
+    bool empty() const { return idxs.empty(); };
+
+    P4View operator[](unsigned int i) const { return P4View(kinematics, idxs[i]); };
+    P4View at(unsigned int i) const { return P4View(kinematics, idxs.at(i)); };
+
+    Iterator begin() const { return {this, 0}; };
+    Iterator end() const { return {this, size()}; };
+
+    /* Materialized four-vectors, for code that needs a std::vector<LorentzVector> */
+    std::vector<LorentzVector> p4s() const
+    {
+        if (kinematics == nullptr) { return {}; }
+        return kinematics->p4s(idxs);
+    };
+
+    LorentzVector sum() const
+    {
+        LorentzVector total;
+        if (kinematics == nullptr) { return total; }
+        for (auto& i : idxs) { total += kinematics->p4(i); }
+        return total;
+    };
+};
+
+/* AK4 jets; kinematics are overwritten with the corrected (HEM, JEC, JER) values by
+   Core::SelectJets, which also fills good_idxs (indices into the Jet collection)
+*/
+struct Jets : Kinematics
+{
+    Ints jet_id;
+    Ints pu_id;
+    Ints hadron_flavour; // MC only
+    Floats btag_deepflav;
+    Ints good_idxs;
+
+    void load(Nano& nt)
+    {
+        pt = nt.Jet_pt();
+        eta = nt.Jet_eta();
+        phi = nt.Jet_phi();
+        mass = nt.Jet_mass();
+        jet_id = nt.Jet_jetId();
+        pu_id = nt.Jet_puId();
+        btag_deepflav = nt.Jet_btagDeepFlavB();
+        if (nt.isData()) { hadron_flavour.clear(); }
+        else { hadron_flavour = nt.Jet_hadronFlavour(); }
+        good_idxs.clear();
+    };
+};
+
+/* AK8 jets; kinematics are overwritten with the corrected (HEM, JEC) values by
+   Core::SelectFatJets, which also fills good_idxs (indices into the FatJet collection)
+*/
+struct FatJets : Kinematics
+{
+    Ints jet_id;
+    Floats msoftdrop;
+    Floats pnet_mass;     // ParticleNet regressed mass
+    Floats pnet_wvsqcd;   // ParticleNet tagger
+    Floats pnet_zvsqcd;   // ParticleNet tagger
+    Floats pnet_hbbvsqcd; // ParticleNet tagger
+    Floats pnetmd_xbb;    // ParticleNet mass-decorrelated raw scores
+    Floats pnetmd_xqq;
+    Floats pnetmd_xcc;
+    Floats pnetmd_qcd;
+    Ints good_idxs;
+
+    void load(Nano& nt)
+    {
+        pt = nt.FatJet_pt();
+        eta = nt.FatJet_eta();
+        phi = nt.FatJet_phi();
+        mass = nt.FatJet_mass();
+        jet_id = nt.FatJet_jetId();
+        msoftdrop = nt.FatJet_msoftdrop();
+        pnet_mass = nt.FatJet_particleNet_mass();
+        pnet_wvsqcd = nt.FatJet_particleNet_WvsQCD();
+        pnet_zvsqcd = nt.FatJet_particleNet_ZvsQCD();
+        pnet_hbbvsqcd = nt.FatJet_particleNet_HbbvsQCD();
+        pnetmd_xbb = nt.FatJet_particleNetMD_Xbb();
+        pnetmd_xqq = nt.FatJet_particleNetMD_Xqq();
+        pnetmd_xcc = nt.FatJet_particleNetMD_Xcc();
+        pnetmd_qcd = nt.FatJet_particleNetMD_QCD();
+        good_idxs.clear();
+    };
+};
+
+/* Electrons, muons, or a mix of both (e.g. the veto leptons selected by Core::SelectLeptons) */
+struct Leptons : Kinematics
+{
+    Ints pdgIDs;
+    Ints idxs;     // idx in the Electron or Muon collection
+    Ints jet_idxs; // idx of the matched jet in the Jet collection (as stored in NanoAOD)
+
+    void loadElectrons(Nano& nt)
+    {
+        pt = nt.Electron_pt();
+        eta = nt.Electron_eta();
+        phi = nt.Electron_phi();
+        mass = nt.Electron_mass();
+        fillIDs(nt.Electron_charge(), nt.Electron_jetIdx(), 11);
+    };
+
+    void loadMuons(Nano& nt)
+    {
+        pt = nt.Muon_pt();
+        eta = nt.Muon_eta();
+        phi = nt.Muon_phi();
+        mass = nt.Muon_mass();
+        fillIDs(nt.Muon_charge(), nt.Muon_jetIdx(), 13);
+    };
+
+    void fillIDs(const Ints& charges, const Ints& nano_jet_idxs, int abs_pdgID)
+    {
+        pdgIDs.resize(charges.size());
+        idxs.resize(charges.size());
+        jet_idxs = nano_jet_idxs;
+        for (unsigned int i = 0; i < charges.size(); ++i)
+        {
+            pdgIDs[i] = -charges[i]*abs_pdgID;
+            idxs[i] = i;
+        }
+    };
+
+    void push(const Leptons& other, unsigned int i)
+    {
+        pt.push_back(other.pt[i]);
+        eta.push_back(other.eta[i]);
+        phi.push_back(other.phi[i]);
+        mass.push_back(other.mass[i]);
+        pdgIDs.push_back(other.pdgIDs[i]);
+        idxs.push_back(other.idxs[i]);
+        jet_idxs.push_back(other.jet_idxs[i]);
+    };
+
+    void clear()
+    {
+        Kinematics::clear();
+        pdgIDs.clear();
+        idxs.clear();
+        jet_idxs.clear();
+    };
+};
+
+/* Per-event structure-of-arrays view of the core object collections, owned by Core::Analysis and
+   reset by Core::Bookkeeping before any other cut runs. Each collection is read from the NanoAOD
+   branches the first time it is accessed in an event, so the branches of a collection are only
+   read for events that reach a cut that uses it (e.g. not for events that fail the triggers).
+   Changes made to a collection (e.g. the corrected jet kinematics) last until the next reset.
+*/
+struct Event
+{
+    Leptons veto_leptons; // filled by Core::SelectLeptons
+
+    Event() : nt(nullptr), has_jets(false), has_fatjets(false), has_electrons(false), has_muons(false)
+    {
+        // Do nothing
+    };
+
+    void reset(Nano& nano)
+    {
+        nt = &nano;
+        has_jets = false;
+        has_fatjets = false;
+        has_electrons = false;
+        has_muons = false;
+        veto_leptons.clear();
+    };
+
+    Jets& jets()
+    {
+        if (!has_jets) { jet_arrays.load(*nt); has_jets = true; }
+        return jet_arrays;
+    };
+
+    FatJets& fatjets()
+    {
+        if (!has_fatjets) { fatjet_arrays.load(*nt); has_fatjets = true; }
+        return fatjet_arrays;
+    };
+
+    Leptons& electrons()
+    {
+        if (!has_electrons) { electron_arrays.loadElectrons(*nt); has_electrons = true; }
+        return electron_arrays;
+    };
+
+    Leptons& muons()
+    {
+        if (!has_muons) { muon_arrays.loadMuons(*nt); has_muons = true; }
+        return muon_arrays;
+    };
+
+private:
+    Nano* nt;
+    Jets jet_arrays;
+    FatJets fatjet_arrays;
+    Leptons electron_arrays;
+    Leptons muon_arrays;
+    bool has_jets;
+    bool has_fatjets;
+    bool has_electrons;
+    bool has_muons;
+};
+
+} // End namespace SoA;
+
+#endif
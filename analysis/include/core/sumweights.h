@@ -0,0 +1,195 @@
+#ifndef SUMWEIGHTS_H
+#define SUMWEIGHTS_H
+
+// STL
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+// ROOT
+#include "TTree.h"
+#include "TLeaf.h"
+// NanoCORE
+#include "Nano.h"
+
+/* Sums of weights of the LHE scale, LHE PDF, parton shower and LHE reweighting variations, for
+   every index of each, over all generated events. Dividing the selected yield of a variation by
+   its sum (instead of the nominal sum) gives the shape-only effect of that variation, which is
+   what the datacards need.
+
+   The studies run on skims, so the totals come from the Runs tree of each input file, which every
+   skim carries over as it is (see Core::Skimmer), and which is read once per file by
+   Core::Analysis::init: genEventCount, genEventSumw and genEventSumw2 as they are, and the
+   variations as LHEScaleSumw, LHEPdfSumw, PSSumw (and LHEReweightingSumw, if the sample has it)
+   times genEventSumw, since NanoAOD stores them normalized to genEventSumw. Indices missing from
+   a file count as w_var / w_nominal = 1, matching SaveSystWeights. Files without a Runs tree (e.g.
+   private samples) are skipped with a warning, and their generated events are then missing from
+   the totals.
+
+   The same sums are also accumulated event by event over the events that reach the Bookkeeping
+   cut, i.e. those that passed the skim. On unskimmed input, where both count the same events,
+   the two must agree, and write() warns if they do not; both are written to the JSON, which
+   Core::Analysis writes next to the cutflow at the end of every MC job.
+*/
+struct SumOfWeights
+{
+    struct Sums
+    {
+        long long n_events;
+        double sumw;
+        double sumw2;
+        std::vector<double> lhe_scale_sumws;
+        std::vector<double> lhe_pdf_sumws;
+        std::vector<double> ps_sumws;
+        std::vector<double> lhe_reweighting_sumws;
+
+        Sums()
+        {
+            n_events = 0;
+            sumw = 0.;
+            sumw2 = 0.;
+        };
+    };
+
+private:
+    template<typename Type>
+    static void accumulate(std::vector<double>& sums, const std::vector<Type>& ratios,
+                           double gen_weight, double sumw_before)
+    {
+        // New indices start at the nominal sum so far, i.e. as if all previous events had w_var = w_nominal
+        if (ratios.size() > sums.size()) { sums.resize(ratios.size(), sumw_before); }
+        for (unsigned int var_i = 0; var_i < sums.size(); ++var_i)
+        {
+            sums[var_i] += gen_weight*((var_i < ratios.size()) ? ratios[var_i] : 1.);
+        }
+    };
+
+    /* Values of a leaf of the current entry of a TTree (none if the TTree has no such leaf) */
+    static std::vector<double> leafValues(TTree* ttree, std::string leaf_name)
+    {
+        std::vector<double> values;
+        TLeaf* leaf = ttree->GetLeaf(leaf_name.c_str());
+        if (leaf == nullptr) { return values; }
+        for (int value_i = 0; value_i < leaf->GetLen(); ++value_i) { values.push_back(leaf->GetValue(value_i)); }
+        return values;
+    };
+
+    static void writeArray(std::ofstream& output_stream, std::string indent, std::string key,
+                           const std::vector<double>& sums, bool is_last = false)
+    {
+        output_stream << indent << "\"" << key << "\": [";
+        for (unsigned int var_i = 0; var_i < sums.size(); ++var_i)
+        {
+            output_stream << ((var_i == 0) ? "" : ", ") << sums.at(var_i);
+        }
+        output_stream << "]" << ((is_last) ? "\n" : ",\n");
+    };
+
+    static void writeSums(std::ofstream& output_stream, std::string indent, const Sums& sums, bool is_last)
+    {
+        output_stream << indent << "\"n_events\": " << sums.n_events << ",\n";
+        output_stream << indent << "\"sumw\": " << sums.sumw << ",\n";
+        output_stream << indent << "\"sumw2\": " << sums.sumw2 << ",\n";
+        writeArray(output_stream, indent, "LHEScaleWeight", sums.lhe_scale_sumws);
+        writeArray(output_stream, indent, "LHEPdfWeight", sums.lhe_pdf_sumws);
+        writeArray(output_stream, indent, "PSWeight", sums.ps_sumws);
+        writeArray(output_stream, indent, "LHEReweightingWeight", sums.lhe_reweighting_sumws, is_last);
+    };
+
+public:
+    Sums runs;      // all generated events, from the Runs trees
+    Sums events;    // events seen by the study, for a cross-check on unskimmed input
+    std::vector<std::string> files_without_runs;
+
+    SumOfWeights()
+    {
+        // Do nothing
+    };
+
+    /* Add the totals of the Runs tree of an input file */
+    void add(TTree* runs_ttree)
+    {
+        for (Long64_t entry = 0; entry < runs_ttree->GetEntries(); ++entry)
+        {
+            runs_ttree->GetEntry(entry);
+            std::vector<double> gen_event_sumw = leafValues(runs_ttree, "genEventSumw");
+            if (gen_event_sumw.empty())
+            {
+                throw std::runtime_error("SumOfWeights::add - no genEventSumw in the Runs tree");
+            }
+            double sumw = gen_event_sumw.at(0);
+            double sumw_before = runs.sumw;
+            std::vector<double> gen_event_count = leafValues(runs_ttree, "genEventCount");
+            std::vector<double> gen_event_sumw2 = leafValues(runs_ttree, "genEventSumw2");
+            runs.n_events += (gen_event_count.empty()) ? 0 : std::llround(gen_event_count.at(0));
+            runs.sumw += sumw;
+            runs.sumw2 += (gen_event_sumw2.empty()) ? 0. : gen_event_sumw2.at(0);
+            accumulate(runs.lhe_scale_sumws, leafValues(runs_ttree, "LHEScaleSumw"), sumw, sumw_before);
+            accumulate(runs.lhe_pdf_sumws, leafValues(runs_ttree, "LHEPdfSumw"), sumw, sumw_before);
+            accumulate(runs.ps_sumws, leafValues(runs_ttree, "PSSumw"), sumw, sumw_before);
+            accumulate(runs.lhe_reweighting_sumws, leafValues(runs_ttree, "LHEReweightingSumw"), sumw, sumw_before);
+        }
+    };
+
+    /* Add an event seen by the study (cross-check only) */
+    void fill(Nano& nt, bool has_lhe = true)
+    {
+        double gen_weight = nt.genWeight();
+        double sumw_before = events.sumw;
+        events.n_events++;
+        events.sumw += gen_weight;
+        events.sumw2 += gen_weight*gen_weight;
+        accumulate(events.ps_sumws, nt.PSWeight(), gen_weight, sumw_before);
+        if (has_lhe)
+        {
+            accumulate(events.lhe_scale_sumws, nt.LHEScaleWeight(), gen_weight, sumw_before);
+            accumulate(events.lhe_pdf_sumws, nt.LHEPdfWeight(), gen_weight, sumw_before);
+            accumulate(events.lhe_reweighting_sumws, nt.LHEReweightingWeight(), gen_weight, sumw_before);
+        }
+        else
+        {
+            accumulate(events.lhe_scale_sumws, std::vector<float>(), gen_weight, sumw_before);
+            accumulate(events.lhe_pdf_sumws, std::vector<float>(), gen_weight, sumw_before);
+            accumulate(events.lhe_reweighting_sumws, std::vector<float>(), gen_weight, sumw_before);
+        }
+    };
+
+    /* Leave out a file without a Runs tree */
+    void skip(std::string file_name)
+    {
+        std::cerr << "SumOfWeights::skip - WARNING: no Runs tree in " << file_name
+                  << ", its generated events are left out of the sums of weights" << std::endl;
+        files_without_runs.push_back(file_name);
+    };
+
+    /* Write as JSON, e.g. next to the cutflow: {output_dir}/{output_name}_SumOfWeights.json; the
+       totals from the Runs trees are at the top level, the events seen by the study under "events" */
+    void write(std::string output_file)
+    {
+        if (!files_without_runs.empty())
+        {
+            std::cerr << "SumOfWeights::write - WARNING: " << files_without_runs.size() << " input file(s) had no Runs "
+                      << "tree, so the totals miss their generated events (first: " << files_without_runs.front()
+                      << ")" << std::endl;
+        }
+        if (runs.n_events == events.n_events && std::abs(runs.sumw - events.sumw) > 1e-6*std::abs(runs.sumw))
+        {
+            std::cerr << "SumOfWeights::write - WARNING: the input looks unskimmed (" << runs.n_events
+                      << " events), but the sum of genWeight over its events (" << events.sumw
+                      << ") differs from the genEventSumw of its Runs trees (" << runs.sumw << ")" << std::endl;
+        }
+        std::ofstream output_stream(output_file);
+        output_stream << std::setprecision(17);
+        output_stream << "{\n";
+        writeSums(output_stream, "    ", runs, false);
+        output_stream << "    \"events\": {\n";
+        writeSums(output_stream, "        ", events, true);
+        output_stream << "    }\n";
+        output_stream << "}\n";
+    };
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef CORE_TRIGGERS_H
+#define CORE_TRIGGERS_H
+
+// STL
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+// ROOT
+#include "TTree.h"
+// NanoCORE
+#include "Nano.h"
+
+/* Per-file resolution of HLT paths. Not every path exists in every era, and the NanoCORE
+   accessor of a missing path throws, so cuts used to wrap each nt.HLT_*() call in try/catch
+   and switch on the year every event. Instead, paths are registered once (one bit each) as
+   part of named groups, e.g. "SingleMuon" = HLT_IsoMu24 || HLT_IsoTkMu24 in 2016; on each new
+   file (Triggers::Resolver::init, called by Core::Analysis::init) the branches that exist are
+   looked up and every group is compiled into a bitmask of its paths that are present for the
+   year of that file. Per event, fire() calls only the accessors of present paths that are in
+   some group and returns their bits, so testing a group is an AND with its mask.
+
+       Triggers::Resolver triggers;
+       unsigned int group_i = triggers.addGroup("SingleMuon", 2016, {HLT_PATH(HLT_IsoMu24)});
+       ...
+       Triggers::Bits fired = triggers.fire(nt);
+       bool passed = triggers.passes(group_i, fired);
+*/
+#define HLT_PATH(NAME) Triggers::Path({#NAME, [](Nano& nt) -> bool { return nt.NAME(); }})
+
+namespace Triggers
+{
+
+typedef uint64_t Bits;
+typedef bool (*Accessor)(Nano& nt);
+
+struct Path
+{
+    std::string name;
+    Accessor fired;
+};
+
+struct Resolver
+{
+private:
+    std::vector<Path> paths;                        // bit i <-> paths.at(i)
+    std::vector<std::string> group_names;
+    std::vector<std::map<int, Bits>> group_year_masks; // group -> year -> configured paths
+    std::vector<Bits> group_masks;                  // group -> paths present in the current file
+    std::vector<unsigned int> active_paths;         // paths present and used by some group
+    int year;
+    unsigned int file_index;
+
+    unsigned int addPath(const Path& path)
+    {
+        for (unsigned int path_i = 0; path_i < paths.size(); ++path_i)
+        {
+            if (paths.at(path_i).name == path.name) { return path_i; }
+        }
+        if (paths.size() == 8*sizeof(Bits))
+        {
+            throw std::runtime_error("Triggers::Resolver::addPath - too many HLT paths");
+        }
+        paths.push_back(path);
+        return paths.size() - 1;
+    };
+
+public:
+    Resolver()
+    {
+        year = -999;
+        file_index = 0;
+    };
+
+    /* Add paths to the OR for a given year; returns the group index used by passes() */
+    unsigned int addGroup(std::string group_name, int group_year, std::vector<Path> group_paths)
+    {
+        unsigned int group_i = getGroup(group_name, false);
+        if (group_i == group_names.size())
+        {
+            group_names.push_back(group_name);
+            group_year_masks.push_back({});
+            group_masks.push_back(0);
+        }
+        Bits& mask = group_year_masks.at(group_i)[group_year];
+        for (auto& path : group_paths) { mask |= (Bits(1) << addPath(path)); }
+        return group_i;
+    };
+
+    unsigned int getGroup(std::string group_name, bool required = true)
+    {
+        for (unsigned int group_i = 0; group_i < group_names.size(); ++group_i)
+        {
+            if (group_names.at(group_i) == group_name) { return group_i; }
+        }
+        if (required)
+        {
+            throw std::runtime_error("Triggers::Resolver::getGroup - no trigger group named " + group_name);
+        }
+        return group_names.size();
+    };
+
+    /* Find the paths present in a new file and compile the group masks for its year */
+    void init(TTree* ttree, int file_year)
+    {
+        if (ttree == nullptr)
+        {
+            throw std::runtime_error("Triggers::Resolver::init - no TTree to resolve HLT paths from");
+        }
+        year = file_year;
+        file_index++;
+        Bits present = 0;
+        for (unsigned int path_i = 0; path_i < paths.size(); ++path_i)
+        {
+            if (ttree->GetBranch(paths.at(path_i).name.c_str()) != nullptr)
+            {
+                present |= (Bits(1) << path_i);
+            }
+        }
+        Bits used = 0;
+        for (unsigned int group_i = 0; group_i < group_names.size(); ++group_i)
+        {
+            const std::map<int, Bits>& year_masks = group_year_masks.at(group_i);
+            auto year_mask = year_masks.find(year);
+            group_masks.at(group_i) = (year_mask == year_masks.end()) ? 0 : (year_mask->second & present);
+            used |= group_masks.at(group_i);
+        }
+        active_paths.clear();
+        for (unsigned int path_i = 0; path_i < paths.size(); ++path_i)
+        {
+            if (used & (Bits(1) << path_i)) { active_paths.push_back(path_i); }
+        }
+    };
+
+    /* Bits of the fired paths among those used by any group in the current file */
+    Bits fire(Nano& nt) const
+    {
+        Bits fired = 0;
+        for (auto& path_i : active_paths)
+        {
+            fired |= (Bits(paths[path_i].fired(nt)) << path_i);
+        }
+        return fired;
+    };
+
+    bool passes(unsigned int group_i, Bits fired) const
+    {
+        return (fired & group_masks[group_i]) != 0;
+    };
+
+    int getYear() const { return year; };
+
+    /* Incremented by every init(), so cuts can cache other per-file quantities */
+    unsigned int getFileIndex() const { return file_index; };
+};
+
+} // End namespace Triggers;
+
+#endif
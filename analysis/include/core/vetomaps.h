@@ -0,0 +1,363 @@
+#ifndef CORE_VETOMAPS_H
+#define CORE_VETOMAPS_H
+
+// STL
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+// VBS
+#include "core/soa.h"           // SoA::Kinematics, SoA::Floats, SoA::Ints
+// ROOT
+#include "TFile.h"
+#include "TH2.h"
+#include "TString.h"
+// NanoCORE
+#include "Nano.h"
+
+/* Eta-phi maps of detector regions that objects are vetoed in (e.g. the JME jet veto maps) or
+   scaled in (e.g. the HEM15/16 prescription). Every map is a flat table of one float per
+   (eta, phi) bin, so a query is two bin lookups and one load:
+
+       Veto:  objects in a bin with a non-zero value are vetoed
+       Scale: pt and mass of objects are multiplied by the value of their bin
+
+   A map is applied together with a condition on the event (e.g. 2018 MC only). The maps in use
+   are held by a VetoMaps::Engine, which Core::Analysis owns and which starts out with the HEM
+   configuration (see VetoMaps::HEM); analyses add, replace or remove maps by name, e.g. with
+   the official maps of the campaign of each new file (see JetVetoMaps):
+
+       jet_veto_maps.init(nt.year(), gconf.isAPV);         // in Analysis::init
+       analysis.veto_maps.set(jet_veto_maps.config());
+       ...
+       bool vetoed = veto_maps.anyVetoed(soa.jets(), nt);  // or the Core::PassesVetoMaps cut
+*/
+namespace VetoMaps
+{
+
+typedef std::vector<unsigned char> Mask; // 1 = vetoed
+
+/* Bin edges along eta or phi; uniform axes are looked up arithmetically, others by bisection */
+struct Axis
+{
+    std::vector<double> edges;
+    bool uniform;
+    bool open; // if true, values exactly on an edge are outside of every bin
+
+    Axis() : uniform(false), open(false) {};
+
+    Axis(unsigned int n_bins, double low, double high) : uniform(true), open(false)
+    {
+        if (n_bins == 0 || !(high > low))
+        {
+            throw std::runtime_error("VetoMaps::Axis - invalid binning");
+        }
+        for (unsigned int bin_i = 0; bin_i <= n_bins; ++bin_i)
+        {
+            edges.push_back(low + bin_i*(high - low)/n_bins);
+        }
+    };
+
+    Axis(std::vector<double> bin_edges, bool open_edges = false)
+    : edges(bin_edges), uniform(false), open(open_edges)
+    {
+        if (edges.size() < 2 || !std::is_sorted(edges.begin(), edges.end()))
+        {
+            throw std::runtime_error("VetoMaps::Axis - bin edges must be sorted, with at least one bin");
+        }
+    };
+
+    unsigned int nBins() const { return edges.size() - 1; };
+
+    /* Bin of x, or -1 if x is outside of the axis (or NaN) */
+    int find(double x) const
+    {
+        const double low = edges.front();
+        const double high = edges.back();
+        if (!(x >= low && x < high)) { return -1; }
+        int bin_i;
+        if (uniform)
+        {
+            bin_i = std::min(int(nBins()*(x - low)/(high - low)), int(nBins()) - 1);
+        }
+        else
+        {
+            bin_i = std::upper_bound(edges.begin(), edges.end(), x) - edges.begin() - 1;
+        }
+        if (open && x == edges[bin_i]) { return -1; }
+        return bin_i;
+    };
+};
+
+struct Map
+{
+    Axis eta_axis;
+    Axis phi_axis;
+    std::vector<float> table; // bin (eta_i, phi_i) at eta_i*n_phi_bins + phi_i
+    float outside;            // value everywhere outside of the axes
+
+    Map() : outside(0.f) {};
+
+    Map(Axis new_eta_axis, Axis new_phi_axis, float outside_value = 0.f)
+    : eta_axis(new_eta_axis), phi_axis(new_phi_axis), outside(outside_value)
+    {
+        table.assign(eta_axis.nBins()*phi_axis.nBins(), outside);
+    };
+
+    void set(unsigned int eta_i, unsigned int phi_i, float value)
+    {
+        table.at(eta_i*phi_axis.nBins() + phi_i) = value;
+    };
+
+    float get(float eta, float phi) const
+    {
+        int eta_i = eta_axis.find(eta);
+        int phi_i = phi_axis.find(phi);
+        if (eta_i < 0 || phi_i < 0) { return outside; }
+        return table[eta_i*phi_axis.nBins() + phi_i];
+    };
+
+    void fill(const SoA::Kinematics& objects, SoA::Floats& values) const
+    {
+        values.resize(objects.size());
+        for (unsigned int obj_i = 0; obj_i < objects.size(); ++obj_i)
+        {
+            values[obj_i] = get(objects.eta[obj_i], objects.phi[obj_i]);
+        }
+    };
+};
+
+/* Rectangular region; the bounds themselves are outside of it */
+struct Box
+{
+    double eta_low;
+    double eta_high;
+    double phi_low;
+    double phi_high;
+    float value;
+};
+
+/* Map on the grid spanned by the box edges; where boxes overlap, the first one wins */
+inline Map fromBoxes(std::vector<Box> boxes, float outside = 0.f)
+{
+    std::vector<double> eta_edges;
+    std::vector<double> phi_edges;
+    for (auto& box : boxes)
+    {
+        if (!(box.eta_high > box.eta_low && box.phi_high > box.phi_low))
+        {
+            throw std::runtime_error("VetoMaps::fromBoxes - empty box");
+        }
+        eta_edges.insert(eta_edges.end(), {box.eta_low, box.eta_high});
+        phi_edges.insert(phi_edges.end(), {box.phi_low, box.phi_high});
+    }
+    for (auto edges : {&eta_edges, &phi_edges})
+    {
+        std::sort(edges->begin(), edges->end());
+        edges->erase(std::unique(edges->begin(), edges->end()), edges->end());
+    }
+    Map map(Axis(eta_edges, true), Axis(phi_edges, true), outside);
+    for (unsigned int eta_i = 0; eta_i < map.eta_axis.nBins(); ++eta_i)
+    {
+        double eta = 0.5*(eta_edges[eta_i] + eta_edges[eta_i + 1]);
+        for (unsigned int phi_i = 0; phi_i < map.phi_axis.nBins(); ++phi_i)
+        {
+            double phi = 0.5*(phi_edges[phi_i] + phi_edges[phi_i + 1]);
+            for (auto& box : boxes)
+            {
+                if (eta > box.eta_low && eta < box.eta_high && phi > box.phi_low && phi < box.phi_high)
+                {
+                    map.set(eta_i, phi_i, box.value);
+                    break;
+                }
+            }
+        }
+    }
+    return map;
+};
+
+/* Map with the binning and contents of a TH2 (x = eta, y = phi; ROOT bin conventions) */
+inline Map fromTH2(TH2* hist, float outside = 0.f)
+{
+    if (hist == nullptr)
+    {
+        throw std::runtime_error("VetoMaps::fromTH2 - no histogram");
+    }
+    Axis axes[2];
+    TAxis* hist_axes[2] = {hist->GetXaxis(), hist->GetYaxis()};
+    for (unsigned int axis_i = 0; axis_i < 2; ++axis_i)
+    {
+        TAxis* hist_axis = hist_axes[axis_i];
+        if (hist_axis->IsVariableBinSize())
+        {
+            std::vector<double> edges;
+            for (int bin_i = 1; bin_i <= hist_axis->GetNbins() + 1; ++bin_i)
+            {
+                edges.push_back(hist_axis->GetBinLowEdge(bin_i));
+            }
+            axes[axis_i] = Axis(edges);
+        }
+        else
+        {
+            axes[axis_i] = Axis(hist_axis->GetNbins(), hist_axis->GetXmin(), hist_axis->GetXmax());
+        }
+    }
+    Map map(axes[0], axes[1], outside);
+    for (unsigned int eta_i = 0; eta_i < map.eta_axis.nBins(); ++eta_i)
+    {
+        for (unsigned int phi_i = 0; phi_i < map.phi_axis.nBins(); ++phi_i)
+        {
+            map.set(eta_i, phi_i, hist->GetBinContent(eta_i + 1, phi_i + 1));
+        }
+    }
+    return map;
+};
+
+inline Map fromTH2(TString file_name, TString hist_name, float outside = 0.f)
+{
+    TFile* tfile = TFile::Open(file_name);
+    if (tfile == nullptr || tfile->IsZombie())
+    {
+        throw std::runtime_error("VetoMaps::fromTH2 - "+file_name+" not found");
+    }
+    TH2* hist = (TH2*) tfile->Get(hist_name);
+    if (hist == nullptr)
+    {
+        throw std::runtime_error("VetoMaps::fromTH2 - no "+hist_name+" in "+file_name);
+    }
+    Map map = fromTH2(hist, outside);
+    tfile->Close();
+    return map;
+};
+
+enum Action
+{
+    Veto = 0,
+    Scale
+};
+
+typedef bool (*Condition)(Nano& nt); // whether a map applies to the current event
+
+inline bool always(Nano& nt) { return true; };
+
+struct Config
+{
+    std::string name;
+    Action action;
+    Map map;
+    Condition applies;
+};
+
+/* HEM15/16 prescription (2018 MC, fraction of events matching the affected data) */
+inline bool hasHEMIssue(Nano& nt)
+{
+    return (!nt.isData() && nt.year() == 2018 && nt.event() % 1961 < 1286);
+};
+
+/* Jets in the HEM15/16 hole lose 20% (-2.5 < eta < -1.3) or 35% (-3.0 < eta < -2.5) */
+inline Config HEM()
+{
+    Map map = fromBoxes(
+        {
+            {-2.5, -1.3, -1.57, -0.87, 0.8f},
+            {-3.0, -2.5, -1.57, -0.87, 0.65f}
+        },
+        1.f
+    );
+    return {"HEM", Scale, map, hasHEMIssue};
+};
+
+struct Engine
+{
+private:
+    std::vector<Config> configs;
+
+    int find(std::string name) const
+    {
+        for (unsigned int config_i = 0; config_i < configs.size(); ++config_i)
+        {
+            if (configs.at(config_i).name == name) { return config_i; }
+        }
+        return -1;
+    };
+
+public:
+    /* Add a map, or replace the one with the same name (e.g. for the campaign of a new file) */
+    void set(Config config)
+    {
+        if (config.applies == nullptr) { config.applies = always; }
+        int config_i = find(config.name);
+        if (config_i < 0) { configs.push_back(config); }
+        else { configs.at(config_i) = config; }
+    };
+
+    void remove(std::string name)
+    {
+        int config_i = find(name);
+        if (config_i >= 0) { configs.erase(configs.begin() + config_i); }
+    };
+
+    bool has(std::string name) const { return find(name) >= 0; };
+
+    const Config& get(std::string name) const
+    {
+        int config_i = find(name);
+        if (config_i < 0)
+        {
+            throw std::runtime_error("VetoMaps::Engine::get - no veto map named " + name);
+        }
+        return configs.at(config_i);
+    };
+
+    /* The Scale maps that apply to this event, in the order they were set; their values at an
+       object multiply its four-vector (e.g. see JetCorrections::Corrector)
+    */
+    void scaleMaps(Nano& nt, std::vector<const Map*>& maps) const
+    {
+        maps.clear();
+        for (auto& config : configs)
+        {
+            if (config.action == Scale && config.applies(nt)) { maps.push_back(&config.map); }
+        }
+    };
+
+    /* Objects in a region vetoed by any Veto map that applies to this event */
+    Mask vetoed(const SoA::Kinematics& objects, Nano& nt) const
+    {
+        Mask mask(objects.size(), 0);
+        for (auto& config : configs)
+        {
+            if (config.action != Veto || !config.applies(nt)) { continue; }
+            for (unsigned int obj_i = 0; obj_i < objects.size(); ++obj_i)
+            {
+                mask[obj_i] |= (config.map.get(objects.eta[obj_i], objects.phi[obj_i]) != 0.f);
+            }
+        }
+        return mask;
+    };
+
+    /* Event-level veto: true if any of the given objects is in a vetoed region */
+    bool anyVetoed(const SoA::Kinematics& objects, const SoA::Ints& idxs, Nano& nt) const
+    {
+        for (auto& config : configs)
+        {
+            if (config.action != Veto || !config.applies(nt)) { continue; }
+            for (auto& obj_i : idxs)
+            {
+                if (config.map.get(objects.eta[obj_i], objects.phi[obj_i]) != 0.f) { return true; }
+            }
+        }
+        return false;
+    };
+
+    bool anyVetoed(const SoA::Kinematics& objects, Nano& nt) const
+    {
+        SoA::Ints idxs(objects.size());
+        for (unsigned int obj_i = 0; obj_i < objects.size(); ++obj_i) { idxs[obj_i] = obj_i; }
+        return anyVetoed(objects, idxs, nt);
+    };
+};
+
+} // End namespace VetoMaps;
+
+#endif
@@ -6,6 +6,7 @@
 #include "pileup.h"
 #include "leptons.h"
 #include "jets.h"
+#include "jetvetomaps.h"
 #include "btags.h"
 #include "particlenet.h"
 #include "qcd.h"
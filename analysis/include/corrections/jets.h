@@ -3,6 +3,7 @@
 
 // STL
 #include <string>
+#include <vector>
 // ROOT
 #include "TRandom3.h"
 // NanoCORE
@@ -76,31 +77,48 @@ struct JetEnergyScales
         );
     };
 
-    LorentzVector applyAK4JEC(LorentzVector jet_p4)
+    /* Factor that the jet four-vector is scaled by (1 if JECs are not varied) */
+    float getAK4JECScale(float jet_pt, float jet_eta)
     {
-        if (abs(jec_var) != 2) { return jet_p4; }
-        ak4_jec_unc->setJetEta(jet_p4.eta());
-        ak4_jec_unc->setJetPt(jet_p4.pt());
+        if (abs(jec_var) != 2) { return 1.f; }
+        ak4_jec_unc->setJetEta(jet_eta);
+        ak4_jec_unc->setJetPt(jet_pt);
         float jec_err = fabs(ak4_jec_unc->getUncertainty(jec_var == 2))*jec_var/2;
-        return jet_p4*(1. + jec_err);
+        return 1. + jec_err;
     };
 
-    LorentzVector applyAK8JEC(LorentzVector fatjet_p4)
+    float getAK8JECScale(float fatjet_pt, float fatjet_eta)
     {
-        if (abs(jec_var) != 2) { return fatjet_p4; }
-        ak8_jec_unc->setJetEta(fatjet_p4.eta());
-        ak8_jec_unc->setJetPt(fatjet_p4.pt());
+        if (abs(jec_var) != 2) { return 1.f; }
+        ak8_jec_unc->setJetEta(fatjet_eta);
+        ak8_jec_unc->setJetPt(fatjet_pt);
         float jec_err = fabs(ak8_jec_unc->getUncertainty(jec_var == 2))*jec_var/2;
-        return fatjet_p4*(1. + jec_err);
+        return 1. + jec_err;
     };
 
-    LorentzVector applyJER(int seed, LorentzVector jet_p4, float rho, std::vector<LorentzVector> gen_jet_p4s)
+    LorentzVector applyAK4JEC(LorentzVector jet_p4)
+    {
+        return jet_p4*getAK4JECScale(jet_p4.pt(), jet_p4.eta());
+    };
+
+    LorentzVector applyAK8JEC(LorentzVector fatjet_p4)
+    {
+        return fatjet_p4*getAK8JECScale(fatjet_p4.pt(), fatjet_p4.eta());
+    };
+
+    /* Smear the jet four-vector in place */
+    void smearJER(int seed, LorentzVector& jet_p4, float rho, const std::vector<LorentzVector>& gen_jet_p4s)
     {
         random_num.SetSeed(seed);
         jer_unc->setJetEta(jet_p4.eta());
         jer_unc->setJetPt(jet_p4.pt());
         jer_unc->setRho(rho);
         jer_unc->applyJER(jet_p4, jer_var, gen_jet_p4s, random_num);
+    };
+
+    LorentzVector applyJER(int seed, LorentzVector jet_p4, float rho, const std::vector<LorentzVector>& gen_jet_p4s)
+    {
+        smearJER(seed, jet_p4, rho, gen_jet_p4s);
         return jet_p4;
     };
 };
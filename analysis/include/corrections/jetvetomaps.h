@@ -0,0 +1,135 @@
+#ifndef JETVETOMAPS_H
+#define JETVETOMAPS_H
+
+// STL
+#include <cmath>
+#include <string>
+#include <vector>
+#include <stdexcept>
+// VBS
+#include "core/vetomaps.h"      // VetoMaps::Map, VetoMaps::Axis, VetoMaps::Config
+// CMSSW
+#include "correction.h"
+
+namespace VetoMaps
+{
+
+/* Bin edges of a correctionlib (eta, phi) correction along one axis, within the range of the
+   given scan axis. correctionlib does not expose the bin edges, so the correction is sampled at
+   the centers of the scan bins (for every bin of the other axis), and wherever two neighbouring
+   samples differ the edge between them is bisected down to adjacent doubles. Edges between bins
+   with the same value everywhere are not found, but they do not change any lookup either; the
+   scan bins must be narrower than the bins of the correction.
+*/
+inline std::vector<double> findEdges(correction::Correction::Ref corr, std::string map_type,
+                                     const Axis& scan_axis, const Axis& other_axis, bool scan_eta)
+{
+    auto evaluate = [&](double x, double other) -> double
+    {
+        return (scan_eta) ? corr->evaluate({map_type, x, other}) : corr->evaluate({map_type, other, x});
+    };
+    std::vector<double> edges = {scan_axis.edges.front()};
+    for (unsigned int bin_i = 0; bin_i + 1 < scan_axis.nBins(); ++bin_i)
+    {
+        double low = 0.5*(scan_axis.edges[bin_i] + scan_axis.edges[bin_i + 1]);
+        double high = 0.5*(scan_axis.edges[bin_i + 1] + scan_axis.edges[bin_i + 2]);
+        for (unsigned int other_i = 0; other_i < other_axis.nBins(); ++other_i)
+        {
+            double other = 0.5*(other_axis.edges[other_i] + other_axis.edges[other_i + 1]);
+            double low_value = evaluate(low, other);
+            if (evaluate(high, other) == low_value) { continue; }
+            // Smallest x with a different value than at low, i.e. the (inclusive) lower edge of the next bin
+            while (std::nextafter(low, high) < high)
+            {
+                double mid = 0.5*(low + high);
+                if (evaluate(mid, other) == low_value) { low = mid; }
+                else { high = mid; }
+            }
+            edges.push_back(high);
+            break;
+        }
+    }
+    edges.push_back(scan_axis.edges.back());
+    return edges;
+};
+
+/* Map with the bins of a correctionlib (eta, phi) correction (see findEdges) over the range of
+   the given scan axes, filled with its value at the center of each bin; outside of that range
+   every object gets the outside value
+*/
+inline Map fromCorrection(correction::Correction::Ref corr, std::string map_type, Axis eta_scan_axis,
+                          Axis phi_scan_axis, float outside = 0.f)
+{
+    Axis eta_axis(findEdges(corr, map_type, eta_scan_axis, phi_scan_axis, true));
+    Axis phi_axis(findEdges(corr, map_type, phi_scan_axis, eta_scan_axis, false));
+    Map map(eta_axis, phi_axis, outside);
+    for (unsigned int eta_i = 0; eta_i < eta_axis.nBins(); ++eta_i)
+    {
+        double eta = 0.5*(eta_axis.edges[eta_i] + eta_axis.edges[eta_i + 1]);
+        for (unsigned int phi_i = 0; phi_i < phi_axis.nBins(); ++phi_i)
+        {
+            double phi = 0.5*(phi_axis.edges[phi_i] + phi_axis.edges[phi_i + 1]);
+            map.set(eta_i, phi_i, corr->evaluate({map_type, eta, phi}));
+        }
+    }
+    return map;
+};
+
+} // End namespace VetoMaps;
+
+/* Official JME jet veto maps (non-zero = veto) of the UL campaign of the current file, with the
+   bins of the correctionlib maps recovered on a 0.01 x 0.01 eta-phi scan (see
+   VetoMaps::fromCorrection), so lookups agree with correctionlib, also at the bin edges
+   (checked by studies/jetvetomaps_check).
+*/
+struct JetVetoMaps
+{
+    VetoMaps::Map map;
+    correction::Correction::Ref veto_map; // the correctionlib map that map was built from
+    std::string map_type;
+    std::string loaded;                   // campaign and type of the map currently loaded
+
+    JetVetoMaps() { /* Do nothing */ };
+
+    void init(int year, bool is_apv, std::string new_map_type = "jetvetomap")
+    {
+        map_type = new_map_type;
+        // Only reload (and resample) when the campaign changes
+        std::string campaign = std::to_string(year) + (is_apv ? "APV" : "") + "_" + map_type;
+        if (campaign == loaded) { return; }
+        // Note: the gzipped JSONs in cvmfs can only be read by correctionlib v2.1.x
+        std::string json_path = "data/pog_jsons/JME";
+        std::string map_name;
+        switch (year)
+        {
+        case (2016):
+            json_path += (is_apv) ? "/2016preVFP_UL/jetvetomaps.json" : "/2016postVFP_UL/jetvetomaps.json";
+            map_name = "Summer19UL16_V1";
+            break;
+        case (2017):
+            json_path += "/2017_UL/jetvetomaps.json";
+            map_name = "Summer19UL17_V1";
+            break;
+        case (2018):
+            json_path += "/2018_UL/jetvetomaps.json";
+            map_name = "Summer19UL18_V1";
+            break;
+        default:
+            throw std::runtime_error("JetVetoMaps::init - invalid year or none set");
+            break;
+        };
+        auto cset = correction::CorrectionSet::from_file(json_path);
+        veto_map = cset->at(map_name);
+        map = VetoMaps::fromCorrection(
+            veto_map, map_type, VetoMaps::Axis(1038, -5.191, 5.191), VetoMaps::Axis(628, -M_PI, M_PI)
+        );
+        loaded = campaign;
+    };
+
+    VetoMaps::Config config() const
+    {
+        return {"JetVetoMap", VetoMaps::Veto, map, VetoMaps::always};
+    };
+};
+
+#endif
@@ -8,15 +8,30 @@
 #include "utilities.h"          // Utilities::Variables
 // VBS
 #include "core/collections.h"   // Core::Core::Analysis, Core::Skimmer
+#include "core/output.h"        // Output::popOption
 #include "core/cuts.h"
 #include "vbswh/collections.h"
 #include "vbswh/cuts.h"
 #include "vbsvvhjets/cuts.h"
-#include "corrections/all.h"    // PileUpSFs, LeptonSFsTTH/PKU, BTagSFs, JetEnergyScales
+#include "corrections/all.h"    // PileUpSFs, LeptonSFsTTH/PKU, BTagSFs, JetEnergyScales, JetVetoMaps
 
 namespace VBSVVHJets
 {
 
+/* Remove --jet_assignment=X or --jet_assignment X from the command line and return whether it asks
+   for the joint assignment of the V->qq and VBS AK4 jets (joint) rather than the default one, the
+   min-dR V->qq pair and then the VBS pair among the rest (sequential)
+*/
+inline bool popJointJetAssignment(int& argc, char** argv)
+{
+    std::string assignment_name = Output::popOption(argc, argv, "--jet_assignment", "sequential");
+    if (assignment_name == "sequential") { return false; }
+    if (assignment_name == "joint") { return true; }
+    throw std::runtime_error(
+        "VBSVVHJets::popJointJetAssignment - unknown jet assignment " + assignment_name + " (sequential, joint)"
+    );
+};
+
 struct Analysis : Core::Analysis
 {
     JetEnergyScales* jes;
@@ -25,7 +40,10 @@ struct Analysis : Core::Analysis
     BTagSFs* btag_sfs;
     PileUpSFs* pu_sfs;
     PileUpJetIDSFs* puid_sfs;
+    JetVetoMaps* jet_veto_maps;
     bool all_corrections;
+    bool joint_jet_assignment; // choose V->qq and VBS AK4 jets together in the semi-merged channel
+    CompareJetAssignments* compare_jet_assignments; // cross-check of the above, if enabled
 
     Analysis(Arbol& arbol_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref) 
     : Core::Analysis(arbol_ref, nt_ref, cli_ref, cutflow_ref)
@@ -44,6 +62,8 @@ struct Analysis : Core::Analysis
         // vvhqq globals
         cutflow.globals.newVar<int>("ld_vqqjet_idx");
         cutflow.globals.newVar<int>("tr_vqqjet_idx");
+        cutflow.globals.newVar<int>("joint_vbsjet1_idx");
+        cutflow.globals.newVar<int>("joint_vbsjet2_idx");
 
         // Scale factors
         jes = nullptr;
@@ -52,7 +72,10 @@ struct Analysis : Core::Analysis
         btag_sfs = nullptr;
         pu_sfs = nullptr;
         puid_sfs = nullptr;
+        jet_veto_maps = nullptr;
         all_corrections = false;
+        joint_jet_assignment = false;
+        compare_jet_assignments = nullptr;
     };
 
     virtual void initBranches()
@@ -86,6 +109,10 @@ struct Analysis : Core::Analysis
         arbol.newBranch<double>("tr_vqqjet_mass", -999);
         arbol.newBranch<double>("vqqjets_Mjj", -999);
         arbol.newBranch<double>("vqqjets_dR", -999);
+        arbol.newBranch<double>("vqqvbs_score", -999);
+        arbol.newBranch<double>("vqqvbs_runnerup_score", -999);
+        arbol.newBranch<bool>("vqqjets_match_sequential", false);
+        arbol.newBranch<bool>("vbsjets_match_sequential", false);
         // Hbb fat jet branches
         arbol.newBranch<double>("hbbfatjet_xbb", -999);
         arbol.newBranch<double>("hbbfatjet_pt", -999);
@@ -112,6 +139,7 @@ struct Analysis : Core::Analysis
         // btag_sfs = new BTagSFs(cli.output_name, "M"); // TODO: design new btageff study for this analysis
         pu_sfs = new PileUpSFs();
         puid_sfs = new PileUpJetIDSFs();
+        jet_veto_maps = new JetVetoMaps();
         all_corrections = true;
     };
 
@@ -142,7 +170,7 @@ struct Analysis : Core::Analysis
             "NoLeptons", 
             [&]() 
             { 
-                return cutflow.globals.getVal<LorentzVectors>("veto_lep_p4s").size() == 0; 
+                return cutflow.globals.getVal<SoA::P4Views>("veto_lep_p4s").size() == 0; 
             }
         );
         cutflow.insert(select_leps, no_leps, Right);
@@ -155,7 +183,7 @@ struct Analysis : Core::Analysis
             "TriggerPlateauCuts",
             [&]()
             {
-                LorentzVectors fatjet_p4s = cutflow.globals.getVal<LorentzVectors>("good_fatjet_p4s");
+                SoA::P4Views fatjet_p4s = cutflow.globals.getVal<SoA::P4Views>("good_fatjet_p4s");
                 double max_fatjet_pt = -999;
                 for (auto fatjet_p4 : fatjet_p4s)
                 {
@@ -180,9 +208,13 @@ struct Analysis : Core::Analysis
         Cut* allmerged_select_jets = new SelectJetsNoFatJetOverlap("AllMerged_SelectJets", *this, AllMerged, jes, btag_sfs, puid_sfs);
         cutflow.insert(allmerged_select_vvh, allmerged_select_jets, Right);
 
+        // JME jet veto maps
+        Cut* allmerged_veto_maps = new Core::PassesVetoMaps("AllMerged_PassesVetoMaps", *this);
+        cutflow.insert(allmerged_select_jets, allmerged_veto_maps, Right);
+
         // VBS jet selection
         Cut* allmerged_select_vbsjets = new Core::SelectVBSJets("AllMerged_SelectVBSJets", *this);
-        cutflow.insert(allmerged_select_jets, allmerged_select_vbsjets, Right);
+        cutflow.insert(allmerged_veto_maps, allmerged_select_vbsjets, Right);
 
         // Save analysis variables
         Cut* allmerged_save_vars = new SaveVariables("AllMerged_SaveVariables", *this, AllMerged);
@@ -249,23 +281,50 @@ struct Analysis : Core::Analysis
         Cut* semimerged_select_jets = new SelectJetsNoFatJetOverlap("SemiMerged_SelectJets", *this, SemiMerged, jes, btag_sfs, puid_sfs);
         cutflow.insert(semimerged_select_vvh, semimerged_select_jets, Right);
 
+        // JME jet veto maps
+        Cut* semimerged_veto_maps = new Core::PassesVetoMaps("SemiMerged_PassesVetoMaps", *this);
+        cutflow.insert(semimerged_select_jets, semimerged_veto_maps, Right);
+
         // N jets >= 4 (2 VBS + V --> qq)
         Cut* semimerged_geq4_jets = new LambdaCut(
             "SemiMerged_Geq4Jets", [&]() { return arbol.getLeaf<int>("n_jets") >= 4; }
         );
-        cutflow.insert(semimerged_select_jets, semimerged_geq4_jets, Right);
+        cutflow.insert(semimerged_veto_maps, semimerged_geq4_jets, Right);
 
         // V --> qq jet candidate selection
-        Cut* semimerged_select_vjets = new SelectVJets("SemiMerged_SelectVJets", *this);
+        Cut* semimerged_select_vjets;
+        if (joint_jet_assignment)
+        {
+            semimerged_select_vjets = new SelectVJetsJoint("SemiMerged_SelectVJets", *this);
+        }
+        else
+        {
+            semimerged_select_vjets = new SelectVJets("SemiMerged_SelectVJets", *this);
+        }
         cutflow.insert(semimerged_geq4_jets, semimerged_select_vjets, Right);
 
         // VBS jet selection
-        Cut* semimerged_select_vbsjets = new Core::SelectVBSJets("SemiMerged_SelectVBSJets", *this);
+        Cut* semimerged_select_vbsjets;
+        if (joint_jet_assignment)
+        {
+            semimerged_select_vbsjets = new SelectVBSJetsJoint("SemiMerged_SelectVBSJets", *this);
+        }
+        else
+        {
+            semimerged_select_vbsjets = new Core::SelectVBSJets("SemiMerged_SelectVBSJets", *this);
+        }
         cutflow.insert(semimerged_select_vjets, semimerged_select_vbsjets, Right);
+        Cut* semimerged_last_jet_cut = semimerged_select_vbsjets;
+        if (joint_jet_assignment)
+        {
+            compare_jet_assignments = new CompareJetAssignments("SemiMerged_CompareJetAssignments", *this);
+            cutflow.insert(semimerged_select_vbsjets, compare_jet_assignments, Right);
+            semimerged_last_jet_cut = compare_jet_assignments;
+        }
 
         // Save analysis variables
         Cut* semimerged_save_vars = new SaveVariables("SemiMerged_SaveVariables", *this, SemiMerged);
-        cutflow.insert(semimerged_select_vbsjets, semimerged_save_vars, Right);
+        cutflow.insert(semimerged_last_jet_cut, semimerged_save_vars, Right);
 
         // Basic VBS jet requirements
         Cut* semimerged_Mjjgt500 = new LambdaCut(
@@ -317,6 +376,8 @@ struct Analysis : Core::Analysis
             // btag_sfs->init(file_name); // TODO: see Analysis::initCorrections
             pu_sfs->init(file_name);
             puid_sfs->init(file_name);
+            jet_veto_maps->init(nt.year(), gconf.isAPV);
+            veto_maps.set(jet_veto_maps->config());
         }
     };
 };
@@ -1,6 +1,8 @@
 #ifndef VBSVVHJETS_CUTS_H
 #define VBSVVHJETS_CUTS_H
 
+// STL
+#include <iostream>
 // RAPIDO
 #include "arbol.h"
 #include "looper.h"
@@ -11,6 +13,9 @@
 #include "core/cuts.h"
 #include "vbswh/cuts.h"
 #include "vbsvvhjets/enums.h"
+#include "core/morphing.h"
+#include "core/jetassignment.h"
+#include "core/roleassignment.h"
 #include "corrections/all.h"
 
 namespace VBSVVHJets
@@ -48,67 +53,52 @@ public:
 class PassesTriggers : public Core::AnalysisCut
 {
 public:
+    unsigned int ht_triggers;
+
     PassesTriggers(std::string name, Core::Analysis& analysis) : Core::AnalysisCut(name, analysis) 
     {
-        // Do nothing
+        ht_triggers = triggers.addGroup(
+            "HT", 2016, 
+            {
+                HLT_PATH(HLT_PFHT800),
+                HLT_PATH(HLT_PFHT900),
+                HLT_PATH(HLT_AK8PFHT650_TrimR0p1PT0p03Mass50),
+                HLT_PATH(HLT_AK8PFHT700_TrimR0p1PT0p03Mass50),
+                HLT_PATH(HLT_AK8PFJet450),
+                HLT_PATH(HLT_AK8PFJet360_TrimMass30),
+                HLT_PATH(HLT_AK8DiPFJet280_200_TrimMass30),
+                HLT_PATH(HLT_AK8DiPFJet280_200_TrimMass30_BTagCSV_p20)
+            }
+        );
+        triggers.addGroup(
+            "HT", 2017, 
+            {
+                HLT_PATH(HLT_PFHT1050),
+                HLT_PATH(HLT_AK8PFHT800_TrimMass50),
+                HLT_PATH(HLT_PFJet320),
+                HLT_PATH(HLT_PFJet500),
+                HLT_PATH(HLT_AK8PFJet320),
+                HLT_PATH(HLT_AK8PFJet500),
+                HLT_PATH(HLT_AK8PFJet400_TrimMass30),
+                HLT_PATH(HLT_AK8PFJet420_TrimMass30)
+            }
+        );
+        triggers.addGroup(
+            "HT", 2018, 
+            {
+                HLT_PATH(HLT_PFHT1050),
+                HLT_PATH(HLT_AK8PFHT800_TrimMass50),
+                HLT_PATH(HLT_PFJet500),
+                HLT_PATH(HLT_AK8PFJet500),
+                HLT_PATH(HLT_AK8PFJet400_TrimMass30),
+                HLT_PATH(HLT_AK8PFJet420_TrimMass30)
+            }
+        );
     };
 
     bool evaluate()
     {
-        bool passed = false;
-        switch (nt.year())
-        {
-        case (2016):
-            try { passed = (passed || nt.HLT_PFHT800()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_PFHT900()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFHT650_TrimR0p1PT0p03Mass50()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFHT700_TrimR0p1PT0p03Mass50()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet450()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet360_TrimMass30()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8DiPFJet280_200_TrimMass30()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8DiPFJet280_200_TrimMass30_BTagCSV_p20()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            break;
-        case (2017):
-            try { passed = (passed || nt.HLT_PFHT1050()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFHT800_TrimMass50()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_PFJet320()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_PFJet500()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet320()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet500()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet400_TrimMass30()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet420_TrimMass30()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            break;
-        case (2018):
-            try { passed = (passed || nt.HLT_PFHT1050()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFHT800_TrimMass50()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_PFJet500()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet500()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet400_TrimMass30()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            try { passed = (passed || nt.HLT_AK8PFJet420_TrimMass30()); }
-            catch (const runtime_error& error) { /* do nothing */ }
-            break;
-        }
+        bool passed = triggers.passes(ht_triggers, triggers.fire(nt));
         if (!nt.isData() && passed)
         {
             // TODO: set/implement HT HLT sfs
@@ -135,27 +125,41 @@ class SelectVVHFatJets : public Core::AnalysisCut
 {
 public:
     Channel channel;
+    unsigned int vvh;
 
     SelectVVHFatJets(std::string name, Core::Analysis& analysis, Channel channel) 
     : Core::AnalysisCut(name, analysis) 
     {
         this->channel = channel;
+        vvh = composites.declare("VVH_allmerged", {"hbbfatjet", "ld_vqqfatjet", "tr_vqqfatjet"});
     };
 
     bool evaluate()
     {
-        LorentzVectors good_fatjet_p4s = globals.getVal<LorentzVectors>("good_fatjet_p4s");
+        SoA::P4Views good_fatjet_p4s = globals.getVal<SoA::P4Views>("good_fatjet_p4s");
         Doubles good_fatjet_xbbtags = globals.getVal<Doubles>("good_fatjet_xbbtags");
         Doubles good_fatjet_xvqqtags = globals.getVal<Doubles>("good_fatjet_xvqqtags");
         Doubles good_fatjet_xwqqtags = globals.getVal<Doubles>("good_fatjet_xwqqtags");
         Doubles good_fatjet_msoftdrops = globals.getVal<Doubles>("good_fatjet_msoftdrops");
         Doubles good_fatjet_masses = globals.getVal<Doubles>("good_fatjet_masses");
 
-        // Select Hbb fat jet candidate first
-        unsigned int best_xbb_i = (
-            std::max_element(good_fatjet_xbbtags.begin(), good_fatjet_xbbtags.end()) - good_fatjet_xbbtags.begin()
+        // Hbb: max xbb; W/Z: the two leading fat jets in pT among the rest
+        RoleAssignment::Solver solver;
+        RoleAssignment::Result roles = solver.assign(
+            {
+                {"hbb", [&](unsigned int i) { return good_fatjet_xbbtags.at(i); }},
+                {"ld_vqq", [&](unsigned int i) { return good_fatjet_p4s.at(i).pt(); }},
+                {"tr_vqq", [&](unsigned int i) { return good_fatjet_p4s.at(i).pt(); }}
+            },
+            good_fatjet_p4s.size(), RoleAssignment::Sequential
         );
+        unsigned int best_xbb_i = roles.candidates.at(0);
+        int ld_fatjet_i = roles.candidates.at(1);
+        int tr_fatjet_i = roles.candidates.at(2);
+
+        // Select Hbb fat jet candidate first
         LorentzVector hbbfatjet_p4 = good_fatjet_p4s.at(best_xbb_i);
+        composites.setRole("hbbfatjet", hbbfatjet_p4);
         globals.setVal<LorentzVector>("hbbfatjet_p4", hbbfatjet_p4);
         globals.setVal<unsigned int>("hbbfatjet_gidx", best_xbb_i);
         arbol.setLeaf<double>("hbbfatjet_xbb", good_fatjet_xbbtags.at(best_xbb_i));
@@ -165,40 +169,13 @@ public:
         arbol.setLeaf<double>("hbbfatjet_mass", good_fatjet_masses.at(best_xbb_i));
         arbol.setLeaf<double>("hbbfatjet_msoftdrop", good_fatjet_msoftdrops.at(best_xbb_i));
 
-        // Get the two leading fatjets in pT
-        int ld_fatjet_i = -999;
-        int tr_fatjet_i = -999;
-        double ld_fatjet_pt = -999.;
-        double tr_fatjet_pt = -999.;
-        for (unsigned int fatjet_i = 0; fatjet_i < good_fatjet_p4s.size(); ++fatjet_i)
-        {
-            if (fatjet_i == best_xbb_i)
-            {
-                continue;
-            }
-            double fatjet_pt = good_fatjet_p4s.at(fatjet_i).pt();
-            if (fatjet_pt > ld_fatjet_pt)
-            {
-                if (ld_fatjet_pt != -999.)
-                {
-                    tr_fatjet_pt = ld_fatjet_pt;
-                    tr_fatjet_i = ld_fatjet_i;
-                }
-                ld_fatjet_pt = fatjet_pt;
-                ld_fatjet_i = fatjet_i;
-            }
-            else if (fatjet_pt > tr_fatjet_pt)
-            {
-                tr_fatjet_pt = fatjet_pt;
-                tr_fatjet_i = fatjet_i;
-            }
-        }
-
         // Select W/Z candidate(s) last
         if (channel == AllMerged)
         {
             LorentzVector ld_vqqfatjet_p4 = good_fatjet_p4s.at(ld_fatjet_i);
             LorentzVector tr_vqqfatjet_p4 = good_fatjet_p4s.at(tr_fatjet_i);
+            composites.setRole("ld_vqqfatjet", ld_vqqfatjet_p4);
+            composites.setRole("tr_vqqfatjet", tr_vqqfatjet_p4);
             globals.setVal<LorentzVector>("ld_vqqfatjet_p4", ld_vqqfatjet_p4);
             globals.setVal<unsigned int>("ld_vqqfatjet_gidx", ld_fatjet_i);
             arbol.setLeaf<double>("ld_vqqfatjet_xvqq", good_fatjet_xvqqtags.at(ld_fatjet_i));
@@ -217,14 +194,15 @@ public:
             arbol.setLeaf<double>("tr_vqqfatjet_phi", tr_vqqfatjet_p4.phi());
             arbol.setLeaf<double>("tr_vqqfatjet_mass", good_fatjet_masses.at(tr_fatjet_i));
             arbol.setLeaf<double>("tr_vqqfatjet_msoftdrop", good_fatjet_msoftdrops.at(tr_fatjet_i));
-            arbol.setLeaf<double>("M_VVH", (hbbfatjet_p4 + ld_vqqfatjet_p4 + tr_vqqfatjet_p4).M());
-            arbol.setLeaf<double>("VVH_pt", (hbbfatjet_p4 + ld_vqqfatjet_p4 + tr_vqqfatjet_p4).pt());
-            arbol.setLeaf<double>("VVH_eta", (hbbfatjet_p4 + ld_vqqfatjet_p4 + tr_vqqfatjet_p4).eta());
-            arbol.setLeaf<double>("VVH_phi", (hbbfatjet_p4 + ld_vqqfatjet_p4 + tr_vqqfatjet_p4).phi());
+            arbol.setLeaf<double>("M_VVH", composites.M(vvh));
+            arbol.setLeaf<double>("VVH_pt", composites.pt(vvh));
+            arbol.setLeaf<double>("VVH_eta", composites.eta(vvh));
+            arbol.setLeaf<double>("VVH_phi", composites.phi(vvh));
         }
         else if (channel == SemiMerged)
         {
             LorentzVector vqqfatjet_p4 = good_fatjet_p4s.at(ld_fatjet_i);
+            composites.setRole("ld_vqqfatjet", vqqfatjet_p4);
             globals.setVal<LorentzVector>("ld_vqqfatjet_p4", vqqfatjet_p4);
             globals.setVal<unsigned int>("ld_vqqfatjet_gidx", ld_fatjet_i);
             arbol.setLeaf<double>("ld_vqqfatjet_xvqq", good_fatjet_xvqqtags.at(ld_fatjet_i));
@@ -239,6 +217,110 @@ public:
     };
 };
 
+/* Assigns the good fat jets to a list of roles, each scored by one fat jet variable ("xbb",
+   "xvqq", "xwqq", "pt", "mass" or "msoftdrop"), and writes the result to the output tree as
+   {prefix}_{role}_{gidx,score,pt,eta,phi,mass}, {prefix}_score (sum over roles) and {prefix}_M
+   (mass of the sum of the assigned fat jets, the composite candidate {prefix}). Several of these with different roles or
+   strategies can be inserted into the same cutflow to compare assignments in one pass; the cut
+   never rejects an event.
+*/
+class AssignFatJetRoles : public Core::AnalysisCut
+{
+public:
+    std::string prefix;
+    std::vector<std::pair<std::string, std::string>> roles; // (role name, score variable)
+    RoleAssignment::Strategy strategy;
+    RoleAssignment::Solver solver;
+    std::vector<unsigned int> composite_roles;
+    unsigned int composite;
+
+    AssignFatJetRoles(std::string name, Core::Analysis& analysis, std::string prefix, 
+                      std::vector<std::pair<std::string, std::string>> roles, 
+                      RoleAssignment::Strategy strategy = RoleAssignment::Optimal) 
+    : Core::AnalysisCut(name, analysis) 
+    {
+        this->prefix = prefix;
+        this->roles = roles;
+        this->strategy = strategy;
+        std::vector<std::string> score_names = {"xbb", "xvqq", "xwqq", "pt", "mass", "msoftdrop"};
+        std::vector<std::string> composite_role_names;
+        for (auto& [role_name, score_name] : roles)
+        {
+            if (std::find(score_names.begin(), score_names.end(), score_name) == score_names.end())
+            {
+                throw std::runtime_error("AssignFatJetRoles::AssignFatJetRoles - unknown score variable " + score_name);
+            }
+            arbol.newBranch<int>(prefix + "_" + role_name + "_gidx", -999);
+            arbol.newBranch<double>(prefix + "_" + role_name + "_score", -999);
+            arbol.newBranch<double>(prefix + "_" + role_name + "_pt", -999);
+            arbol.newBranch<double>(prefix + "_" + role_name + "_eta", -999);
+            arbol.newBranch<double>(prefix + "_" + role_name + "_phi", -999);
+            arbol.newBranch<double>(prefix + "_" + role_name + "_mass", -999);
+            composite_role_names.push_back(prefix + "_" + role_name);
+            composite_roles.push_back(composites.addRole(prefix + "_" + role_name));
+        }
+        composite = composites.declare(prefix, composite_role_names);
+        arbol.newBranch<double>(prefix + "_score", -999);
+        arbol.newBranch<double>(prefix + "_M", -999);
+    };
+
+    Doubles getScores(std::string score_name)
+    {
+        if (score_name == "xbb") { return globals.getVal<Doubles>("good_fatjet_xbbtags"); }
+        else if (score_name == "xvqq") { return globals.getVal<Doubles>("good_fatjet_xvqqtags"); }
+        else if (score_name == "xwqq") { return globals.getVal<Doubles>("good_fatjet_xwqqtags"); }
+        else if (score_name == "mass") { return globals.getVal<Doubles>("good_fatjet_masses"); }
+        else if (score_name == "msoftdrop") { return globals.getVal<Doubles>("good_fatjet_msoftdrops"); }
+        else if (score_name == "pt")
+        {
+            Doubles pts;
+            for (auto p4 : globals.getVal<SoA::P4Views>("good_fatjet_p4s")) { pts.push_back(p4.pt()); }
+            return pts;
+        }
+        else
+        {
+            throw std::runtime_error("AssignFatJetRoles::getScores - unknown score variable " + score_name);
+        }
+    };
+
+    bool evaluate()
+    {
+        SoA::P4Views good_fatjet_p4s = globals.getVal<SoA::P4Views>("good_fatjet_p4s");
+        Doubles good_fatjet_masses = globals.getVal<Doubles>("good_fatjet_masses");
+
+        std::vector<Doubles> role_scores;
+        std::vector<RoleAssignment::Role> assignment_roles;
+        for (auto& [role_name, score_name] : roles) { role_scores.push_back(getScores(score_name)); }
+        for (unsigned int role_i = 0; role_i < roles.size(); ++role_i)
+        {
+            const Doubles& scores = role_scores.at(role_i);
+            assignment_roles.push_back({roles.at(role_i).first, [&scores](unsigned int i) { return scores.at(i); }});
+        }
+        RoleAssignment::Result result = solver.assign(assignment_roles, good_fatjet_p4s.size(), strategy);
+
+        for (unsigned int role_i = 0; role_i < roles.size(); ++role_i)
+        {
+            int gidx = result.candidates.at(role_i);
+            if (gidx < 0) { continue; }
+            std::string role_prefix = prefix + "_" + roles.at(role_i).first;
+            LorentzVector p4 = good_fatjet_p4s.at(gidx);
+            composites.setRole(composite_roles.at(role_i), p4);
+            arbol.setLeaf<int>(role_prefix + "_gidx", gidx);
+            arbol.setLeaf<double>(role_prefix + "_score", result.scores.at(role_i));
+            arbol.setLeaf<double>(role_prefix + "_pt", p4.pt());
+            arbol.setLeaf<double>(role_prefix + "_eta", p4.eta());
+            arbol.setLeaf<double>(role_prefix + "_phi", p4.phi());
+            arbol.setLeaf<double>(role_prefix + "_mass", good_fatjet_masses.at(gidx));
+        }
+        if (result.isComplete())
+        {
+            arbol.setLeaf<double>(prefix + "_score", result.total);
+            arbol.setLeaf<double>(prefix + "_M", composites.M(composite));
+        }
+        return true;
+    };
+};
+
 class SelectJetsNoFatJetOverlap : public Core::SelectJets
 {
 public:
@@ -246,6 +328,7 @@ public:
     LorentzVector hbbfatjet_p4;
     LorentzVector ld_vqqfatjet_p4;
     LorentzVector tr_vqqfatjet_p4;
+    Overlap::Mask fatjet_keep_mask;
 
     SelectJetsNoFatJetOverlap(std::string name, Core::Analysis& analysis, Channel channel, 
                               JetEnergyScales* jes = nullptr, BTagSFs* btag_sfs = nullptr,
@@ -260,46 +343,38 @@ public:
         hbbfatjet_p4 = globals.getVal<LorentzVector>("hbbfatjet_p4");
         ld_vqqfatjet_p4 = globals.getVal<LorentzVector>("ld_vqqfatjet_p4");
         tr_vqqfatjet_p4 = globals.getVal<LorentzVector>("tr_vqqfatjet_p4");
+        LorentzVectors fatjet_p4s = {hbbfatjet_p4, ld_vqqfatjet_p4};
+        if (channel == AllMerged)
+        {
+            fatjet_p4s.push_back(tr_vqqfatjet_p4);
+        }
+        fatjet_keep_mask = Overlap::keepMask(soa.jets(), fatjet_p4s, 0.8);
     };
 
     bool isOverlap(int jet_i, LorentzVector jet_p4)
     {
-        bool hbb_overlap = ROOT::Math::VectorUtil::DeltaR(hbbfatjet_p4, jet_p4) < 0.8;
-        bool vqq_overlap = ROOT::Math::VectorUtil::DeltaR(ld_vqqfatjet_p4, jet_p4) < 0.8;
-        if (channel == AllMerged)
-        {
-            vqq_overlap = vqq_overlap || ROOT::Math::VectorUtil::DeltaR(tr_vqqfatjet_p4, jet_p4) < 0.8;
-        }
-        return hbb_overlap || vqq_overlap;
+        return !fatjet_keep_mask[jet_i];
     };
 };
 
 class SelectVJets : public Core::AnalysisCut
 {
 public:
+    unsigned int vqqjets;
+
     SelectVJets(std::string name, Core::Analysis& analysis) 
     : Core::AnalysisCut(name, analysis) 
     {
-        // Do nothing
+        vqqjets = composites.declare("vqqjets", {"ld_vqqjet", "tr_vqqjet"});
     };
 
-    bool evaluate()
+    /* The pair of good jets with the smallest dR */
+    static std::pair<unsigned int, unsigned int> minDRPair(const SoA::P4Views& good_jet_p4s)
     {
-        int ld_vbsjet_idx = globals.getVal<int>("ld_vbsjet_idx");
-        int tr_vbsjet_idx = globals.getVal<int>("tr_vbsjet_idx");
-
-        LorentzVectors good_jet_p4s = globals.getVal<LorentzVectors>("good_jet_p4s");
-        Integers good_jet_idxs = globals.getVal<Integers>("good_jet_idxs");
-        if (good_jet_idxs.size() < 4) { return false; }
-
         double min_dR = 99999;
         std::pair<unsigned int, unsigned int> vqqjet_idxs;
         for (unsigned int jet_i = 0; jet_i < good_jet_p4s.size(); ++jet_i)
         {
-            int jet_idx = good_jet_idxs.at(jet_i);
-            // Skip VBS jet candidates
-            // skip this step since we are gonna select the Vqq jets first
-            // if (jet_idx == ld_vbsjet_idx || jet_idx == tr_vbsjet_idx) { continue; }
             // Iterate over all pairs
             for (unsigned int jet_j = jet_i + 1; jet_j < good_jet_p4s.size(); ++jet_j)
             {
@@ -313,6 +388,21 @@ public:
                 }
             }
         }
+        return vqqjet_idxs;
+    };
+
+    virtual std::pair<unsigned int, unsigned int> getVJetPair(const SoA::P4Views& good_jet_p4s)
+    {
+        return minDRPair(good_jet_p4s);
+    };
+
+    bool evaluate()
+    {
+        SoA::P4Views good_jet_p4s = globals.getVal<SoA::P4Views>("good_jet_p4s");
+        Integers good_jet_idxs = globals.getVal<Integers>("good_jet_idxs");
+        if (good_jet_idxs.size() < 4) { return false; }
+
+        std::pair<unsigned int, unsigned int> vqqjet_idxs = getVJetPair(good_jet_p4s);
 
         // Sort the two (VBS-xx) Vqq jets into leading/trailing
         int ld_vqqjet_idx;
@@ -332,6 +422,8 @@ public:
         int ld_vqqjet_nanoidx = good_jet_idxs.at(ld_vqqjet_idx);
         int tr_vqqjet_nanoidx = good_jet_idxs.at(tr_vqqjet_idx);
 
+        composites.setRole("ld_vqqjet", ld_vqqjet_p4);
+        composites.setRole("tr_vqqjet", tr_vqqjet_p4);
         globals.setVal<LorentzVector>("ld_vqqjet_p4", ld_vqqjet_p4);
         globals.setVal<LorentzVector>("tr_vqqjet_p4", tr_vqqjet_p4);
         // save vbf jet globals to be used in vbs part
@@ -348,51 +440,210 @@ public:
         arbol.setLeaf<double>("tr_vqqjet_eta", tr_vqqjet_p4.eta());
         arbol.setLeaf<double>("tr_vqqjet_phi", tr_vqqjet_p4.phi());
         arbol.setLeaf<double>("tr_vqqjet_mass", tr_vqqjet_p4.M());
-        arbol.setLeaf<double>("vqqjets_Mjj", (ld_vqqjet_p4 + tr_vqqjet_p4).M());
-        arbol.setLeaf<double>("vqqjets_dR", min_dR);
+        arbol.setLeaf<double>("vqqjets_Mjj", composites.M(vqqjets));
+        arbol.setLeaf<double>("vqqjets_dR", ROOT::Math::VectorUtil::DeltaR(ld_vqqjet_p4, tr_vqqjet_p4));
+        return true;
+    };
+};
+
+/* Chooses the V->qq and VBS jet pairs together (see JetAssignment::solve) instead of taking the
+   min-dR pair as the V->qq jets and searching for VBS jets among the rest; the VBS pair is left
+   in the globals for SelectVBSJetsJoint
+*/
+class SelectVJetsJoint : public SelectVJets
+{
+public:
+    JetAssignment::Config config;
+    JetAssignment::Result assignment;
+
+    SelectVJetsJoint(std::string name, Core::Analysis& analysis, 
+                     JetAssignment::Config config = JetAssignment::Config()) 
+    : SelectVJets(name, analysis) 
+    {
+        this->config = config;
+    };
+
+    std::pair<unsigned int, unsigned int> getVJetPair(const SoA::P4Views& good_jet_p4s)
+    {
+        return std::make_pair(assignment.best.vqq_first, assignment.best.vqq_second);
+    };
+
+    bool evaluate()
+    {
+        assignment = JetAssignment::solve(soa.jets(), soa.jets().good_idxs, config);
+        if (!assignment.best.isValid()) { return false; }
+
+        globals.setVal<int>("joint_vbsjet1_idx", assignment.best.vbs_first);
+        globals.setVal<int>("joint_vbsjet2_idx", assignment.best.vbs_second);
+        arbol.setLeaf<double>("vqqvbs_score", assignment.best.score);
+        if (assignment.hasRunnerUp())
+        {
+            arbol.setLeaf<double>("vqqvbs_runnerup_score", assignment.runnerup_score);
+        }
+        return SelectVJets::evaluate();
+    };
+};
+
+/* Takes the VBS jet pair chosen by SelectVJetsJoint */
+class SelectVBSJetsJoint : public Core::SelectVBSJets
+{
+public:
+    SelectVBSJetsJoint(std::string name, Core::Analysis& analysis, 
+                       Pairs::Preselection vbsjet_presel = Pairs::Preselection(30., 4.7)) 
+    : Core::SelectVBSJets(name, analysis, vbsjet_presel) 
+    {
+        // Do nothing
+    };
+
+    std::pair<unsigned int, unsigned int> getVBSPair(std::vector<unsigned int> vbsjet_cand_idxs)
+    {
+        return std::make_pair(
+            globals.getVal<int>("joint_vbsjet1_idx"), 
+            globals.getVal<int>("joint_vbsjet2_idx")
+        );
+    };
+};
+
+/* Cross-check of the joint jet assignment (SelectVJetsJoint, SelectVBSJetsJoint), to be inserted
+   after them: redoes the sequential assignment (min-dR V->qq pair, then the max-|deta| VBS pair
+   among the remaining good jets) and records whether each pair is the same set of jets as the
+   joint one, in vqqjets_match_sequential and vbsjets_match_sequential; print() summarizes it
+*/
+class CompareJetAssignments : public Core::SelectVBSJets
+{
+public:
+    long n_compared;
+    long n_vqqjets_matched;
+    long n_vbsjets_matched;
+    long n_both_matched;
+
+    CompareJetAssignments(std::string name, Core::Analysis& analysis, 
+                          Pairs::Preselection vbsjet_presel = Pairs::Preselection(30., 4.7)) 
+    : Core::SelectVBSJets(name, analysis, vbsjet_presel) 
+    {
+        n_compared = 0;
+        n_vqqjets_matched = 0;
+        n_vbsjets_matched = 0;
+        n_both_matched = 0;
+    };
+
+    static bool samePair(std::pair<unsigned int, unsigned int> pair, int idx1, int idx2)
+    {
+        return (
+            (int(pair.first) == idx1 && int(pair.second) == idx2) 
+            || (int(pair.first) == idx2 && int(pair.second) == idx1)
+        );
+    };
+
+    bool evaluate()
+    {
+        SoA::P4Views good_jet_p4s = globals.getVal<SoA::P4Views>("good_jet_p4s");
+        const SoA::Jets& jets = soa.jets();
+
+        // Sequential assignment
+        std::pair<unsigned int, unsigned int> vqqjet_idxs = SelectVJets::minDRPair(good_jet_p4s);
+        std::vector<unsigned int> vbsjet_cand_idxs;
+        for (unsigned int jet_i = 0; jet_i < jets.good_idxs.size(); ++jet_i)
+        {
+            if (jet_i == vqqjet_idxs.first || jet_i == vqqjet_idxs.second) { continue; }
+            int nano_jet_i = jets.good_idxs[jet_i];
+            if (vbsjet_presel.passes(jets.pt[nano_jet_i], jets.eta[nano_jet_i]))
+            {
+                vbsjet_cand_idxs.push_back(jet_i);
+            }
+        }
+        bool has_vbsjets = (vbsjet_cand_idxs.size() >= 2);
+        std::pair<unsigned int, unsigned int> vbsjet_idxs;
+        if (has_vbsjets)
+        {
+            Pairs::Result pairs = findVBSPairs(vbsjet_cand_idxs);
+            has_vbsjets = pairs.best[Pairs::MaxDEta].isValid();
+            vbsjet_idxs = toVBSPair(vbsjet_cand_idxs, pairs.best[Pairs::MaxDEta]);
+        }
+
+        // Joint assignment
+        bool vqqjets_match = samePair(
+            vqqjet_idxs, globals.getVal<int>("ld_vqqjet_idx"), globals.getVal<int>("tr_vqqjet_idx")
+        );
+        bool vbsjets_match = has_vbsjets && samePair(
+            vbsjet_idxs, globals.getVal<int>("ld_vbsjet_idx"), globals.getVal<int>("tr_vbsjet_idx")
+        );
+        arbol.setLeaf<bool>("vqqjets_match_sequential", vqqjets_match);
+        arbol.setLeaf<bool>("vbsjets_match_sequential", vbsjets_match);
+        n_compared++;
+        if (vqqjets_match) { n_vqqjets_matched++; }
+        if (vbsjets_match) { n_vbsjets_matched++; }
+        if (vqqjets_match && vbsjets_match) { n_both_matched++; }
         return true;
     };
+
+    void print()
+    {
+        if (n_compared == 0) { return; }
+        std::cout << "CompareJetAssignments: the joint assignment agrees with the sequential one in " 
+                  << n_both_matched << " of " << n_compared << " events (V->qq jets: " 
+                  << n_vqqjets_matched << ", VBS jets: " << n_vbsjets_matched << ")" << std::endl;
+    };
 };
 
 class SaveVariables : public Core::AnalysisCut
 {
 public:
     Channel channel;
+    unsigned int vvh;
 
     SaveVariables(std::string name, Core::Analysis& analysis, Channel channel) 
     : Core::AnalysisCut(name, analysis) 
     {
         this->channel = channel;
+        if (channel == AllMerged)
+        {
+            vvh = composites.declare("VVH_allmerged", {"hbbfatjet", "ld_vqqfatjet", "tr_vqqfatjet"});
+        }
+        else
+        {
+            vvh = composites.declare("VVH_semimerged", {"hbbfatjet", "ld_vqqfatjet", "ld_vqqjet", "tr_vqqjet"});
+        }
     };
 
     bool evaluate()
     {
         arbol.setLeaf<bool>("passes_bveto", arbol.getLeaf<int>("n_medium_b_jets") == 0);
+        arbol.setLeaf<double>("ST", composites.ST(vvh));
         if (channel == AllMerged)
         {
-            arbol.setLeaf<double>(
-                "ST",
-                arbol.getLeaf<double>("hbbfatjet_pt")
-                + arbol.getLeaf<double>("ld_vqqfatjet_pt")
-                + arbol.getLeaf<double>("tr_vqqfatjet_pt")
-            );
             arbol.setLeaf<bool>("is_allmerged", true);
         }
         else if (channel == SemiMerged)
         {
-            arbol.setLeaf<double>(
-                "ST",
-                arbol.getLeaf<double>("hbbfatjet_pt")
-                + arbol.getLeaf<double>("ld_vqqfatjet_pt")
-                + arbol.getLeaf<double>("ld_vqqjet_pt")
-                + arbol.getLeaf<double>("tr_vqqjet_pt")
-            );
             arbol.setLeaf<bool>("is_semimerged", true);
         }
         return true;
     };
 };
 
+class SaveMorphingCoefs : public Core::AnalysisCut
+{
+public:
+    CouplingMorphing* morphing;
+
+    SaveMorphingCoefs(std::string name, Core::Analysis& analysis, CouplingMorphing* morphing) 
+    : Core::AnalysisCut(name, analysis) 
+    {
+        this->morphing = morphing;
+    };
+
+    bool evaluate()
+    {
+        if (nt.isData() || !morphing->is_active) { return true; }
+        std::vector<double> coefs = morphing->getCoefs(nt.LHEReweightingWeight());
+        morphing->check(coefs, nt.LHEReweightingWeight());
+        arbol.setLeaf<Doubles>("morph_coefs", coefs);
+        arbol.setLeaf<double>("reweight_c2v_eq_3", morphing->evaluate(coefs, {3, 1, 1}));
+        return true;
+    };
+};
+
 } // End namespace VBSVVHJets;
 
 #endif
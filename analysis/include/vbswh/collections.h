@@ -17,8 +17,10 @@ namespace VBSWH
 
 struct Skimmer : Core::Skimmer
 {
-    Skimmer(Arbusto& arbusto_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref) 
-    : Core::Skimmer(arbusto_ref, nt_ref, cli_ref, cutflow_ref)
+    Skimmer(Arbusto& arbusto_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref,
+            EventIndex::SkimFormat new_format = EventIndex::CopySkim,
+            int new_compression = Output::DefaultCompression) 
+    : Core::Skimmer(arbusto_ref, nt_ref, cli_ref, cutflow_ref, new_format, new_compression)
     {
         gconf.nanoAOD_ver = 9;
 
@@ -70,8 +72,10 @@ struct Skimmer : Core::Skimmer
 
 struct SkimmerPKU : Skimmer
 {
-    SkimmerPKU(Arbusto& arbusto_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref) 
-    : Skimmer(arbusto_ref, nt_ref, cli_ref, cutflow_ref)
+    SkimmerPKU(Arbusto& arbusto_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref,
+               EventIndex::SkimFormat new_format = EventIndex::CopySkim,
+               int new_compression = Output::DefaultCompression) 
+    : Skimmer(arbusto_ref, nt_ref, cli_ref, cutflow_ref, new_format, new_compression)
     {
         // Do nothing
     };
@@ -94,6 +98,7 @@ struct Analysis : Core::Analysis
     PileUpSFs* pu_sfs;
     PileUpJetIDSFs* puid_sfs;
     ParticleNetXbbSFs* xbb_sfs;
+    JetVetoMaps* jet_veto_maps;
     bool all_corrections;
 
     Analysis(Arbol& arbol_ref, Nano& nt_ref, HEPCLI& cli_ref, Cutflow& cutflow_ref) 
@@ -111,6 +116,7 @@ struct Analysis : Core::Analysis
         pu_sfs = nullptr;
         puid_sfs = nullptr;
         xbb_sfs = nullptr;
+        jet_veto_maps = nullptr;
         all_corrections = false;
     };
 
@@ -165,6 +171,7 @@ struct Analysis : Core::Analysis
         pu_sfs = new PileUpSFs();
         puid_sfs = new PileUpJetIDSFs();
         xbb_sfs = new ParticleNetXbbSFs();
+        jet_veto_maps = new JetVetoMaps();
         all_corrections = true;
     };
 
@@ -210,9 +217,13 @@ struct Analysis : Core::Analysis
         Cut* select_jets = new SelectJetsNoHbbOverlap("SelectJetsNoHbbOverlap", *this, jes, btag_sfs, puid_sfs);
         cutflow.insert(select_hbbjet, select_jets, Right);
 
+        // JME jet veto maps
+        Cut* veto_maps = new Core::PassesVetoMaps("PassesVetoMaps", *this);
+        cutflow.insert(select_jets, veto_maps, Right);
+
         // VBS jet selection
         Cut* select_vbsjets_maxE = new Core::SelectVBSJetsMaxE("SelectVBSJetsMaxE", *this);
-        cutflow.insert(select_jets, select_vbsjets_maxE, Right);
+        cutflow.insert(veto_maps, select_vbsjets_maxE, Right);
 
         // Save LHE mu_R and mu_F scale weights
         Cut* save_lhe = new Core::SaveSystWeights("SaveSystWeights", *this);
@@ -294,6 +305,8 @@ struct Analysis : Core::Analysis
             pu_sfs->init(file_name);
             puid_sfs->init(file_name);
             xbb_sfs->init(file_name);
+            jet_veto_maps->init(nt.year(), gconf.isAPV);
+            veto_maps.set(jet_veto_maps->config());
         }
     };
 };
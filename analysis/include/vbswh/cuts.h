@@ -42,38 +42,67 @@ public:
         return ttH_UL::muonID(muon_i, ttH::IDtight, nt.year());
     };
 
+    virtual LeptonID::Mask getVetoElecMask()
+    {
+        return LeptonID::evaluate(nt.nElectron(), [&](int elec_i) { return passesVetoElecID(elec_i); });
+    };
+
+    virtual LeptonID::Mask getTightElecMask()
+    {
+        return LeptonID::evaluate(nt.nElectron(), [&](int elec_i) { return passesTightElecID(elec_i); });
+    };
+
+    virtual LeptonID::Mask getVetoMuonMask()
+    {
+        return LeptonID::evaluate(nt.nMuon(), [&](int muon_i) { return passesVetoMuonID(muon_i); });
+    };
+
+    virtual LeptonID::Mask getTightMuonMask()
+    {
+        return LeptonID::evaluate(nt.nMuon(), [&](int muon_i) { return passesTightMuonID(muon_i); });
+    };
+
     bool evaluate()
     {
         LorentzVectors veto_lep_p4s;
         LorentzVectors tight_lep_p4s;
         Integers veto_lep_pdgIDs;
         Integers tight_lep_pdgIDs;
+        // Evaluate the IDs of all leptons first
+        LeptonID::Mask veto_elecs = getVetoElecMask();
+        LeptonID::Mask tight_elecs = getTightElecMask();
+        LeptonID::Mask veto_muons = getVetoMuonMask();
+        LeptonID::Mask tight_muons = getTightMuonMask();
         for (unsigned int elec_i = 0; elec_i < nt.nElectron(); elec_i++)
         {
+            if (!veto_elecs[elec_i] && !tight_elecs[elec_i]) { continue; }
             LorentzVector lep_p4 = nt.Electron_p4().at(elec_i);
-            if (passesVetoElecID(elec_i)) 
+            int lep_pdgID = -nt.Electron_charge().at(elec_i)*11;
+            if (veto_elecs[elec_i]) 
             { 
                 veto_lep_p4s.push_back(lep_p4); 
-                veto_lep_pdgIDs.push_back(-nt.Electron_charge().at(elec_i)*11);
+                veto_lep_pdgIDs.push_back(lep_pdgID);
             }
-            if (passesTightElecID(elec_i)) 
+            if (tight_elecs[elec_i]) 
             { 
                 tight_lep_p4s.push_back(lep_p4); 
-                tight_lep_pdgIDs.push_back(-nt.Electron_charge().at(elec_i)*11);
+                tight_lep_pdgIDs.push_back(lep_pdgID);
             }
         }
         for (unsigned int muon_i = 0; muon_i < nt.nMuon(); muon_i++)
         {
+            if (!veto_muons[muon_i] && !tight_muons[muon_i]) { continue; }
             LorentzVector lep_p4 = nt.Muon_p4().at(muon_i);
-            if (passesVetoMuonID(muon_i)) 
+            int lep_pdgID = -nt.Muon_charge().at(muon_i)*13;
+            if (veto_muons[muon_i]) 
             { 
                 veto_lep_p4s.push_back(lep_p4); 
-                veto_lep_pdgIDs.push_back(-nt.Muon_charge().at(muon_i)*13); 
+                veto_lep_pdgIDs.push_back(lep_pdgID); 
             }
-            if (passesTightMuonID(muon_i)) 
+            if (tight_muons[muon_i]) 
             { 
                 tight_lep_p4s.push_back(lep_p4); 
-                tight_lep_pdgIDs.push_back(-nt.Muon_charge().at(muon_i)*13); 
+                tight_lep_pdgIDs.push_back(lep_pdgID); 
             }
         }
         globals.setVal<LorentzVectors>("veto_lep_p4s", veto_lep_p4s);
@@ -111,6 +140,26 @@ public:
     {
         return PKU::passesMuonID(muon_i, PKU::IDtight);
     };
+
+    LeptonID::Mask getVetoElecMask()
+    {
+        return PKU::elecIDMask(nt, PKU::IDveto);
+    };
+
+    LeptonID::Mask getTightElecMask()
+    {
+        return PKU::elecIDMask(nt, PKU::IDtight);
+    };
+
+    LeptonID::Mask getVetoMuonMask()
+    {
+        return PKU::muonIDMask(nt, PKU::IDveto);
+    };
+
+    LeptonID::Mask getTightMuonMask()
+    {
+        return PKU::muonIDMask(nt, PKU::IDtight);
+    };
 };
 
 class Geq2Jets : public Core::SkimmerCut
@@ -229,7 +278,7 @@ public:
             // Find candidate with highest Xbb score
             double pnet_xbb = nt.FatJet_particleNetMD_Xbb().at(fatjet_i);
             double pnet_qcd = nt.FatJet_particleNetMD_QCD().at(fatjet_i);
-            double xbb_score = pnet_xbb/(pnet_xbb + pnet_qcd);
+            double xbb_score = ParticleNet::xbb(pnet_xbb, pnet_qcd);
             if (xbb_score > hbbjet_score)
             {
                 hbbjet_score = xbb_score;
@@ -285,59 +334,40 @@ class Passes1LepTriggers : public Core::AnalysisCut
 {
 public:
     HLT1LepSFs* hlt_sfs;
+    unsigned int muon_triggers;
+    unsigned int elec_triggers;
+    Triggers::Bits fired;
+    enum Stream { SingleMuon, SingleElectron, Other } stream;
+    unsigned int stream_file_index;
 
     Passes1LepTriggers(std::string name, Core::Analysis& analysis, HLT1LepSFs* hlt_sfs = nullptr) 
     : Core::AnalysisCut(name, analysis) 
     {
         this->hlt_sfs = hlt_sfs;
+        muon_triggers = triggers.addGroup("SingleMuon", 2016, {HLT_PATH(HLT_IsoMu24), HLT_PATH(HLT_IsoTkMu24)});
+        triggers.addGroup("SingleMuon", 2017, {HLT_PATH(HLT_IsoMu27)});
+        triggers.addGroup("SingleMuon", 2018, {HLT_PATH(HLT_IsoMu24)});
+        elec_triggers = triggers.addGroup("SingleElectron", 2016, {HLT_PATH(HLT_Ele27_WPTight_Gsf)});
+        triggers.addGroup("SingleElectron", 2017, {HLT_PATH(HLT_Ele32_WPTight_Gsf_L1DoubleEG)});
+        triggers.addGroup("SingleElectron", 2018, {HLT_PATH(HLT_Ele32_WPTight_Gsf)});
+        fired = 0;
+        stream = Other;
+        stream_file_index = 0;
     };
 
     bool passesMuonTriggers()
     {
-        bool passed = false;
-        switch (nt.year())
-        {
-        case (2016):
-            try { passed = (passed || nt.HLT_IsoMu24()); }
-            catch (const runtime_error& error) { /* Do nothing */ }
-            try { passed = (passed || nt.HLT_IsoTkMu24()); }
-            catch (const runtime_error& error) { /* Do nothing */ }
-            break;
-        case (2017):
-            try { passed = (passed || nt.HLT_IsoMu27()); }
-            catch (const runtime_error& error) { /* Do nothing */ }
-            break;
-        case (2018):
-            try { passed = (passed || nt.HLT_IsoMu24()); }
-            catch (const runtime_error& error) { /* Do nothing */ }
-            break;
-        }
-        return passed;
+        return triggers.passes(muon_triggers, fired);
     };
 
     bool passesElecTriggers()
     {
-        bool passed = false;
-        switch (nt.year())
-        {
-        case (2016):
-            try { passed = (passed || nt.HLT_Ele27_WPTight_Gsf()); }
-            catch (const runtime_error& error) { /* Do nothing */ }
-            break;
-        case (2017):
-            try { passed = (passed || nt.HLT_Ele32_WPTight_Gsf_L1DoubleEG()); }
-            catch (const runtime_error& error) { /* Do nothing */ }
-            break;
-        case (2018):
-            try { passed = (passed || nt.HLT_Ele32_WPTight_Gsf()); }
-            catch (const runtime_error& error) { /* Do nothing */ }
-            break;
-        }
-        return (passed && !passesMuonTriggers());
+        return (triggers.passes(elec_triggers, fired) && !passesMuonTriggers());
     };
 
     bool passesLepTriggers(unsigned int abs_lep_pdgID)
     {
+        fired = triggers.fire(nt);
         if (!nt.isData()) 
         { 
             /* Below is what was done for SS, but PKU does what is currently implemented
@@ -358,17 +388,22 @@ public:
         }
         else
         {
-            TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
-            if (file_name.Contains("SingleMuon"))
+            // Data stream only changes with the file
+            if (stream_file_index != triggers.getFileIndex())
             {
-                return passesMuonTriggers();
+                TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
+                if (file_name.Contains("SingleMuon")) { stream = SingleMuon; }
+                else if (file_name.Contains("SingleElectron") || file_name.Contains("EGamma")) { stream = SingleElectron; }
+                else { stream = Other; }
+                stream_file_index = triggers.getFileIndex();
             }
-            else if (file_name.Contains("SingleElectron") || file_name.Contains("EGamma"))
+            switch (stream)
             {
+            case (SingleMuon):
+                return passesMuonTriggers();
+            case (SingleElectron):
                 return (passesElecTriggers() && !passesMuonTriggers());
-            }
-            else
-            {
+            default:
                 return (passesMuonTriggers() || passesElecTriggers());
             }
         }
@@ -449,7 +484,7 @@ public:
         }
         if (best_hbbjet_i < 0) { return false; }
         // Find number of gen-level b quarks in Hbb jet cone
-        LorentzVector best_hbbjet_p4 = globals.getVal<LorentzVectors>("good_fatjet_p4s").at(best_hbbjet_i);
+        LorentzVector best_hbbjet_p4 = globals.getVal<SoA::P4Views>("good_fatjet_p4s").at(best_hbbjet_i);
         int n_hbbjet_genbquarks = 0;
         if (!nt.isData())
         {
@@ -485,6 +520,7 @@ class SelectJetsNoHbbOverlap : public Core::SelectJets
 {
 public:
     LorentzVector hbbjet_p4;
+    Overlap::Mask hbb_keep_mask;
 
     SelectJetsNoHbbOverlap(std::string name, Core::Analysis& analysis, JetEnergyScales* jes = nullptr, 
                            BTagSFs* btag_sfs = nullptr, PileUpJetIDSFs* puid_sfs = nullptr) 
@@ -495,19 +531,19 @@ public:
 
     void loadOverlapVars()
     {
-        veto_lep_p4s = globals.getVal<LorentzVectors>("veto_lep_p4s");
-        veto_lep_jet_idxs = globals.getVal<Integers>("veto_lep_jet_idxs");
+        lep_keep_mask = getLeptonKeepMask();
         hbbjet_p4 = globals.getVal<LorentzVector>("hbbjet_p4");
+        hbb_keep_mask = Overlap::keepMask(soa.jets(), LorentzVectors({hbbjet_p4}), 0.8);
     };
 
-    bool overlapsHbbJet(LorentzVector jet_p4)
+    bool overlapsHbbJet(int jet_i)
     {
-        return ROOT::Math::VectorUtil::DeltaR(hbbjet_p4, jet_p4) < 0.8;
+        return !hbb_keep_mask[jet_i];
     };
 
     bool isOverlap(int jet_i, LorentzVector jet_p4)
     {
-        return overlapsLepton(jet_i, jet_p4) || overlapsHbbJet(jet_p4);
+        return overlapsLepton(jet_i) || overlapsHbbJet(jet_i);
     };
 };
 
@@ -556,7 +592,7 @@ public:
 
     virtual bool evaluate()
     {
-        LorentzVectors veto_lep_p4s = globals.getVal<LorentzVectors>("veto_lep_p4s");
+        SoA::P4Views veto_lep_p4s = globals.getVal<SoA::P4Views>("veto_lep_p4s");
         Integers veto_lep_pdgIDs = globals.getVal<Integers>("veto_lep_pdgIDs");
         Integers veto_lep_idxs = globals.getVal<Integers>("veto_lep_idxs");
         int n_tight_leps = 0;
@@ -759,49 +795,20 @@ public:
         ewk_fix = new SFHist("data/ewk_fix.root", "Wgt__pdgid5_quarks_pt_varbin");
     };
 
-    int getChargeQx3(int q_pdgID)
-    {
-        switch (abs(q_pdgID))
-        {
-        case 1:
-            return -1; // down
-        case 2:
-            return  2; // up
-        case 3:
-            return -1; // strange
-        case 4:
-            return  2; // charm
-        case 5:
-            return -1; // bottom
-        case 6:
-            return  2; // top
-        default:
-            return -999;
-        }
-    };
-
-    double getChargeQQ(int q1_pdgID, int q2_pdgID)
-    {
-        int q1_sign = (q1_pdgID > 0) - (q1_pdgID < 0);
-        int q2_sign = (q2_pdgID > 0) - (q2_pdgID < 0);
-        return (q1_sign*getChargeQx3(q1_pdgID) + q2_sign*getChargeQx3(q2_pdgID)) / 3.;
-    };
-
     bool evaluate()
     {
         TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
         if (file_name.Contains("EWKWPlus") || file_name.Contains("EWKWMinus"))
         {
-            int q1_pdgID = nt.LHEPart_pdgId().at(4);
-            int q2_pdgID = nt.LHEPart_pdgId().at(5);
-            LorentzVector q1_p4 = nt.LHEPart_p4().at(4);
-            LorentzVector q2_p4 = nt.LHEPart_p4().at(5);
-            double M_qq = (q1_p4 + q2_p4).M();
-            LorentzVector lep_p4 = nt.LHEPart_p4().at(2);
-            LorentzVector nu_p4 = nt.LHEPart_p4().at(3);
-            double M_lnu = (lep_p4 + nu_p4).M();
+            const LHE::HardProcess& hard_process = lhe.hardProcess();
+            int q1_pdgID = hard_process.quarks.at(0).pdgID;
+            int q2_pdgID = hard_process.quarks.at(1).pdgID;
+            LorentzVector q1_p4 = hard_process.quarks.at(0).p4;
+            LorentzVector q2_p4 = hard_process.quarks.at(1).p4;
+            double M_qq = hard_process.M_qq;
+            double M_lnu = hard_process.M_lnu;
             bool is_WW = (
-                fabs(getChargeQQ(q1_pdgID, q2_pdgID)) == 1 
+                fabs(hard_process.charge_qq) == 1 
                 && M_qq >= 70 && M_qq < 90 
                 && M_lnu >= 70 && M_lnu < 90
             );
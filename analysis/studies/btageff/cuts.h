@@ -41,7 +41,7 @@ public:
 
     bool evaluate()
     {
-        LorentzVectors good_jet_p4s = globals.getVal<LorentzVectors>("good_jet_p4s");
+        SoA::P4Views good_jet_p4s = globals.getVal<SoA::P4Views>("good_jet_p4s");
         Integers good_jet_idxs = globals.getVal<Integers>("good_jet_idxs");
         for (unsigned int good_jet_i = 0; good_jet_i < good_jet_p4s.size(); ++good_jet_i)
         {
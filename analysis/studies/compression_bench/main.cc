@@ -0,0 +1,144 @@
+// STL
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+// VBS
+#include "core/output.h"
+#include "core/rntuple.h"
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#ifdef RNTUPLE_SUPPORTED
+#include <ROOT/RNTupleReader.hxx>
+#endif
+#include "stdio.h"
+
+/* Size, write and read throughput of a baby or a skim with each compression setting of
+   --compression (see core/output.h). The entries of the input TTree are copied to a TTree (and,
+   with ROOT 6.32 or later, to an RNTuple) with each setting; the time to read the input alone is
+   measured first and subtracted. Every output is then read back in full, from the page cache, so
+   the read times are those of decompression and deserialization rather than of the disk. Settings
+   are given after the output directory (default: a spread of all four algorithms), e.g.
+
+       make study=compression_bench
+       ./bin/compression_bench studies/vbsvvhjets/output_{TAG}/Run2/QCD.root tree /tmp
+       ./bin/compression_bench /path/to/skim.root Events /tmp zstd:5 lzma:9
+*/
+double seconds(std::function<void()> run)
+{
+    auto start = std::chrono::steady_clock::now();
+    run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+double fileSize(std::string file_name)
+{
+    TFile* tfile = TFile::Open(file_name.c_str());
+    double file_bytes = tfile->GetSize();
+    tfile->Close();
+    delete tfile;
+    return file_bytes;
+}
+
+void print(std::string format, std::string compression, double n_entries, double n_bytes, double write_s,
+           double read_s, double file_bytes)
+{
+    printf(
+        "%-8s %-8s %10.1f %8.2f %10.0f %10.1f %10.0f %10.1f\n",
+        format.c_str(), compression.c_str(), file_bytes/1e6, n_bytes/file_bytes, n_entries/write_s,
+        n_bytes/1e6/write_s, n_entries/read_s, n_bytes/1e6/read_s
+    );
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s /path/to/input.root [ttree_name] [output_dir] [compression ...]\n", argv[0]);
+        return 1;
+    }
+    std::string input_file = argv[1];
+    std::string ttree_name = (argc > 2) ? argv[2] : "Events";
+    std::string output_dir = (argc > 3) ? argv[3] : ".";
+    std::vector<std::string> compressions = {"default", "zlib:1", "lz4:4", "zstd:1", "zstd:5", "zstd:9", "lzma:7", "lzma:9"};
+    if (argc > 4) { compressions.assign(argv + 4, argv + argc); }
+    std::string ttree_file = output_dir + "/compression_bench_ttree.root";
+    std::string rntuple_file = output_dir + "/compression_bench_rntuple.root";
+
+    TFile* input_tfile = TFile::Open(input_file.c_str());
+    TTree* input = (TTree*) input_tfile->Get(ttree_name.c_str());
+    if (!input)
+    {
+        printf("no TTree named %s in %s\n", ttree_name.c_str(), input_file.c_str());
+        return 1;
+    }
+    RNTuples::InputBuffers buffers = RNTuples::InputBuffers(input);
+    const Long64_t n_entries = input->GetEntries();
+    const double n_bytes = input->GetTotBytes(); // uncompressed
+
+    // Input alone (run twice, so that the file is in the page cache for every measurement)
+    double input_s = 0;
+    for (unsigned int rep_i = 0; rep_i < 2; ++rep_i)
+    {
+        input_s = seconds([&]() { for (Long64_t entry = 0; entry < n_entries; ++entry) { input->GetEntry(entry); } });
+    }
+
+    printf("%lld entries, %.1f MB uncompressed, %.2f s to read the input\n", n_entries, n_bytes/1e6, input_s);
+    printf(
+        "%-8s %-8s %10s %8s %10s %10s %10s %10s\n",
+        "format", "setting", "file MB", "ratio", "write ev/s", "write MB/s", "read ev/s", "read MB/s"
+    );
+    for (auto& compression_name : compressions)
+    {
+        const int compression = Output::getCompression(compression_name);
+
+        // TTree
+        double ttree_write_s = seconds([&]() {
+            TFile* ttree_tfile = new TFile(ttree_file.c_str(), "RECREATE");
+            TTree* output = input->CloneTree(0);
+            Output::setCompression(ttree_tfile, output, compression);
+            for (Long64_t entry = 0; entry < n_entries; ++entry)
+            {
+                input->GetEntry(entry);
+                output->Fill();
+            }
+            ttree_tfile->cd();
+            output->Write();
+            ttree_tfile->Close();
+            delete ttree_tfile;
+        }) - input_s;
+        double ttree_read_s = seconds([&]() {
+            TFile* tfile = TFile::Open(ttree_file.c_str());
+            TTree* ttree = (TTree*) tfile->Get(ttree_name.c_str());
+            for (Long64_t entry = 0; entry < n_entries; ++entry) { ttree->GetEntry(entry); }
+            tfile->Close();
+            delete tfile;
+        });
+        print("ttree", compression_name, n_entries, n_bytes, ttree_write_s, ttree_read_s, fileSize(ttree_file));
+
+#ifdef RNTUPLE_SUPPORTED
+        // RNTuple
+        double rntuple_write_s = seconds([&]() {
+            TFile* rntuple_tfile = new TFile(rntuple_file.c_str(), "RECREATE");
+            RNTuples::Writer rntuple = RNTuples::Writer(input, rntuple_tfile, ttree_name);
+            rntuple.setCompression(compression);
+            for (Long64_t entry = 0; entry < n_entries; ++entry)
+            {
+                input->GetEntry(entry);
+                rntuple.fill();
+            }
+            rntuple.write();
+            rntuple_tfile->Close();
+            delete rntuple_tfile;
+        }) - input_s;
+        double rntuple_read_s = seconds([&]() {
+            auto reader = RNTuples::API::RNTupleReader::Open(ttree_name, rntuple_file);
+            for (Long64_t entry = 0; entry < n_entries; ++entry) { reader->LoadEntry(entry); }
+        });
+        print("rntuple", compression_name, n_entries, n_bytes, rntuple_write_s, rntuple_read_s, fileSize(rntuple_file));
+#endif
+    }
+    return 0;
+}
@@ -21,34 +21,6 @@ typedef std::vector<double> Doubles;
 typedef std::vector<int> Integers;
 typedef std::vector<unsigned int> Indices;
 
-int getChargeQx3(int q_pdgID)
-{
-    switch (abs(q_pdgID))
-    {
-    case 1:
-        return -1; // down
-    case 2:
-        return  2; // up
-    case 3:
-        return -1; // strange
-    case 4:
-        return  2; // charm
-    case 5:
-        return -1; // bottom
-    case 6:
-        return  2; // top
-    default:
-        return -999;
-    }
-}
-
-double getChargeQQ(int q1_pdgID, int q2_pdgID)
-{
-    int q1_sign = (q1_pdgID > 0) - (q1_pdgID < 0);
-    int q2_sign = (q2_pdgID > 0) - (q2_pdgID < 0);
-    return (q1_sign*getChargeQx3(q1_pdgID) + q2_sign*getChargeQx3(q2_pdgID)) / 3.;
-}
-
 int getPartonPairNum(unsigned int pdg_id1, unsigned int pdg_id2)
 {
     if (pdg_id1 == 5 && pdg_id2 == 5) { return 0; } // b, b
@@ -153,13 +125,14 @@ int main(int argc, char** argv)
         "FindLHEQuarks",
         [&]()
         {
-            arbol.setLeaf<int>("lhe_parton1_pdgID", nt.LHEPart_pdgId().at(0));
-            arbol.setLeaf<int>("lhe_parton2_pdgID", nt.LHEPart_pdgId().at(1));
-            LorentzVector q1_p4 = nt.LHEPart_p4().at(4);
-            LorentzVector q2_p4 = nt.LHEPart_p4().at(5);
-            int q1_pdgID = nt.LHEPart_pdgId().at(4);
-            int q2_pdgID = nt.LHEPart_pdgId().at(5);
-            double M_qq = (q1_p4 + q2_p4).M();
+            const LHE::HardProcess& hard_process = analysis.lhe.hardProcess();
+            arbol.setLeaf<int>("lhe_parton1_pdgID", hard_process.incoming.at(0).pdgID);
+            arbol.setLeaf<int>("lhe_parton2_pdgID", hard_process.incoming.at(1).pdgID);
+            LorentzVector q1_p4 = hard_process.quarks.at(0).p4;
+            LorentzVector q2_p4 = hard_process.quarks.at(1).p4;
+            int q1_pdgID = hard_process.quarks.at(0).pdgID;
+            int q2_pdgID = hard_process.quarks.at(1).pdgID;
+            double M_qq = hard_process.M_qq;
             arbol.setLeaf<double>("lhe_M_qq", M_qq);
             arbol.setLeaf<double>("lhe_deta_qq", q1_p4.eta() - q2_p4.eta());
             if (q1_p4.pt() > q2_p4.pt())
@@ -172,13 +145,11 @@ int main(int argc, char** argv)
                 arbol.setLeaf<int>("lhe_ld_q_pdgID", q2_pdgID);
                 arbol.setLeaf<int>("lhe_tr_q_pdgID", q1_pdgID);
             }
-            LorentzVector lep_p4 = nt.LHEPart_p4().at(2);
-            LorentzVector nu_p4 = nt.LHEPart_p4().at(3);
-            double M_lnu = (lep_p4 + nu_p4).M();
+            double M_lnu = hard_process.M_lnu;
             arbol.setLeaf<double>("lhe_M_lnu", M_lnu);
-            arbol.setLeaf<int>("lhe_lep_pdgID", nt.LHEPart_pdgId().at(2));
-            arbol.setLeaf<double>("lhe_M_lnuqq", (lep_p4 + nu_p4 + q1_p4 + q2_p4).M());
-            double charge_qq = getChargeQQ(q1_pdgID, q2_pdgID);
+            arbol.setLeaf<int>("lhe_lep_pdgID", hard_process.leptons.at(0).pdgID);
+            arbol.setLeaf<double>("lhe_M_lnuqq", (hard_process.lnu_p4 + hard_process.qq_p4).M());
+            double charge_qq = hard_process.charge_qq;
             if (fabs(charge_qq) == 1 && M_qq >= 70 && M_qq < 90 && M_lnu >= 70 && M_lnu < 90)
             {
                 arbol.setLeaf<bool>("lhe_is_WW", true);
@@ -443,7 +414,7 @@ int main(int argc, char** argv)
                 n_fatjets++;
                 double pnet_xbb = nt.FatJet_particleNetMD_Xbb().at(fatjet_i);
                 double pnet_qcd = nt.FatJet_particleNetMD_QCD().at(fatjet_i);
-                double xbb_score = pnet_xbb/(pnet_xbb + pnet_qcd);
+                double xbb_score = ParticleNet::xbb(pnet_xbb, pnet_qcd);
                 if (xbb_score > hbbjet_score)
                 {
                     hbbjet_p4 = fatjet_p4;
@@ -24,7 +24,7 @@ int main(int argc, char** argv)
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli);
+    Input::Looper looper = Input::Looper(cli);
 
     // Initialize Arbol
     Arbol arbol = Arbol(cli);
@@ -128,14 +128,11 @@ int main(int argc, char** argv)
         {
             TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
             if (!file_name.Contains("WJetsToLNu_TuneCP5")) { return true; }
+            // Outgoing quarks only: the incoming partons have no pt, and there are no top quarks here
             double lhe_ht = 0.;
-            for (unsigned int lhe_i = 0; lhe_i < nt.nLHEPart(); ++lhe_i)
+            for (auto& quark : analysis.lhe.hardProcess().quarks)
             {
-                int pdg_id = nt.LHEPart_pdgId().at(lhe_i);
-                if (abs(pdg_id) < 7) 
-                {
-                    lhe_ht += nt.LHEPart_pt().at(lhe_i);
-                }
+                lhe_ht += quark.p4.pt();
             }
             return (lhe_ht < 70);
         }
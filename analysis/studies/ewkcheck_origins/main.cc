@@ -19,7 +19,7 @@ int main(int argc, char** argv)
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli);
+    Input::Looper looper = Input::Looper(cli);
 
     // Initialize Arbol
     Arbol arbol = Arbol(cli);
@@ -76,37 +76,26 @@ int main(int argc, char** argv)
             TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
             if (file_name.Contains("EWKW") || file_name.Contains("EWKZ") || file_name.Contains("WWTo"))
             {
-                arbol.setLeaf<int>("lhe_parton1_pdgID", nt.LHEPart_pdgId().at(0));
-                arbol.setLeaf<int>("lhe_parton2_pdgID", nt.LHEPart_pdgId().at(1));
-                LorentzVector q1_p4 = nt.LHEPart_p4().at(4);
-                LorentzVector q2_p4 = nt.LHEPart_p4().at(5);
-                arbol.setLeaf<double>("lhe_M_qq", (q1_p4 + q2_p4).M());
-                arbol.setLeaf<double>("lhe_deta_qq", q1_p4.eta() - q2_p4.eta());
-                if (q1_p4.pt() > q2_p4.pt())
-                {
-                    arbol.setLeaf<int>("lhe_ld_q_pdgID", nt.LHEPart_pdgId().at(4));
-                    arbol.setLeaf<int>("lhe_tr_q_pdgID", nt.LHEPart_pdgId().at(5));
-                    arbol.setLeaf<double>("lhe_ld_q_pt", nt.LHEPart_pt().at(4));
-                    arbol.setLeaf<double>("lhe_tr_q_pt", nt.LHEPart_pt().at(5));
-                    arbol.setLeaf<double>("lhe_ld_q_eta", nt.LHEPart_eta().at(4));
-                    arbol.setLeaf<double>("lhe_tr_q_eta", nt.LHEPart_eta().at(5));
-                }
-                else
-                {
-                    arbol.setLeaf<int>("lhe_ld_q_pdgID", nt.LHEPart_pdgId().at(5));
-                    arbol.setLeaf<int>("lhe_tr_q_pdgID", nt.LHEPart_pdgId().at(4));
-                    arbol.setLeaf<double>("lhe_ld_q_pt", nt.LHEPart_pt().at(5));
-                    arbol.setLeaf<double>("lhe_tr_q_pt", nt.LHEPart_pt().at(4));
-                    arbol.setLeaf<double>("lhe_ld_q_eta", nt.LHEPart_eta().at(5));
-                    arbol.setLeaf<double>("lhe_tr_q_eta", nt.LHEPart_eta().at(4));
-                }
+                const LHE::HardProcess& hard_process = analysis.lhe.hardProcess();
+                arbol.setLeaf<int>("lhe_parton1_pdgID", hard_process.incoming.at(0).pdgID);
+                arbol.setLeaf<int>("lhe_parton2_pdgID", hard_process.incoming.at(1).pdgID);
+                const LHE::Particle& q1 = hard_process.quarks.at(0);
+                const LHE::Particle& q2 = hard_process.quarks.at(1);
+                arbol.setLeaf<double>("lhe_M_qq", hard_process.M_qq);
+                arbol.setLeaf<double>("lhe_deta_qq", q1.p4.eta() - q2.p4.eta());
+                const LHE::Particle& ld_q = (q1.p4.pt() > q2.p4.pt()) ? q1 : q2;
+                const LHE::Particle& tr_q = (q1.p4.pt() > q2.p4.pt()) ? q2 : q1;
+                arbol.setLeaf<int>("lhe_ld_q_pdgID", ld_q.pdgID);
+                arbol.setLeaf<int>("lhe_tr_q_pdgID", tr_q.pdgID);
+                arbol.setLeaf<double>("lhe_ld_q_pt", ld_q.p4.pt());
+                arbol.setLeaf<double>("lhe_tr_q_pt", tr_q.p4.pt());
+                arbol.setLeaf<double>("lhe_ld_q_eta", ld_q.p4.eta());
+                arbol.setLeaf<double>("lhe_tr_q_eta", tr_q.p4.eta());
                 if (file_name.Contains("To1L1Nu") || file_name.Contains("ToLNu"))
                 {
-                    LorentzVector lep_p4 = nt.LHEPart_p4().at(2);
-                    LorentzVector nu_p4 = nt.LHEPart_p4().at(3);
-                    arbol.setLeaf<double>("lhe_M_lnu", (lep_p4 + nu_p4).M());
-                    arbol.setLeaf<int>("lhe_lep_pdgID", nt.LHEPart_pdgId().at(2));
-                    arbol.setLeaf<double>("lhe_M_lnuqq", (lep_p4 + nu_p4 + q1_p4 + q2_p4).M());
+                    arbol.setLeaf<double>("lhe_M_lnu", hard_process.M_lnu);
+                    arbol.setLeaf<int>("lhe_lep_pdgID", hard_process.leptons.at(0).pdgID);
+                    arbol.setLeaf<double>("lhe_M_lnuqq", (hard_process.lnu_p4 + hard_process.qq_p4).M());
                 }
             }
             return true;
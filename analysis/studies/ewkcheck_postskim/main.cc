@@ -3,6 +3,9 @@
 #include "hepcli.h"
 #include "looper.h"
 #include "histflow.h"
+// VBS
+#include "core/particlenet.h"   // ParticleNet::xbb
+#include "core/lhe.h"           // LHE::HardProcess
 // ROOT
 #include "TString.h"
 #include "TObject.h"
@@ -19,34 +22,6 @@ typedef std::vector<double> Doubles;
 typedef std::vector<int> Integers;
 typedef std::vector<unsigned int> Indices;
 
-int getChargeQx3(int q_pdgID)
-{
-    switch (abs(q_pdgID))
-    {
-    case 1:
-        return -1; // down
-    case 2:
-        return  2; // up
-    case 3:
-        return -1; // strange
-    case 4:
-        return  2; // charm
-    case 5:
-        return -1; // bottom
-    case 6:
-        return  2; // top
-    default:
-        return -999;
-    }
-}
-
-double getChargeQQ(int q1_pdgID, int q2_pdgID)
-{
-    int q1_sign = (q1_pdgID > 0) - (q1_pdgID < 0);
-    int q2_sign = (q2_pdgID > 0) - (q2_pdgID < 0);
-    return (q1_sign*getChargeQx3(q1_pdgID) + q2_sign*getChargeQx3(q2_pdgID)) / 3.;
-}
-
 int main(int argc, char** argv) 
 {
     // CLI
@@ -122,12 +97,13 @@ int main(int argc, char** argv)
         "FindLHEQuarks",
         [&]()
         {
+            LHE::HardProcess hard_process = LHE::HardProcess(nt);
             // Set LHE quark leaves
-            int q1_pdgID = nt.LHEPart_pdgId().at(4);
-            int q2_pdgID = nt.LHEPart_pdgId().at(5);
-            LorentzVector q1_p4 = nt.LHEPart_p4().at(4);
-            LorentzVector q2_p4 = nt.LHEPart_p4().at(5);
-            arbol.setLeaf<int>("lhe_charge_qq", getChargeQQ(q1_pdgID, q2_pdgID));
+            int q1_pdgID = hard_process.quarks.at(0).pdgID;
+            int q2_pdgID = hard_process.quarks.at(1).pdgID;
+            LorentzVector q1_p4 = hard_process.quarks.at(0).p4;
+            LorentzVector q2_p4 = hard_process.quarks.at(1).p4;
+            arbol.setLeaf<int>("lhe_charge_qq", hard_process.charge_qq);
             arbol.setLeaf<double>("lhe_deta_qq", q1_p4.eta() - q2_p4.eta());
             if (q1_p4.pt() > q2_p4.pt())
             {
@@ -152,14 +128,14 @@ int main(int argc, char** argv)
                 arbol.setLeaf<double>("lhe_tr_q_phi", q1_p4.phi());
             }
             // Set LHE lepton leaves
-            LorentzVector lep_p4 = nt.LHEPart_p4().at(2);
-            arbol.setLeaf<int>("lhe_lep_pdgID", nt.LHEPart_pdgId().at(2));
+            LorentzVector lep_p4 = hard_process.leptons.at(0).p4;
+            arbol.setLeaf<int>("lhe_lep_pdgID", hard_process.leptons.at(0).pdgID);
             arbol.setLeaf<double>("lhe_lep_pt", lep_p4.pt());
             arbol.setLeaf<double>("lhe_lep_eta", lep_p4.eta());
             arbol.setLeaf<double>("lhe_lep_phi", lep_p4.phi());
             // Set LHE neutrino leaves
-            LorentzVector nu_p4 = nt.LHEPart_p4().at(3);
-            arbol.setLeaf<int>("lhe_nu_pdgID", nt.LHEPart_pdgId().at(3));
+            LorentzVector nu_p4 = hard_process.neutrinos.at(0).p4;
+            arbol.setLeaf<int>("lhe_nu_pdgID", hard_process.neutrinos.at(0).pdgID);
             arbol.setLeaf<double>("lhe_nu_pt", nu_p4.pt());
             arbol.setLeaf<double>("lhe_nu_eta", nu_p4.eta());
             arbol.setLeaf<double>("lhe_nu_phi", nu_p4.phi());
@@ -292,7 +268,7 @@ int main(int argc, char** argv)
                 n_fatjets++;
                 double pnet_xbb = nt.FatJet_particleNetMD_Xbb().at(fatjet_i);
                 double pnet_qcd = nt.FatJet_particleNetMD_QCD().at(fatjet_i);
-                double xbb_score = pnet_xbb/(pnet_xbb + pnet_qcd);
+                double xbb_score = ParticleNet::xbb(pnet_xbb, pnet_qcd);
                 if (xbb_score > hbbjet_score)
                 {
                     hbbjet_p4 = fatjet_p4;
@@ -0,0 +1,319 @@
+// STL
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <functional>
+// VBS
+#include "core/fastmath.h"
+#include "stdio.h"
+
+/* Accuracy and speed of FastMath against libm. For every function, the maximum error (in ulp of
+   the libm result) is measured on two sets and checked against the bound quoted in
+   core/fastmath.h: 8 x n_values uniformly random values over its documented domain, and edge
+   cases that random values practically never hit (the floats around multiples of pi/2, signed
+   zeros and subnormals, the ends of the exp domain and the switch of sinh at |x| = 1, and for
+   atan2 the octant boundaries and the switch at tan(pi/8)). The time per call is measured over
+   arrays of typical kinematics. Exits with 1 if any bound is exceeded.
+
+       make study=fastmath_bench
+       ./bin/fastmath_bench [n_values]
+*/
+template<typename T>
+double ulps(T fast, T ref)
+{
+    if (fast == ref || (std::isnan(fast) && std::isnan(ref))) { return 0; }
+    T ulp = std::nextafter(std::fabs(ref), std::numeric_limits<T>::infinity()) - std::fabs(ref);
+    return std::fabs(double(fast) - double(ref))/double(ulp);
+}
+
+/* x and its n nearest floating-point neighbours on either side */
+template<typename T>
+std::vector<T> around(T x, unsigned int n = 4)
+{
+    std::vector<T> values = {x};
+    T below = x;
+    T above = x;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        below = std::nextafter(below, -std::numeric_limits<T>::infinity());
+        above = std::nextafter(above, std::numeric_limits<T>::infinity());
+        values.insert(values.end(), {below, above});
+    }
+    return values;
+};
+
+/* Signed zeros, subnormals and the smallest normals */
+template<typename T>
+std::vector<T> tiny()
+{
+    T denorm_min = std::numeric_limits<T>::denorm_min();
+    T norm_min = std::numeric_limits<T>::min();
+    std::vector<T> values = {T(0), T(-0.)};
+    for (T value : {denorm_min, 2*denorm_min, norm_min/2, std::nextafter(norm_min, T(0)), norm_min})
+    {
+        values.insert(values.end(), {value, -value});
+    }
+    return values;
+};
+
+/* Best of a few repetitions, in ns per value */
+double timeLoop(std::function<void()> loop, unsigned int n_values)
+{
+    double best = std::numeric_limits<double>::infinity();
+    for (unsigned int rep_i = 0; rep_i < 5; ++rep_i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        loop();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count()/n_values);
+    }
+    return best;
+}
+
+template<typename T>
+struct Bench
+{
+    std::string type_name;
+    unsigned int n_values;
+    std::mt19937_64 rng;
+    std::vector<T> x, y, out_libm, out_fast;
+    bool passed;
+
+    Bench(std::string new_type_name, unsigned int new_n_values)
+    : type_name(new_type_name), n_values(new_n_values), rng(1234), passed(true)
+    {
+        x.resize(n_values);
+        y.resize(n_values);
+        out_libm.resize(n_values);
+        out_fast.resize(n_values);
+    };
+
+    void fill(std::vector<T>& values, double low, double high)
+    {
+        std::uniform_real_distribution<double> uniform(low, high);
+        for (auto& value : values) { value = uniform(rng); }
+    };
+
+    double maxError() const
+    {
+        double max_error = 0;
+        for (unsigned int i = 0; i < n_values; ++i)
+        {
+            max_error = std::max(max_error, ulps(out_fast[i], out_libm[i]));
+        }
+        return max_error;
+    };
+
+    /* Edge cases of a function with the domain [low, high] (see the top of this file); for
+       atan2, every pair of them is used as (x, y) */
+    std::vector<T> edgeCases(std::string name, double low, double high) const
+    {
+        std::vector<T> candidates = tiny<T>();
+        if (name == "sin" || name == "cos")
+        {
+            // Every multiple of pi/2 up to 1000, then a sparse sample of them up to the end of the domain
+            for (double k = 1; k*M_PI/2 <= high; k += (k < 1000) ? 1 : std::floor(k/1000)*97)
+            {
+                for (double sign : {-1., 1.})
+                {
+                    std::vector<T> values = around(T(sign*k*M_PI/2));
+                    candidates.insert(candidates.end(), values.begin(), values.end());
+                }
+            }
+        }
+        else if (name == "atan2")
+        {
+            for (double value : {1., 0.41421356237309503, 2.4142135623730951, 1000.})
+            {
+                for (double sign : {-1., 1.})
+                {
+                    std::vector<T> values = around(T(sign*value), 2);
+                    candidates.insert(candidates.end(), values.begin(), values.end());
+                }
+            }
+        }
+        else
+        {
+            for (double value : {low, high, -1., 1.})
+            {
+                std::vector<T> values = around(T(value), 8);
+                candidates.insert(candidates.end(), values.begin(), values.end());
+            }
+        }
+        std::vector<T> edges;
+        for (auto& value : candidates)
+        {
+            if (value >= low && value <= high) { edges.push_back(value); }
+        }
+        return edges;
+    };
+
+    double maxEdgeError(std::string name, double low, double high, std::function<T(T, T)> libm,
+                        std::function<T(T, T)> fast) const
+    {
+        std::vector<T> edges = edgeCases(name, low, high);
+        std::vector<T> ys = (name == "atan2") ? edges : std::vector<T>(1, T(0));
+        double max_error = 0;
+        for (auto& x_i : edges)
+        {
+            for (auto& y_i : ys)
+            {
+                max_error = std::max(max_error, ulps(fast(x_i, y_i), libm(x_i, y_i)));
+            }
+        }
+        return max_error;
+    };
+
+    /* Accuracy over [low, high] (and over the same range in y, for atan2) and its edge cases, and
+       speed over [bench_low, bench_high] */
+    void run(std::string name, double bound, double low, double high, double bench_low, double bench_high,
+             std::function<T(T, T)> libm, std::function<T(T, T)> fast)
+    {
+        T* __restrict xs = x.data();
+        T* __restrict ys = y.data();
+        T* __restrict libm_vals = out_libm.data();
+        T* __restrict fast_vals = out_fast.data();
+        // Accuracy
+        double max_error = 0;
+        for (unsigned int round_i = 0; round_i < 8; ++round_i)
+        {
+            fill(x, low, high);
+            fill(y, low, high);
+            for (unsigned int i = 0; i < n_values; ++i)
+            {
+                libm_vals[i] = libm(xs[i], ys[i]);
+                fast_vals[i] = fast(xs[i], ys[i]);
+            }
+            max_error = std::max(max_error, maxError());
+        }
+        double max_edge_error = maxEdgeError(name, low, high, libm, fast);
+        // Speed
+        fill(x, bench_low, bench_high);
+        fill(y, bench_low, bench_high);
+        const unsigned int n = n_values;
+        double libm_ns = 0;
+        double fast_ns = 0;
+        if (name == "exp")
+        {
+            libm_ns = timeLoop([&]() { for (unsigned int i = 0; i < n; ++i) { libm_vals[i] = std::exp(xs[i]); } }, n);
+            fast_ns = timeLoop([&]() {
+                #pragma omp simd
+                for (unsigned int i = 0; i < n; ++i) { fast_vals[i] = FastMath::exp(xs[i]); }
+            }, n);
+        }
+        else if (name == "sinh")
+        {
+            libm_ns = timeLoop([&]() { for (unsigned int i = 0; i < n; ++i) { libm_vals[i] = std::sinh(xs[i]); } }, n);
+            fast_ns = timeLoop([&]() {
+                #pragma omp simd
+                for (unsigned int i = 0; i < n; ++i) { fast_vals[i] = FastMath::sinh(xs[i]); }
+            }, n);
+        }
+        else if (name == "cosh")
+        {
+            libm_ns = timeLoop([&]() { for (unsigned int i = 0; i < n; ++i) { libm_vals[i] = std::cosh(xs[i]); } }, n);
+            fast_ns = timeLoop([&]() {
+                #pragma omp simd
+                for (unsigned int i = 0; i < n; ++i) { fast_vals[i] = FastMath::cosh(xs[i]); }
+            }, n);
+        }
+        else if (name == "sin" || name == "cos")
+        {
+            libm_ns = timeLoop([&]() {
+                for (unsigned int i = 0; i < n; ++i) { libm_vals[i] = std::sin(xs[i]); ys[i] = std::cos(xs[i]); }
+            }, n);
+            fast_ns = timeLoop([&]() {
+                #pragma omp simd
+                for (unsigned int i = 0; i < n; ++i) { FastMath::sincos(xs[i], fast_vals[i], ys[i]); }
+            }, n);
+        }
+        else if (name == "atan2")
+        {
+            libm_ns = timeLoop([&]() { for (unsigned int i = 0; i < n; ++i) { libm_vals[i] = std::atan2(ys[i], xs[i]); } }, n);
+            fast_ns = timeLoop([&]() {
+                #pragma omp simd
+                for (unsigned int i = 0; i < n; ++i) { fast_vals[i] = FastMath::atan2(ys[i], xs[i]); }
+            }, n);
+        }
+        bool ok = (max_error <= bound && max_edge_error <= bound);
+        passed = passed && ok;
+        printf(
+            "%-7s %-6s %10.3g %10.3g %8.2f %8.2f %6.1f %10.2f %10.2f %7.1fx\n",
+            type_name.c_str(), name.c_str(), low, high, max_error, max_edge_error, bound, libm_ns, fast_ns,
+            libm_ns/fast_ns
+        );
+    };
+
+    void runAll(double exp_min, double exp_max, double sincos_max)
+    {
+        run("exp", 2, exp_min, exp_max, -10, 10,
+            [](T x, T) { return std::exp(x); }, [](T x, T) { return FastMath::exp(x); });
+        run("sinh", 3, -80, 80, -5, 5,
+            [](T x, T) { return std::sinh(x); }, [](T x, T) { return FastMath::sinh(x); });
+        run("cosh", 3, -80, 80, -5, 5,
+            [](T x, T) { return std::cosh(x); }, [](T x, T) { return FastMath::cosh(x); });
+        run("sin", 3, -sincos_max, sincos_max, -M_PI, M_PI,
+            [](T x, T) { return std::sin(x); }, [](T x, T) { T s, c; FastMath::sincos(x, s, c); return s; });
+        run("cos", 3, -sincos_max, sincos_max, -M_PI, M_PI,
+            [](T x, T) { return std::cos(x); }, [](T x, T) { T s, c; FastMath::sincos(x, s, c); return c; });
+        run("atan2", 4, -1000, 1000, -500, 500,
+            [](T x, T y) { return std::atan2(y, x); }, [](T x, T y) { return FastMath::atan2(y, x); });
+    };
+};
+
+/* The px, py, pz, |p| kernel used by Pairs::Cache, against the same loop with libm calls */
+template<typename T>
+void benchKinematics(std::string type_name, unsigned int n_values)
+{
+    std::mt19937_64 rng(5678);
+    std::uniform_real_distribution<float> uniform_pt(20, 500), uniform_eta(-4.7, 4.7), uniform_phi(-M_PI, M_PI);
+    std::vector<float> pt(n_values), eta(n_values), phi(n_values);
+    for (unsigned int i = 0; i < n_values; ++i)
+    {
+        pt[i] = uniform_pt(rng);
+        eta[i] = uniform_eta(rng);
+        phi[i] = uniform_phi(rng);
+    }
+    std::vector<T> px(n_values), py(n_values), pz(n_values), p(n_values);
+    double libm_ns = timeLoop([&]() {
+        for (unsigned int i = 0; i < n_values; ++i)
+        {
+            px[i] = pt[i]*std::cos(T(phi[i]));
+            py[i] = pt[i]*std::sin(T(phi[i]));
+            pz[i] = pt[i]*std::sinh(T(eta[i]));
+            p[i] = pt[i]*std::cosh(T(eta[i]));
+        }
+    }, n_values);
+    double fast_ns = timeLoop([&]() {
+        FastMath::fillPxPyPz(pt.data(), eta.data(), phi.data(), n_values, px.data(), py.data(), pz.data(), p.data());
+    }, n_values);
+    printf(
+        "%-7s %-6s %10s %10s %8s %8s %6s %10.2f %10.2f %7.1fx\n",
+        type_name.c_str(), "p4", "", "", "", "", "", libm_ns, fast_ns, libm_ns/fast_ns
+    );
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int n_values = (argc > 1) ? std::stoul(argv[1]) : 1 << 20;
+    printf(
+        "%-7s %-6s %10s %10s %8s %8s %6s %10s %10s %8s\n",
+        "type", "func", "low", "high", "max ulp", "edge ulp", "bound", "libm ns", "fast ns", "speedup"
+    );
+    Bench<float> bench_float("float", n_values);
+    bench_float.runAll(-87, 88, 6400);
+    Bench<double> bench_double("double", n_values);
+    bench_double.runAll(-708, 709, 1.6e6);
+    benchKinematics<float>("float", n_values);
+    benchKinematics<double>("double", n_values);
+
+    if (!bench_float.passed || !bench_double.passed)
+    {
+        printf("FAILED: error above the bound quoted in core/fastmath.h\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+// STL
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+// VBS
+#include "corrections/jetvetomaps.h"
+#include "stdio.h"
+
+/* Equality of the JetVetoMaps lookup tables and direct correctionlib lookups, for every UL
+   campaign: at the float values on and next to every bin edge recovered from the correction
+   (crossed with the bin centers of the other axis), on and next to every edge of the 0.01 scan
+   grid, and at uniformly random (eta, phi). Exits with 1 at the first campaign with a mismatch.
+
+       make study=jetvetomaps_check
+       ./bin/jetvetomaps_check [n_random]
+*/
+struct Check
+{
+    JetVetoMaps& jet_veto_maps;
+    unsigned int n_points;
+    unsigned int n_mismatches;
+
+    Check(JetVetoMaps& jet_veto_maps_ref) : jet_veto_maps(jet_veto_maps_ref), n_points(0), n_mismatches(0)
+    {
+        // Do nothing
+    };
+
+    void point(float eta, float phi)
+    {
+        const VetoMaps::Map& map = jet_veto_maps.map;
+        // Only inside of the scanned range, outside of it the map gives its outside value instead
+        if (map.eta_axis.find(eta) < 0 || map.phi_axis.find(phi) < 0) { return; }
+        n_points++;
+        float table_value = map.get(eta, phi);
+        float direct_value = jet_veto_maps.veto_map->evaluate({jet_veto_maps.map_type, double(eta), double(phi)});
+        if (table_value != direct_value)
+        {
+            if (n_mismatches < 10)
+            {
+                printf("    mismatch at eta = %.9g, phi = %.9g: %g (table) != %g (correctionlib)\n",
+                       eta, phi, table_value, direct_value);
+            }
+            n_mismatches++;
+        }
+    };
+
+    /* The float nearest to x and its two neighbours on either side */
+    static std::vector<float> around(double x)
+    {
+        float nearest = float(x);
+        float below = std::nextafter(nearest, -INFINITY);
+        float above = std::nextafter(nearest, INFINITY);
+        return {std::nextafter(below, -INFINITY), below, nearest, above, std::nextafter(above, INFINITY)};
+    };
+
+    static std::vector<double> centers(const std::vector<double>& edges)
+    {
+        std::vector<double> bin_centers;
+        for (unsigned int bin_i = 0; bin_i + 1 < edges.size(); ++bin_i)
+        {
+            bin_centers.push_back(0.5*(edges[bin_i] + edges[bin_i + 1]));
+        }
+        return bin_centers;
+    };
+
+    void edges(const std::vector<double>& eta_edges, const std::vector<double>& phi_edges)
+    {
+        std::vector<double> eta_centers = centers(jet_veto_maps.map.eta_axis.edges);
+        std::vector<double> phi_centers = centers(jet_veto_maps.map.phi_axis.edges);
+        for (auto& eta_edge : eta_edges)
+        {
+            for (auto& eta : around(eta_edge))
+            {
+                for (auto& phi : phi_centers) { point(eta, phi); }
+            }
+        }
+        for (auto& phi_edge : phi_edges)
+        {
+            for (auto& phi : around(phi_edge))
+            {
+                for (auto& eta : eta_centers) { point(eta, phi); }
+            }
+        }
+    };
+
+    void random(unsigned int n_random)
+    {
+        std::mt19937_64 rng(1234);
+        std::uniform_real_distribution<float> uniform_eta(-5.191, 5.191), uniform_phi(-M_PI, M_PI);
+        for (unsigned int point_i = 0; point_i < n_random; ++point_i)
+        {
+            point(uniform_eta(rng), uniform_phi(rng));
+        }
+    };
+};
+
+int main(int argc, char** argv)
+{
+    unsigned int n_random = (argc > 1) ? std::stoul(argv[1]) : 1 << 22;
+    std::vector<std::pair<int, bool>> campaigns = {{2016, true}, {2016, false}, {2017, false}, {2018, false}};
+    for (auto& campaign : campaigns)
+    {
+        JetVetoMaps jet_veto_maps;
+        jet_veto_maps.init(campaign.first, campaign.second);
+        const VetoMaps::Map& map = jet_veto_maps.map;
+        printf("%d%s: %d x %d bins\n", campaign.first, (campaign.second) ? "APV" : "", map.eta_axis.nBins(),
+               map.phi_axis.nBins());
+
+        Check check(jet_veto_maps);
+        // Edges of the correction, as recovered by VetoMaps::fromCorrection
+        check.edges(map.eta_axis.edges, map.phi_axis.edges);
+        // Edges of the scan grid, which the recovered edges must not depend on
+        check.edges(VetoMaps::Axis(1038, -5.191, 5.191).edges, VetoMaps::Axis(628, -M_PI, M_PI).edges);
+        check.random(n_random);
+        printf("    %d points, %d mismatches\n", check.n_points, check.n_mismatches);
+        if (check.n_mismatches > 0)
+        {
+            printf("FAILED: the JetVetoMaps lookup table differs from correctionlib\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,10 +1,12 @@
 // RAPIDO
-#include "LesHouche.h"
 #include "arbol.h"
-#include "looper.h"
+#include "hepcli.h"
 #include "cutflow.h"
+// VBS
+#include "core/lhefile.h"
 // ROOT
 #include "TString.h"
+#include "TChain.h"
 #include "Math/LorentzVector.h"
 #include "Math/GenVector/PtEtaPhiM4D.h"
 #include "stdio.h"
@@ -16,11 +18,16 @@ int main(int argc, char** argv)
     // CLI
     HEPCLI cli = HEPCLI(argc, argv);
 
-    // Initialize LHE (converted to ROOT) reader
-    LesHouche lhe;
+    // LHE files (plain or gzip-compressed), given as the input files of the CLI
+    std::vector<std::string> lhe_files;
+    TObjArray* input_files = cli.input_tchain->GetListOfFiles();
+    for (int file_i = 0; file_i < input_files->GetEntriesFast(); ++file_i)
+    {
+        lhe_files.push_back(input_files->At(file_i)->GetTitle());
+    }
 
-    // Initialize Looper
-    Looper looper = Looper(cli);
+    // Initialize streaming LHE reader
+    LHE::Event lhe;
 
     // Initialize Arbol
     Arbol arbol = Arbol(cli);
@@ -43,10 +50,30 @@ int main(int argc, char** argv)
     arbol.newBranch<double>("M_jj", -999);
     arbol.newBranch<double>("deta_jj", -999);
     arbol.newBranch<double>("ST", -999);
+    arbol.newBranch<std::vector<double>>("reweights", {}); // <rwgt> weights, see the Reweights tree
 
     // Other trees
-    TList* beam_ttrees = new TList();
-    TList* processes_ttrees = new TList();
+    TTree* beam_ttree = new TTree("Beam", "Beam");
+    int beam_pid[2];
+    double beam_E[2];
+    int beam_pdfg[2];
+    int beam_pdfs[2];
+    beam_ttree->Branch("IDBMUP", beam_pid, "IDBMUP[2]/I");
+    beam_ttree->Branch("EBMUP", beam_E, "EBMUP[2]/D");
+    beam_ttree->Branch("PDFGUP", beam_pdfg, "PDFGUP[2]/I");
+    beam_ttree->Branch("PDFSUP", beam_pdfs, "PDFSUP[2]/I");
+    TTree* processes_ttree = new TTree("Processes", "Processes");
+    double proc_xsec;
+    double proc_xerr;
+    double proc_xmax;
+    int proc_id;
+    processes_ttree->Branch("XSECUP", &proc_xsec, "XSECUP/D");
+    processes_ttree->Branch("XERRUP", &proc_xerr, "XERRUP/D");
+    processes_ttree->Branch("XMAXUP", &proc_xmax, "XMAXUP/D");
+    processes_ttree->Branch("LPRUP", &proc_id, "LPRUP/I");
+    TTree* reweights_ttree = new TTree("Reweights", "Reweights");
+    std::vector<std::string> weight_ids;
+    reweights_ttree->Branch("ids", &weight_ids);
 
     // Initialize Cutflow
     Cutflow cutflow = Cutflow();
@@ -55,6 +82,7 @@ int main(int argc, char** argv)
         "Bookkeeping",
         [&]()
         {
+            arbol.setLeaf<std::vector<double>>("reweights", lhe.weights);
             return true;
         }
     );
@@ -85,26 +113,26 @@ int main(int argc, char** argv)
             */
 
             // Incoming partons
-            double q1_pz = lhe.P_Z.At(0);
-            double q2_pz = lhe.P_Z.At(1);
-            double q1_E = lhe.E.At(0); // should be == fabs(pz)
-            double q2_E = lhe.E.At(1); // should be == fabs(pz)
+            double q1_pz = lhe.P_Z.at(0);
+            double q2_pz = lhe.P_Z.at(1);
+            double q1_E = lhe.E.at(0); // should be == fabs(pz)
+            double q2_E = lhe.E.at(1); // should be == fabs(pz)
             arbol.setLeaf<double>("ld_Q_pz", (q1_pz > q2_pz) ? q1_pz : q2_pz);
             arbol.setLeaf<double>("tr_Q_pz", (q1_pz > q2_pz) ? q2_pz : q1_pz);
             arbol.setLeaf<double>("ld_Q_E", (q1_pz > q2_pz) ? q1_E : q2_E);
             arbol.setLeaf<double>("tr_Q_E", (q1_pz > q2_pz) ? q2_E : q1_E);
             // W boson
             LorentzVector W_p4;
-            W_p4.SetPxPyPzE(lhe.P_X.At(2), lhe.P_Y.At(2), lhe.P_Z.At(2), lhe.E.At(2));
-            int W_pdgID = lhe.IDUP.At(2);
+            W_p4.SetPxPyPzE(lhe.P_X.at(2), lhe.P_Y.at(2), lhe.P_Z.at(2), lhe.E.at(2));
+            int W_pdgID = lhe.IDUP.at(2);
             arbol.setLeaf<double>("W_pt", W_p4.pt());
             arbol.setLeaf<double>("W_eta", W_p4.eta());
             arbol.setLeaf<double>("W_phi", W_p4.phi());
             arbol.setLeaf<double>("W_sign", (W_pdgID > 0) - (W_pdgID < 0));
-            arbol.setLeaf<double>("W_pol", lhe.SPINUP.At(2));
+            arbol.setLeaf<double>("W_pol", lhe.SPINUP.at(2));
             // H boson
             LorentzVector H_p4;
-            H_p4.SetPxPyPzE(lhe.P_X.At(3), lhe.P_Y.At(3), lhe.P_Z.At(3), lhe.E.At(3));
+            H_p4.SetPxPyPzE(lhe.P_X.at(3), lhe.P_Y.at(3), lhe.P_Z.at(3), lhe.E.at(3));
             arbol.setLeaf<double>("H_pt", H_p4.pt());
             arbol.setLeaf<double>("H_eta", H_p4.eta());
             arbol.setLeaf<double>("H_phi", H_p4.phi());
@@ -112,9 +140,9 @@ int main(int argc, char** argv)
             arbol.setLeaf<double>("M_WH", (W_p4 + H_p4).mass());
             // VBS jets
             LorentzVector VBS1_p4;
-            VBS1_p4.SetPxPyPzE(lhe.P_X.At(4), lhe.P_Y.At(4), lhe.P_Z.At(4), lhe.E.At(4));
+            VBS1_p4.SetPxPyPzE(lhe.P_X.at(4), lhe.P_Y.at(4), lhe.P_Z.at(4), lhe.E.at(4));
             LorentzVector VBS2_p4;
-            VBS2_p4.SetPxPyPzE(lhe.P_X.At(5), lhe.P_Y.At(5), lhe.P_Z.At(5), lhe.E.At(5));
+            VBS2_p4.SetPxPyPzE(lhe.P_X.at(5), lhe.P_Y.at(5), lhe.P_Z.at(5), lhe.E.at(5));
             if (VBS1_p4.pt() > VBS2_p4.pt())
             {
                 arbol.setLeaf<double>("ld_VBS_pt", VBS1_p4.pt());
@@ -134,43 +162,47 @@ int main(int argc, char** argv)
     );
     cutflow.insert("Bookkeeping", cut, Right);
 
-    // Run looper
-    looper.run(
-        [&](TTree* ttree) 
-        { 
-            lhe.Init(ttree); 
-            // Store metadata ttree
-            TTree* beam_ttree = ((TTree*)ttree->GetCurrentFile()->Get("Beam"))->CloneTree();
-            beam_ttree->SetDirectory(0);
-            beam_ttrees->Add(beam_ttree);
-            TTree* processes_ttree = ((TTree*)ttree->GetCurrentFile()->Get("Processes"))->CloneTree();
-            processes_ttree->SetDirectory(0);
-            processes_ttrees->Add(processes_ttree);
-        },
-        [&](int entry) 
+    // Stream events directly from the LHE files
+    for (auto& lhe_file : lhe_files)
+    {
+        LHE::File reader(lhe_file);
+        // Store metadata
+        for (int beam_i = 0; beam_i < 2; ++beam_i)
+        {
+            beam_pid[beam_i] = reader.init.IDBMUP[beam_i];
+            beam_E[beam_i] = reader.init.EBMUP[beam_i];
+            beam_pdfg[beam_i] = reader.init.PDFGUP[beam_i];
+            beam_pdfs[beam_i] = reader.init.PDFSUP[beam_i];
+        }
+        beam_ttree->Fill();
+        for (int proc_i = 0; proc_i < reader.init.NPRUP; ++proc_i)
+        {
+            proc_xsec = reader.init.XSECUP.at(proc_i);
+            proc_xerr = reader.init.XERRUP.at(proc_i);
+            proc_xmax = reader.init.XMAXUP.at(proc_i);
+            proc_id = reader.init.LPRUP.at(proc_i);
+            processes_ttree->Fill();
+        }
+        // Ids of the reweights of the events of this file, in order
+        weight_ids = reader.weight_ids;
+        reweights_ttree->Fill();
+        while (reader.next(lhe))
         {
-            lhe.GetEntry(entry);
-            lhe.Process(entry);
             // Reset tree
             arbol.resetBranches();
             // Run cutflow
             bool passed = cutflow.run("SetFlatVariables");
             if (passed) { arbol.fill(); }
-            return;
         }
-    );
+    }
 
     // Wrap up
-    TTree* merged_beam_ttrees = TTree::MergeTrees(beam_ttrees);
-    merged_beam_ttrees->SetName("Beam");
-    TTree* merged_processes_ttrees = TTree::MergeTrees(processes_ttrees);
-    merged_processes_ttrees->SetName("Processes");
-
     cutflow.print();
 
     arbol.tfile->cd();
-    merged_beam_ttrees->Write();
-    merged_processes_ttrees->Write();
+    beam_ttree->Write();
+    processes_ttree->Write();
+    reweights_ttree->Write();
     arbol.write();
     return 0;
 }
@@ -1,10 +1,12 @@
 // RAPIDO
-#include "LesHouche.h"
 #include "arbol.h"
-#include "looper.h"
+#include "hepcli.h"
 #include "cutflow.h"
+// VBS
+#include "core/lhefile.h"
 // ROOT
 #include "TString.h"
+#include "TChain.h"
 #include "Math/LorentzVector.h"
 #include "Math/GenVector/PtEtaPhiM4D.h"
 #include "stdio.h"
@@ -16,9 +18,16 @@ int main(int argc, char** argv)
     // CLI
     HEPCLI cli = HEPCLI(argc, argv);
 
-    // Initialize Looper
-    LesHouche lhe;
-    Looper looper = Looper(cli.input_tchain);
+    // LHE files (plain or gzip-compressed), given as the input files of the CLI
+    std::vector<std::string> lhe_files;
+    TObjArray* input_files = cli.input_tchain->GetListOfFiles();
+    for (int file_i = 0; file_i < input_files->GetEntriesFast(); ++file_i)
+    {
+        lhe_files.push_back(input_files->At(file_i)->GetTitle());
+    }
+
+    // Initialize streaming LHE reader
+    LHE::Event lhe;
 
     // Initialize Arbol
     TFile* output_tfile = new TFile(
@@ -49,6 +58,12 @@ int main(int argc, char** argv)
     arbol.newBranch<double>("tr_VBS_pt", -999);
     arbol.newBranch<double>("M_jj", -999);
     arbol.newBranch<double>("deta_jj", -999);
+    arbol.newBranch<std::vector<double>>("reweights", {}); // <rwgt> weights, see the Reweights tree
+
+    // Other trees
+    TTree* reweights_ttree = new TTree("Reweights", "Reweights");
+    std::vector<std::string> weight_ids;
+    reweights_ttree->Branch("ids", &weight_ids);
 
     // Initialize Cutflow
     Cutflow cutflow = Cutflow();
@@ -57,6 +72,7 @@ int main(int argc, char** argv)
         "Bookkeeping",
         [&]()
         {
+            arbol.setLeaf<std::vector<double>>("reweights", lhe.weights);
             return true;
         }
     );
@@ -68,13 +84,13 @@ int main(int argc, char** argv)
         {
             // W bosons
             LorentzVector W1_p4;
-            W1_p4.SetPxPyPzE(lhe.P_X.At(2), lhe.P_Y.At(2), lhe.P_Z.At(2), lhe.E.At(2));
+            W1_p4.SetPxPyPzE(lhe.P_X.at(2), lhe.P_Y.at(2), lhe.P_Z.at(2), lhe.E.at(2));
             LorentzVector W2_p4;
-            W2_p4.SetPxPyPzE(lhe.P_X.At(3), lhe.P_Y.At(3), lhe.P_Z.At(3), lhe.E.At(3));
-            int W1_pid = lhe.IDUP.At(2);
-            double W1_pol = lhe.SPINUP.At(2);
-            int W2_pid = lhe.IDUP.At(3);
-            double W2_pol = lhe.SPINUP.At(3);
+            W2_p4.SetPxPyPzE(lhe.P_X.at(3), lhe.P_Y.at(3), lhe.P_Z.at(3), lhe.E.at(3));
+            int W1_pid = lhe.IDUP.at(2);
+            double W1_pol = lhe.SPINUP.at(2);
+            int W2_pid = lhe.IDUP.at(3);
+            double W2_pol = lhe.SPINUP.at(3);
             if (W1_p4.pt() > W2_p4.pt())
             {
                 arbol.setLeaf<double>("ld_W_pt", W1_p4.pt());
@@ -103,7 +119,7 @@ int main(int argc, char** argv)
             }
             // H boson
             LorentzVector H_p4;
-            H_p4.SetPxPyPzE(lhe.P_X.At(4), lhe.P_Y.At(4), lhe.P_Z.At(4), lhe.E.At(4));
+            H_p4.SetPxPyPzE(lhe.P_X.at(4), lhe.P_Y.at(4), lhe.P_Z.at(4), lhe.E.at(4));
             arbol.setLeaf<float>("H_pt", H_p4.pt());
             arbol.setLeaf<float>("H_eta", H_p4.eta());
             arbol.setLeaf<float>("H_phi", H_p4.phi());
@@ -111,9 +127,9 @@ int main(int argc, char** argv)
             arbol.setLeaf<float>("M_WWH", (W1_p4 + W2_p4 + H_p4).mass());
             // VBS jets
             LorentzVector VBS1_p4;
-            VBS1_p4.SetPxPyPzE(lhe.P_X.At(5), lhe.P_Y.At(5), lhe.P_Z.At(5), lhe.E.At(5));
+            VBS1_p4.SetPxPyPzE(lhe.P_X.at(5), lhe.P_Y.at(5), lhe.P_Z.at(5), lhe.E.at(5));
             LorentzVector VBS2_p4;
-            VBS2_p4.SetPxPyPzE(lhe.P_X.At(6), lhe.P_Y.At(6), lhe.P_Z.At(6), lhe.E.At(6));
+            VBS2_p4.SetPxPyPzE(lhe.P_X.at(6), lhe.P_Y.at(6), lhe.P_Z.at(6), lhe.E.at(6));
             if (VBS1_p4.pt() > VBS2_p4.pt())
             {
                 arbol.setLeaf<float>("ld_VBS_pt", VBS1_p4.pt());
@@ -131,25 +147,28 @@ int main(int argc, char** argv)
     );
     cutflow.insert("Bookkeeping", cut, Right);
 
-    // Run looper
-    looper.run(
-        [&](TTree* ttree) { lhe.Init(ttree); },
-        [&](int entry) 
+    // Stream events directly from the LHE files
+    for (auto& lhe_file : lhe_files)
+    {
+        LHE::File reader(lhe_file);
+        // Ids of the reweights of the events of this file, in order
+        weight_ids = reader.weight_ids;
+        reweights_ttree->Fill();
+        while (reader.next(lhe))
         {
-            lhe.GetEntry(entry);
-            lhe.Process(entry);
             // Reset tree
             arbol.resetBranches();
             // Run cutflow
             bool passed = cutflow.run("SetFlatVariables");
             if (passed) { arbol.fillTTree(); }
-            return;
         }
-    );
+    }
 
     // Wrap up
     cutflow.print();
     cutflow.writeCSV(cli.output_dir);
+    output_tfile->cd();
+    reweights_ttree->Write();
     arbol.writeTFile();
     return 0;
 }
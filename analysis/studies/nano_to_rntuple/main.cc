@@ -0,0 +1,73 @@
+// STL
+#include <set>
+#include <string>
+// VBS
+#include "core/rntuple.h"
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TKey.h"
+#include "TList.h"
+#include "stdio.h"
+
+/* Copy a NanoAOD file (or skim) with its Events TTree converted to an RNTuple (core/rntuple.h):
+   one field per branch, with leaf-count arrays (e.g. Jet_pt[nJet]) as std::vector fields next to
+   their count field (nJet). All other TTrees (Runs, LuminosityBlocks) are copied as they are. The
+   output can be read by any study that uses Input::Looper (see core/input.h), e.g.
+
+       make study=nano_to_rntuple
+       ./bin/nano_to_rntuple /path/to/skim.root /path/to/skim_rntuple.root
+       ./bin/vbsvvhjets --input_ttree=Events ... /path/to/skim_rntuple.root
+*/
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("usage: %s /path/to/input.root /path/to/output.root [ttree_name]\n", argv[0]);
+        return 1;
+    }
+#ifndef RNTUPLE_SUPPORTED
+    printf("RNTuple output needs ROOT 6.32 or later\n");
+    return 1;
+#else
+    std::string input_file = argv[1];
+    std::string output_file = argv[2];
+    std::string ttree_name = (argc > 3) ? argv[3] : "Events";
+
+    TFile* input_tfile = TFile::Open(input_file.c_str());
+    TTree* events = (TTree*) input_tfile->Get(ttree_name.c_str());
+    if (!events)
+    {
+        printf("no TTree named %s in %s\n", ttree_name.c_str(), input_file.c_str());
+        return 1;
+    }
+    TFile* output_tfile = new TFile(output_file.c_str(), "RECREATE");
+
+    // Events
+    RNTuples::InputBuffers buffers = RNTuples::InputBuffers(events);
+    RNTuples::Writer writer = RNTuples::Writer(events, output_tfile, ttree_name);
+    const Long64_t n_entries = events->GetEntries();
+    for (Long64_t entry = 0; entry < n_entries; ++entry)
+    {
+        events->GetEntry(entry);
+        writer.fill();
+    }
+    writer.write();
+
+    // Metadata
+    std::set<std::string> copied = {ttree_name};
+    TIter next_key(input_tfile->GetListOfKeys());
+    while (TKey* key = (TKey*) next_key())
+    {
+        // Keys are listed once per cycle, the latest cycle first
+        if (std::string(key->GetClassName()) != "TTree" || !copied.insert(key->GetName()).second) { continue; }
+        TTree* ttree = (TTree*) key->ReadObj();
+        output_tfile->cd();
+        ttree->CloneTree()->Write();
+    }
+    output_tfile->Close();
+    input_tfile->Close();
+    printf("%lld events written to %s\n", n_entries, output_file.c_str());
+    return 0;
+#endif
+}
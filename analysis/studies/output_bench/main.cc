@@ -0,0 +1,125 @@
+// STL
+#include <chrono>
+#include <string>
+#include <functional>
+// VBS
+#include "core/rntuple.h"
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#ifdef RNTUPLE_SUPPORTED
+#include <ROOT/RNTupleReader.hxx>
+#endif
+#include "stdio.h"
+
+/* Write and read throughput of a baby as a TTree and as an RNTuple (core/rntuple.h). The entries
+   of the input TTree are read once per output format and written with TTree::Fill or with
+   RNTuples::Writer::fill; the time to read the input alone is measured first and subtracted.
+   Both outputs are then read back in full. Each format uses the default compression of ROOT.
+
+       make study=output_bench
+       ./bin/output_bench /path/to/baby.root [ttree_name] [output_dir]
+*/
+double seconds(std::function<void()> run)
+{
+    auto start = std::chrono::steady_clock::now();
+    run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void print(std::string name, double n_entries, double n_bytes, double write_s, double read_s, double file_bytes)
+{
+    printf(
+        "%-8s %10.1f %10.2f %10.0f %10.1f %10.2f %10.0f %10.1f\n",
+        name.c_str(), file_bytes/1e6, write_s, n_entries/write_s, n_bytes/1e6/write_s,
+        read_s, n_entries/read_s, n_bytes/1e6/read_s
+    );
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s /path/to/baby.root [ttree_name] [output_dir]\n", argv[0]);
+        return 1;
+    }
+#ifndef RNTUPLE_SUPPORTED
+    printf("RNTuple output needs ROOT 6.32 or later\n");
+    return 1;
+#else
+    std::string input_file = argv[1];
+    std::string ttree_name = (argc > 2) ? argv[2] : "Events";
+    std::string output_dir = (argc > 3) ? argv[3] : ".";
+    std::string ttree_file = output_dir + "/output_bench_ttree.root";
+    std::string rntuple_file = output_dir + "/output_bench_rntuple.root";
+
+    TFile* input_tfile = TFile::Open(input_file.c_str());
+    TTree* input = (TTree*) input_tfile->Get(ttree_name.c_str());
+    if (!input)
+    {
+        printf("no TTree named %s in %s\n", ttree_name.c_str(), input_file.c_str());
+        return 1;
+    }
+    RNTuples::InputBuffers buffers = RNTuples::InputBuffers(input);
+    const Long64_t n_entries = input->GetEntries();
+    const double n_bytes = input->GetTotBytes(); // uncompressed
+
+    // Input alone (run twice, so that the file is in the page cache for every measurement)
+    double input_s = 0;
+    for (unsigned int rep_i = 0; rep_i < 2; ++rep_i)
+    {
+        input_s = seconds([&]() { for (Long64_t entry = 0; entry < n_entries; ++entry) { input->GetEntry(entry); } });
+    }
+
+    // RNTuple
+    TFile* rntuple_tfile = new TFile(rntuple_file.c_str(), "RECREATE");
+    RNTuples::Writer rntuple = RNTuples::Writer(input, rntuple_tfile, ttree_name);
+    double rntuple_write_s = seconds([&]() {
+        for (Long64_t entry = 0; entry < n_entries; ++entry)
+        {
+            input->GetEntry(entry);
+            rntuple.fill();
+        }
+        rntuple.write();
+        rntuple_tfile->Close();
+    }) - input_s;
+
+    // TTree
+    TFile* ttree_tfile = new TFile(ttree_file.c_str(), "RECREATE");
+    TTree* output = input->CloneTree(0);
+    double ttree_write_s = seconds([&]() {
+        for (Long64_t entry = 0; entry < n_entries; ++entry)
+        {
+            input->GetEntry(entry);
+            output->Fill();
+        }
+        ttree_tfile->cd();
+        output->Write();
+        ttree_tfile->Close();
+    }) - input_s;
+
+    // Read back
+    double ttree_read_s = seconds([&]() {
+        TFile* tfile = TFile::Open(ttree_file.c_str());
+        TTree* ttree = (TTree*) tfile->Get(ttree_name.c_str());
+        for (Long64_t entry = 0; entry < n_entries; ++entry) { ttree->GetEntry(entry); }
+        tfile->Close();
+    });
+    double rntuple_read_s = seconds([&]() {
+        auto reader = RNTuples::API::RNTupleReader::Open(ttree_name, rntuple_file);
+        for (Long64_t entry = 0; entry < n_entries; ++entry) { reader->LoadEntry(entry); }
+    });
+
+    TFile* ttree_size = TFile::Open(ttree_file.c_str());
+    TFile* rntuple_size = TFile::Open(rntuple_file.c_str());
+    printf("%lld entries, %.1f MB uncompressed, %.2f s to read the input\n", n_entries, n_bytes/1e6, input_s);
+    printf(
+        "%-8s %10s %10s %10s %10s %10s %10s %10s\n",
+        "format", "file MB", "write s", "write ev/s", "write MB/s", "read s", "read ev/s", "read MB/s"
+    );
+    print("ttree", n_entries, n_bytes, ttree_write_s, ttree_read_s, ttree_size->GetSize());
+    print("rntuple", n_entries, n_bytes, rntuple_write_s, rntuple_read_s, rntuple_size->GetSize());
+    return 0;
+#endif
+}
@@ -20,7 +20,7 @@ int main(int argc, char** argv)
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli);
+    Input::Looper looper = Input::Looper(cli);
 
     // Initialize Arbol
     Arbol arbol = Arbol(cli);
@@ -0,0 +1,80 @@
+// STL
+#include <string>
+// VBS
+#include "core/eventindex.h"
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TChain.h"
+#include "TList.h"
+#include "stdio.h"
+
+/* Re-skim event-index sidecars (see core/eventindex.h) with a tighter cut on their derived columns,
+   without reading the original files: the entries of the sidecars that pass the cut (a TTreeFormula
+   expression) are copied to a new sidecar, along with the merged Runs and LuminosityBlocks trees.
+   The entries that only mark an input file (entry = -1) are always kept, and the file tables
+   (EventIndexFiles) are copied in the same order as the entries, as hadd would.
+
+       make study=reindex
+       ./bin/reindex "ht_ak8 > 1500" /path/to/tighter_skim.root /path/to/skim_*.root
+*/
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        printf("usage: %s CUT /path/to/output.root /path/to/sidecar.root [...]\n", argv[0]);
+        return 1;
+    }
+    std::string cut = argv[1];
+    std::string output_file = argv[2];
+
+    TChain* index = new TChain("EventIndex");
+    TChain* files = new TChain("EventIndexFiles");
+    TList* runs = new TList();
+    TList* lumis = new TList();
+    for (int arg_i = 3; arg_i < argc; ++arg_i)
+    {
+        TFile* tfile = TFile::Open(argv[arg_i]);
+        if (tfile == nullptr || !EventIndex::isEventIndex(tfile))
+        {
+            printf("%s is not an event index\n", argv[arg_i]);
+            return 1;
+        }
+        TTree* input_runs = (TTree*) tfile->Get("Runs");
+        TTree* input_lumis = (TTree*) tfile->Get("LuminosityBlocks");
+        if (input_runs == nullptr || input_lumis == nullptr)
+        {
+            printf("%s has no Runs or LuminosityBlocks\n", argv[arg_i]);
+            return 1;
+        }
+        TTree* runtree = input_runs->CloneTree();
+        runtree->SetDirectory(0);
+        runs->Add(runtree);
+        TTree* lumitree = input_lumis->CloneTree();
+        lumitree->SetDirectory(0);
+        lumis->Add(lumitree);
+        tfile->Close();
+        delete tfile;
+        index->Add(argv[arg_i]);
+        files->Add(argv[arg_i]);
+    }
+
+    TFile* output_tfile = new TFile(output_file.c_str(), "RECREATE");
+    TTree* selected = index->CopyTree(("entry < 0 || (" + cut + ")").c_str());
+    selected->Write();
+    TTree* file_table = files->CloneTree();
+    file_table->Write();
+    TTree* merged_runs = TTree::MergeTrees(runs);
+    merged_runs->SetName("Runs");
+    TTree* merged_lumis = TTree::MergeTrees(lumis);
+    merged_lumis->SetName("LuminosityBlocks");
+    output_tfile->cd();
+    merged_runs->Write();
+    merged_lumis->Write();
+    printf(
+        "%lld of %lld index entries kept (including one per input file) in %s\n",
+        selected->GetEntries(), index->GetEntries(), output_file.c_str()
+    );
+    output_tfile->Close();
+    return 0;
+}
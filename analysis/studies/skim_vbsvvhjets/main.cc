@@ -24,11 +24,13 @@ typedef std::vector<unsigned int> Indices;
 
 int main(int argc, char** argv) 
 {
-    // CLI
+    // CLI (--skim_format=copy|fast|index, see core/eventindex.h; --compression, see core/output.h)
+    EventIndex::SkimFormat skim_format = EventIndex::popSkimFormat(argc, argv);
+    int compression = Output::popCompression(argc, argv);
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli);
+    Input::Looper looper = Input::Looper(cli);
     // Initialize Arbusto
     Arbusto arbusto = Arbusto(
         cli,
@@ -65,7 +67,8 @@ int main(int argc, char** argv)
     cutflow.globals.newVar<LorentzVectors>("jet_p4s", {});
     cutflow.globals.newVar<double>("ht_ak8", -999);
 
-    Core::Skimmer skimmer = Core::Skimmer(arbusto, nt, cli, cutflow);
+    Core::Skimmer skimmer = Core::Skimmer(arbusto, nt, cli, cutflow, skim_format, compression);
+    skimmer.index.newColumn<double>("ht_ak8", -999);
 
     /* --- Assemble cutflow --- */
 
@@ -188,9 +191,17 @@ int main(int argc, char** argv)
                 nt.GetEntry(entry);
                 // bool passed = cutflow.run("FindVBSJetPairs"); // v2
                 bool passed = cutflow.run("AK8HTgt1100");
-                if (passed) { arbusto.fill(entry); }
+                if (passed)
+                {
+                    skimmer.index.setColumn<double>("ht_ak8", cutflow.globals.getVal<double>("ht_ak8"));
+                    skimmer.fill(entry);
+                }
                 bar.progress(looper.n_events_processed, looper.n_events_total);
             }
+        },
+        [&](TTree* ttree)
+        {
+            skimmer.finish(ttree);
         }
     );
 
@@ -1,3 +1,6 @@
+// VBS
+#include "core/collections.h"   // Core::Skimmer
+#include "core/input.h"         // Input::Looper
 // RAPIDO
 #include "arbusto.h"
 #include "looper.h"
@@ -22,20 +25,17 @@ int main(int argc, char** argv)
 {
     gconf.nanoAOD_ver = 9;
 
-    // CLI
+    // CLI (--skim_format=copy|fast|index, see core/eventindex.h; --compression, see core/output.h)
+    EventIndex::SkimFormat skim_format = EventIndex::popSkimFormat(argc, argv);
+    int compression = Output::popCompression(argc, argv);
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli.input_tchain);
+    Input::Looper looper = Input::Looper(cli);
 
     // Initialize Arbusto
-    TFile* output_tfile = new TFile(
-        TString(cli.output_dir+"/"+cli.output_name+".root"),
-        "RECREATE"
-    );
     Arbusto arbusto = Arbusto(
-        output_tfile,
-        cli.input_tchain,
+        cli,
         {
             "Electron*",
             "Muon*",
@@ -67,6 +67,8 @@ int main(int argc, char** argv)
     cutflow.globals.newVar<LorentzVectors>("loose_lep_p4s", {});
     cutflow.globals.newVar<LorentzVectors>("tight_lep_p4s", {});
 
+    Core::Skimmer skimmer = Core::Skimmer(arbusto, nt, cli, cutflow, skim_format, compression);
+
     // Bookkeeping
     Cut* base = new LambdaCut("Base", [&]() { return true; });
     cutflow.setRoot(base);
@@ -174,10 +176,7 @@ int main(int argc, char** argv)
         [&](TTree* ttree)
         {
             nt.Init(ttree);
-            arbusto.init(ttree);
-            TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
-            gconf.GetConfigs(nt.year());
-            gconf.isAPV = (file_name.Contains("HIPM_UL2016") || file_name.Contains("NanoAODAPV") || file_name.Contains("UL16APV"));
+            skimmer.init(ttree); // also stores the metadata ttrees
         },
         [&](int entry) 
         {
@@ -190,9 +189,13 @@ int main(int argc, char** argv)
                 // Run cutflow
                 nt.GetEntry(entry);
                 bool passed = cutflow.run(geq1fatjet);
-                if (passed) { arbusto.fill(); }
+                if (passed) { skimmer.fill(entry); }
                 bar.progress(looper.n_events_processed, looper.n_events_total);
             }
+        },
+        [&](TTree* ttree)
+        {
+            skimmer.finish(ttree);
         }
     );
 
@@ -201,6 +204,6 @@ int main(int argc, char** argv)
     {
         cutflow.print();
     }
-    arbusto.write();
+    skimmer.write();
     return 0;
 }
@@ -24,11 +24,13 @@ int main(int argc, char** argv)
 {
     gconf.nanoAOD_ver = 9;
 
-    // CLI
+    // CLI (--skim_format=copy|fast|index, see core/eventindex.h; --compression, see core/output.h)
+    EventIndex::SkimFormat skim_format = EventIndex::popSkimFormat(argc, argv);
+    int compression = Output::popCompression(argc, argv);
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli);
+    Input::Looper looper = Input::Looper(cli);
     // Initialize Arbusto
     Arbusto arbusto = Arbusto(
         cli,
@@ -56,14 +58,13 @@ int main(int argc, char** argv)
             "fixedGridRhoFastjetAll"
         }
     );
-    TList* runs = new TList();
-    TList* lumis = new TList();
 
     // Initialize Cutflow
     Cutflow cutflow = Cutflow(cli.output_name+"_Cutflow");
 
-    VBSWH::SkimmerPKU skimmer = VBSWH::SkimmerPKU(arbusto, nt, cli, cutflow);
+    VBSWH::SkimmerPKU skimmer = VBSWH::SkimmerPKU(arbusto, nt, cli, cutflow, skim_format, compression);
     skimmer.initCutflow();
+    skimmer.index.newColumn<double>("ST", -999);
 
     // Run looper
     tqdm bar;
@@ -71,14 +72,7 @@ int main(int argc, char** argv)
         [&](TTree* ttree)
         {
             nt.Init(ttree);
-            skimmer.init(ttree);
-            // Store metadata ttrees
-            TTree* runtree = ((TTree*)ttree->GetCurrentFile()->Get("Runs"))->CloneTree();
-            runtree->SetDirectory(0);
-            runs->Add(runtree);
-            TTree* lumitree = ((TTree*)ttree->GetCurrentFile()->Get("LuminosityBlocks"))->CloneTree();
-            lumitree->SetDirectory(0);
-            lumis->Add(lumitree);
+            skimmer.init(ttree); // also stores the metadata ttrees
         },
         [&](int entry) 
         {
@@ -91,23 +85,23 @@ int main(int argc, char** argv)
                 // run cutflow
                 nt.GetEntry(entry);
                 bool passed = cutflow.run("STgt800");
-                if (passed) { arbusto.fill(entry); }
+                if (passed)
+                {
+                    skimmer.index.setColumn<double>("ST", cutflow.globals.getVal<double>("ST"));
+                    skimmer.fill(entry);
+                }
                 bar.progress(looper.n_events_processed, looper.n_events_total);
             }
+        },
+        [&](TTree* ttree)
+        {
+            skimmer.finish(ttree);
         }
     );
 
     // Wrap up
     if (!cli.is_data) { cutflow.print(); }
 
-    TTree* merged_runs = TTree::MergeTrees(runs);
-    merged_runs->SetName("Runs");
-    TTree* merged_lumis = TTree::MergeTrees(lumis);
-    merged_lumis->SetName("LuminosityBlocks");
-
-    arbusto.tfile->cd();
-    merged_runs->Write();
-    merged_lumis->Write();
-    arbusto.write();
+    skimmer.write();
     return 0;
 }
@@ -1,4 +1,5 @@
 #include "vbsvvhjets/collections.h"
+#include "core/output.h"
 // RAPIDO
 #include "arbol.h"
 #include "hepcli.h"
@@ -17,24 +18,46 @@
 int main(int argc, char** argv) 
 {
     // CLI
+    Output::Format output_format = Output::popFormat(argc, argv);
+    int compression = Output::popCompression(argc, argv);
+    bool joint_jet_assignment = VBSVVHJets::popJointJetAssignment(argc, argv);
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli);
+    Input::Looper looper = Input::Looper(cli);
 
     // Initialize Arbol
     Arbol arbol = Arbol(cli);
     arbol.newBranch<double>("reweight_c2v_eq_3", -999);
+    arbol.newBranch<Doubles>("morph_coefs", {});
+
+    // Writes the Arbol in the chosen format (TTree, RNTuple or columns)
+    Output::Writer output = Output::Writer(arbol, cli, output_format, compression);
+
+    // Morphing in (C2V, kW, kZ): the VVH amplitude has terms linear in kV (H radiated off a
+    // V), C2V*kV (VVHH vertex with an off-shell H) and cubic in kV (H exchange + radiation)
+    CouplingMorphing morphing = CouplingMorphing(
+        {"C2V", "kW", "kZ"},
+        {
+            {0, 1, 0}, {0, 0, 1},                           // kW, kZ
+            {1, 1, 0}, {1, 0, 1},                           // C2V*kW, C2V*kZ
+            {0, 3, 0}, {0, 2, 1}, {0, 1, 2}, {0, 0, 3}      // kW^3, kW^2*kZ, kW*kZ^2, kZ^3
+        }
+    );
 
     // Initialize Cutflow
     Cutflow cutflow = Cutflow(cli.output_name + "_Cutflow");
 
     // Pack above into VBSVVHJets struct (also adds branches)
     VBSVVHJets::Analysis analysis = VBSVVHJets::Analysis(arbol, nt, cli, cutflow);
+    analysis.joint_jet_assignment = joint_jet_assignment;
     analysis.initBranches();
     analysis.initCorrections();
     analysis.initCutflow();
 
+    Cut* save_morph = new VBSVVHJets::SaveMorphingCoefs("SaveMorphingCoefs", analysis, &morphing);
+    cutflow.insert("Bookkeeping", save_morph, Right);
+
     arbol.newBranch<double>("ld_fatjet_xbb", -999);
     arbol.newBranch<double>("ld_fatjet_xwqq", -999);
     arbol.newBranch<double>("ld_fatjet_xvqq", -999);
@@ -64,7 +87,7 @@ int main(int argc, char** argv)
         "AllMerged_SetPtSortedFatJetVariables",
         [&]() 
         {
-            LorentzVectors fatjet_p4s = cutflow.globals.getVal<LorentzVectors>("good_fatjet_p4s");
+            SoA::P4Views fatjet_p4s = cutflow.globals.getVal<SoA::P4Views>("good_fatjet_p4s");
             Doubles fatjet_xbbs = cutflow.globals.getVal<Doubles>("good_fatjet_xbbtags");
             Doubles fatjet_xvqqs = cutflow.globals.getVal<Doubles>("good_fatjet_xvqqtags");
             Doubles fatjet_xwqqs = cutflow.globals.getVal<Doubles>("good_fatjet_xwqqtags");
@@ -113,6 +136,13 @@ int main(int argc, char** argv)
     );
     cutflow.insert("AllMerged_SelectVVHFatJets", set_ptsorted_fatjets, Right);
 
+    // Best total tagger score (xbb for the Hbb jet, xvqq for the W/Z jets) for comparison
+    Cut* assign_optimal_fatjets = new VBSVVHJets::AssignFatJetRoles(
+        "AllMerged_AssignFatJetRolesOptimal", analysis, "optimal", 
+        {{"hbbfatjet", "xbb"}, {"vqqfatjet1", "xvqq"}, {"vqqfatjet2", "xvqq"}}
+    );
+    cutflow.insert(set_ptsorted_fatjets, assign_optimal_fatjets, Right);
+
     if (cli.variation != "nofix")
     {
         TFile* pnet_pdf_file = new TFile("data/vbsvvhjets_sfs/qcd_pnet_pdfs.root");
@@ -126,7 +156,7 @@ int main(int argc, char** argv)
                 TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
                 if (file_name.Contains("QCD"))
                 {
-                    LorentzVectors fatjet_p4s = cutflow.globals.getVal<LorentzVectors>("good_fatjet_p4s");
+                    SoA::P4Views fatjet_p4s = cutflow.globals.getVal<SoA::P4Views>("good_fatjet_p4s");
                     Doubles fatjet_xbbs;
                     Doubles fatjet_xvqqs;
                     Doubles fatjet_xwqqs;
@@ -175,6 +205,7 @@ int main(int argc, char** argv)
             nt.Init(ttree);
             analysis.init();
             TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
+            morphing.init(file_name);
         },
         [&](int entry) 
         {
@@ -192,7 +223,7 @@ int main(int argc, char** argv)
                     "SemiMerged_SaveVariables"
                 };
                 std::vector<bool> checkpoints = cutflow.run(cuts_to_check);
-                if (checkpoints.at(0)) { arbol.fill(); }
+                if (checkpoints.at(0)) { output.fill(); }
 
                 // Update progress bar
                 bar.progress(looper.n_events_processed, looper.n_events_total);
@@ -205,7 +236,9 @@ int main(int argc, char** argv)
     {
         cutflow.print();
         cutflow.write(cli.output_dir);
+        if (analysis.compare_jet_assignments != nullptr) { analysis.compare_jet_assignments->print(); }
+        morphing.write(cli.output_dir+"/"+cli.output_name+"_morphing.txt");
     }
-    arbol.write();
+    output.write();
     return 0;
 }
@@ -68,10 +68,11 @@
 int main(int argc, char** argv)
 {
     // CLI
+    bool joint_jet_assignment = VBSVVHJets::popJointJetAssignment(argc, argv);
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli);
+    Input::Looper looper = Input::Looper(cli);
 
     // Initialize Arbol
     Arbol arbol = Arbol(cli);
@@ -82,6 +83,7 @@ int main(int argc, char** argv)
 
     // Pack above into VBSVVHJets struct (also adds branches)
     VBSVVHJets::Analysis analysis = VBSVVHJets::Analysis(arbol, nt, cli, cutflow);
+    analysis.joint_jet_assignment = joint_jet_assignment;
     analysis.initBranches();
     // analysis.initCorrections();
     analysis.initCutflow();
@@ -494,19 +496,17 @@ std::cout << "ld_ww_idx: " << ld_ww_idx << ", tr_ww_idx: " << tr_ww_idx << std::
 
 
 
-    // combining the two vqq ak4 jets four vectors
+    // combining the two vqq ak4 jets four vectors (declared by SelectVJets)
+    unsigned int vqqjets = analysis.composites.getCandidate("vqqjets");
     Cut* addition_vqqjets = new LambdaCut(
         "Addition_Vqqjets",
         [&]()
         {
-            // combining the two vqq ak4 jets four vectors
-            LorentzVector ld_vqqjet_p4 = cutflow.globals.getVal<LorentzVector>("ld_vqqjet_p4");
-            LorentzVector tr_vqqjet_p4 = cutflow.globals.getVal<LorentzVector>("tr_vqqjet_p4");
             // adding leaves for compining the two vqq ak4 jets four vectors
-            arbol.setLeaf<double>("vqqjets_pt",(ld_vqqjet_p4 + tr_vqqjet_p4).pt());
-            arbol.setLeaf<double>("vqqjets_phi",(ld_vqqjet_p4 + tr_vqqjet_p4).phi());
-            arbol.setLeaf<double>("vqqjets_mass",(ld_vqqjet_p4 + tr_vqqjet_p4).mass());
-            arbol.setLeaf<double>("vqqjets_eta",(ld_vqqjet_p4 + tr_vqqjet_p4).eta());
+            arbol.setLeaf<double>("vqqjets_pt", analysis.composites.pt(vqqjets));
+            arbol.setLeaf<double>("vqqjets_phi", analysis.composites.phi(vqqjets));
+            arbol.setLeaf<double>("vqqjets_mass", analysis.composites.M(vqqjets));
+            arbol.setLeaf<double>("vqqjets_eta", analysis.composites.eta(vqqjets));
             return true;
         }
     );
@@ -1169,6 +1169,7 @@ std::cout << "ld_ww_idx: " << ld_ww_idx << ", tr_ww_idx: " << tr_ww_idx << std::
     {
         cutflow.print();
         cutflow.write(cli.output_dir);
+        if (analysis.compare_jet_assignments != nullptr) { analysis.compare_jet_assignments->print(); }
     }
     arbol.write();
     return 0;
@@ -15,49 +15,20 @@ public:
         ewk_fix = new SFHist("data/ewk_fix.root", "Wgt__pdgid5_quarks_pt_varbin");
     };
 
-    int getChargeQx3(int q_pdgID)
-    {
-        switch (abs(q_pdgID))
-        {
-        case 1:
-            return -1; // down
-        case 2:
-            return  2; // up
-        case 3:
-            return -1; // strange
-        case 4:
-            return  2; // charm
-        case 5:
-            return -1; // bottom
-        case 6:
-            return  2; // top
-        default:
-            return -999;
-        }
-    };
-
-    double getChargeQQ(int q1_pdgID, int q2_pdgID)
-    {
-        int q1_sign = (q1_pdgID > 0) - (q1_pdgID < 0);
-        int q2_sign = (q2_pdgID > 0) - (q2_pdgID < 0);
-        return (q1_sign*getChargeQx3(q1_pdgID) + q2_sign*getChargeQx3(q2_pdgID)) / 3.;
-    };
-
     bool evaluate()
     {
         TString file_name = cli.input_tchain->GetCurrentFile()->GetName();
         if (file_name.Contains("EWKWPlus") || file_name.Contains("EWKWMinus"))
         {
-            int q1_pdgID = nt.LHEPart_pdgId().at(4);
-            int q2_pdgID = nt.LHEPart_pdgId().at(5);
-            LorentzVector q1_p4 = nt.LHEPart_p4().at(4);
-            LorentzVector q2_p4 = nt.LHEPart_p4().at(5);
-            double M_qq = (q1_p4 + q2_p4).M();
-            LorentzVector lep_p4 = nt.LHEPart_p4().at(2);
-            LorentzVector nu_p4 = nt.LHEPart_p4().at(3);
-            double M_lnu = (lep_p4 + nu_p4).M();
+            const LHE::HardProcess& hard_process = lhe.hardProcess();
+            int q1_pdgID = hard_process.quarks.at(0).pdgID;
+            int q2_pdgID = hard_process.quarks.at(1).pdgID;
+            LorentzVector q1_p4 = hard_process.quarks.at(0).p4;
+            LorentzVector q2_p4 = hard_process.quarks.at(1).p4;
+            double M_qq = hard_process.M_qq;
+            double M_lnu = hard_process.M_lnu;
             bool is_WW = (
-                fabs(getChargeQQ(q1_pdgID, q2_pdgID)) == 1 
+                fabs(hard_process.charge_qq) == 1 
                 && M_qq >= 70 && M_qq < 90 
                 && M_lnu >= 70 && M_lnu < 90
             );
@@ -47,7 +47,7 @@ int main(int argc, char** argv)
     HEPCLI cli = HEPCLI(argc, argv);
 
     // Initialize Looper
-    Looper looper = Looper(cli);
+    Input::Looper looper = Input::Looper(cli);
 
     // Initialize Arbol
     Arbol arbol = Arbol(cli);
@@ -127,7 +127,7 @@ int main(int argc, char** argv)
         "SaveBosonCandidates",
         [&]()
         {
-            LorentzVectors fatjet_p4s = cutflow.globals.getVal<LorentzVectors>("good_fatjet_p4s");
+            SoA::P4Views fatjet_p4s = cutflow.globals.getVal<SoA::P4Views>("good_fatjet_p4s");
             Doubles fatjet_wqqtags = cutflow.globals.getVal<Doubles>("good_fatjet_wqqtags");
             Doubles fatjet_zqqtags = cutflow.globals.getVal<Doubles>("good_fatjet_zqqtags");
             Doubles fatjet_hbbtags = cutflow.globals.getVal<Doubles>("good_fatjet_hbbtags");
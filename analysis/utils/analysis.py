@@ -12,12 +12,29 @@ plt.style.use(hep.style.CMS)
 plt.rcParams.update({"figure.facecolor":  (1,1,1,0)})
 
 from utils.cutflow import Cut, Cutflow, CutflowCollection
+from utils import columns
 
 def clip(np_array, bins):
     clip_low = 0.5*(bins[0] + bins[1])
     clip_high = 0.5*(bins[-2] + bins[-1])
     return np.clip(np_array, clip_low, clip_high)
 
+def baby_name(baby):
+    return baby.rstrip("/").split("/")[-1].replace(".root", "").replace("_columns", "")
+
+def load_baby(baby, ttree_name, drop_columns):
+    """Load a ROOT baby, or its columnar copy (a directory, see utils/columns.py), as a DataFrame"""
+    if columns.is_columns(baby):
+        return columns.to_dataframe(baby, drop_columns=drop_columns)
+    with uproot.open(baby) as f:
+        return f[ttree_name].arrays([k for k in f[ttree_name].keys() if k not in drop_columns], library="pd")
+
+def load_stacked(baby, ttree_name, column):
+    if columns.is_columns(baby):
+        return columns.load(baby, columns=[column])[column].stack()
+    with uproot.open(baby) as f:
+        return np.stack(f[ttree_name].arrays(column, library="np")[column])
+
 class PandasAnalysis:
     def __init__(self, sig_root_files=None, bkg_root_files=None, data_root_files=None, 
                  ttree_name="Events", weight_columns=None, reweight_column=None, 
@@ -35,37 +52,34 @@ class PandasAnalysis:
         # Load signal
         if sig_root_files:
             for root_file in tqdm(sig_root_files, desc="Loading sig babies"):
-                name = root_file.split("/")[-1].replace(".root", "")
-                with uproot.open(root_file) as f:
-                    df = f[ttree_name].arrays([k for k in f[ttree_name].keys() if k not in drop_columns], library="pd")
-                    df["name"] = name
-                    df["is_signal"] = True
-                    df["is_data"] = False
-                    dfs.append(df)
-                    if reweight_column:
-                        self.sig_reweights = np.stack(f[ttree_name].arrays(reweight_column, library="np")[reweight_column])
+                name = baby_name(root_file)
+                df = load_baby(root_file, ttree_name, drop_columns)
+                df["name"] = name
+                df["is_signal"] = True
+                df["is_data"] = False
+                dfs.append(df)
+                if reweight_column:
+                    self.sig_reweights = load_stacked(root_file, ttree_name, reweight_column)
         # Load background
         bkg_names = []
         if bkg_root_files:
             for root_file in tqdm(bkg_root_files, desc="Loading bkg babies"):
-                name = root_file.split("/")[-1].replace(".root", "")
+                name = baby_name(root_file)
                 bkg_names.append(name)
-                with uproot.open(root_file) as f:
-                    df = f[ttree_name].arrays([k for k in f[ttree_name].keys() if k not in drop_columns], library="pd")
-                    df["name"] = name
-                    df["is_signal"] = False
-                    df["is_data"] = False
-                    dfs.append(df)
+                df = load_baby(root_file, ttree_name, drop_columns)
+                df["name"] = name
+                df["is_signal"] = False
+                df["is_data"] = False
+                dfs.append(df)
         # Load data
         if data_root_files:
             for root_file in tqdm(data_root_files, desc="Loading data babies"):
-                name = root_file.split("/")[-1].replace(".root", "")
-                with uproot.open(root_file) as f:
-                    df = f[ttree_name].arrays([k for k in f[ttree_name].keys() if k not in drop_columns], library="pd")
-                    df["name"] = name
-                    df["is_signal"] = False
-                    df["is_data"] = True
-                    dfs.append(df)
+                name = baby_name(root_file)
+                df = load_baby(root_file, ttree_name, drop_columns)
+                df["name"] = name
+                df["is_signal"] = False
+                df["is_data"] = True
+                dfs.append(df)
 
         self.df = pd.concat(dfs)
         self.df["name"] = self.df.name.astype("category")
@@ -0,0 +1,100 @@
+import os
+import time
+import glob
+import argparse
+import uproot
+import numpy as np
+import pandas as pd
+
+from utils import columns
+
+def columns_dir(root_file):
+    return root_file.replace(".root", "_columns")
+
+def load_root(root_file, ttree_name):
+    with uproot.open(root_file) as f_in:
+        ttree = f_in[ttree_name]
+        return ttree.arrays(
+            [name for name, branch in ttree.items() if branch.interpretation.__class__.__name__ == "AsDtype"],
+            library="np"
+        )
+
+def load_columns(path):
+    # Copy out of the memory map, so that both loaders end up with the same arrays in memory
+    return {
+        name: np.array(array) for name, array in columns.load(path).items()
+        if not isinstance(array, columns.Jagged)
+    }
+
+def timed(load, *args):
+    start = time.perf_counter()
+    arrays = load(*args)
+    pd.DataFrame(arrays)
+    return time.perf_counter() - start, sum(array.nbytes for array in arrays.values())
+
+def du(path):
+    if os.path.isdir(path):
+        return sum(os.path.getsize(os.path.join(path, f)) for f in os.listdir(path))
+    return os.path.getsize(path)
+
+if __name__ == "__main__":
+    cli = argparse.ArgumentParser(
+        description=(
+            "Compare the time to load babies into numpy/pandas from ROOT (uproot) and from the "
+            + "columnar output of include/core/columns.h (numpy.memmap)"
+        )
+    )
+    cli.add_argument(
+        "babies", type=str, nargs="+",
+        help="ROOT babies, or directories of them (e.g. studies/vbsvvhjets/output_TAG/Run2)"
+    )
+    cli.add_argument(
+        "--ttree", type=str, default="Events",
+        help="Name of the output TTree"
+    )
+    cli.add_argument(
+        "--convert", action="store_true",
+        help="Write {baby}_columns from the ROOT baby if it is missing"
+    )
+    cli.add_argument(
+        "--n_reps", type=int, default=3,
+        help="Number of times to load each baby; the first load (page cache possibly cold) is reported separately"
+    )
+    args = cli.parse_args()
+
+    root_files = []
+    for baby in args.babies:
+        root_files += sorted(glob.glob(f"{baby}/*.root")) if os.path.isdir(baby) else [baby]
+
+    for root_file in root_files:
+        if not columns.is_columns(columns_dir(root_file)):
+            if not args.convert:
+                raise FileNotFoundError(f"no {columns_dir(root_file)} (run with --convert to write it)")
+            columns.from_root(root_file, columns_dir(root_file), ttree_name=args.ttree)
+
+    # Each format is loaded n_reps times in a row, so that the first load of each is equally cold
+    results = {}
+    for fmt, load in [("root", lambda f: load_root(f, args.ttree)), ("columns", lambda f: load_columns(columns_dir(f)))]:
+        first_s = 0
+        best_s = 0
+        n_bytes = 0
+        for root_file in root_files:
+            times = []
+            for rep_i in range(args.n_reps):
+                elapsed, n_bytes_loaded = timed(load, root_file)
+                times.append(elapsed)
+            first_s += times[0]
+            best_s += min(times)
+            n_bytes += n_bytes_loaded
+        disk = sum(du(f if fmt == "root" else columns_dir(f)) for f in root_files)
+        results[fmt] = (first_s, best_s, n_bytes, disk)
+
+    print(f"{len(root_files)} babies")
+    print(f"{'format':<10} {'disk MB':>10} {'memory MB':>10} {'first s':>10} {'best s':>10} {'best MB/s':>10}")
+    for fmt, (first_s, best_s, n_bytes, disk) in results.items():
+        print(
+            f"{fmt:<10} {disk/1e6:>10.1f} {n_bytes/1e6:>10.1f} {first_s:>10.3f} {best_s:>10.3f} "
+            + f"{n_bytes/1e6/best_s:>10.1f}"
+        )
+    print(f"speedup: {results['root'][1]/results['columns'][1]:.1f}x (best), "
+          + f"{results['root'][0]/results['columns'][0]:.1f}x (first)")
@@ -0,0 +1,72 @@
+import os
+import re
+import argparse
+from subprocess import Popen, PIPE
+
+# Printed by Input::Looper (include/core/input.h) when the study is run with --verbose
+LOOPER_RE = re.compile(r"Input::Looper: (\d+) events in ([\d.]+) s")
+
+def run_study(study, input_file, output_dir, output_name, extra_args):
+    cmd = [
+        f"bin/{study}",
+        "--input_ttree=Events",
+        f"--output_dir={output_dir}",
+        f"--output_name={output_name}",
+        "--verbose"
+    ] + extra_args + [input_file]
+    stdout, stderr = Popen(cmd, stdout=PIPE, stderr=PIPE).communicate()
+    match = LOOPER_RE.search(stdout.decode("utf-8"))
+    if not match:
+        raise RuntimeError(f"no events/s reported by {' '.join(cmd)}:\n{stderr.decode('utf-8')}")
+    return int(match.group(1)), float(match.group(2))
+
+if __name__ == "__main__":
+    cli = argparse.ArgumentParser(
+        description=(
+            "Compare the event rate of a study run over the TTree and the RNTuple versions of the same "
+            + "NanoAOD skim (see studies/nano_to_rntuple and include/core/input.h)"
+        )
+    )
+    cli.add_argument(
+        "study", type=str,
+        help="Name of the study to run (e.g. vbsvvhjets)"
+    )
+    cli.add_argument(
+        "ttree_file", type=str,
+        help="NanoAOD skim with an Events TTree"
+    )
+    cli.add_argument(
+        "rntuple_file", type=str,
+        help="The same skim with an Events RNTuple (from bin/nano_to_rntuple)"
+    )
+    cli.add_argument(
+        "--output_dir", type=str, default="bench_input",
+        help="Directory for the (discarded) outputs of the study"
+    )
+    cli.add_argument(
+        "--n_reps", type=int, default=3,
+        help="Number of times to run over each input; the first run (page cache possibly cold) is reported separately"
+    )
+    cli.add_argument(
+        "study_args", type=str, nargs=argparse.REMAINDER,
+        help="Any other arguments for the study (e.g. --is_data), after --"
+    )
+    args = cli.parse_args()
+    study_args = [arg for arg in args.study_args if arg != "--"]
+    os.makedirs(args.output_dir, exist_ok=True)
+
+    # Each input is run n_reps times in a row, so that the first run over each is equally cold
+    results = {}
+    for fmt, input_file in [("ttree", args.ttree_file), ("rntuple", args.rntuple_file)]:
+        rates = []
+        for rep_i in range(args.n_reps):
+            n_events, elapsed = run_study(args.study, input_file, args.output_dir, f"bench_{fmt}", study_args)
+            rates.append(n_events/elapsed)
+        results[fmt] = (n_events, os.path.getsize(input_file), rates[0], max(rates))
+
+    print(f"{args.study}")
+    print(f"{'format':<10} {'events':>10} {'file MB':>10} {'first ev/s':>12} {'best ev/s':>12}")
+    for fmt, (n_events, file_bytes, first_rate, best_rate) in results.items():
+        print(f"{fmt:<10} {n_events:>10} {file_bytes/1e6:>10.1f} {first_rate:>12.0f} {best_rate:>12.0f}")
+    print(f"speedup: {results['rntuple'][3]/results['ttree'][3]:.2f}x (best), "
+          + f"{results['rntuple'][2]/results['ttree'][2]:.2f}x (first)")
@@ -0,0 +1,150 @@
+import os
+import json
+import numpy as np
+
+SCHEMA = "schema.json"
+
+class Jagged:
+    """Values of a vector leaf: entry i is content[offsets[i]:offsets[i+1]]"""
+    def __init__(self, offsets, content):
+        self.offsets = offsets
+        self.content = content
+
+    def __len__(self):
+        return len(self.offsets) - 1
+
+    def __getitem__(self, entry):
+        return self.content[self.offsets[entry]:self.offsets[entry+1]]
+
+    def counts(self):
+        return np.diff(self.offsets)
+
+    def split(self):
+        """One array per entry (e.g. for a pandas object column)"""
+        return np.split(np.asarray(self.content), np.asarray(self.offsets[1:-1]))
+
+    def stack(self):
+        """2D array, if every entry has the same number of values"""
+        counts = self.counts()
+        if len(counts) and np.any(counts != counts[0]):
+            raise ValueError("entries have different numbers of values")
+        width = counts[0] if len(counts) else 0
+        return np.asarray(self.content[self.offsets[0]:self.offsets[-1]]).reshape(len(self), width)
+
+def is_columns(path):
+    return os.path.isfile(os.path.join(path, SCHEMA))
+
+def read_schema(path):
+    with open(os.path.join(path, SCHEMA)) as f_in:
+        return json.load(f_in)
+
+def memmap(path, file_name, dtype, n_values):
+    if n_values == 0:
+        return np.zeros(0, dtype=dtype)
+    return np.memmap(os.path.join(path, file_name), dtype=dtype, mode="r", shape=(n_values,))
+
+def load(path, columns=None, drop_columns=[]):
+    """
+    Map the columns written by Columns::Writer (include/core/columns.h) in the directory path;
+    flat columns are np.memmap arrays, vector columns are Jagged arrays of two np.memmap arrays
+    """
+    schema = read_schema(path)
+    n_entries = schema["n_entries"]
+    arrays = {}
+    for column in schema["columns"]:
+        name = column["name"]
+        if (columns is not None and name not in columns) or name in drop_columns:
+            continue
+        if "offsets" in column:
+            offsets = memmap(path, column["offsets"], "<i8", n_entries + 1)
+            arrays[name] = Jagged(offsets, memmap(path, column["data"], column["dtype"], offsets[-1]))
+        else:
+            arrays[name] = memmap(path, column["data"], column["dtype"], n_entries)
+    return arrays
+
+def keys(path):
+    return [column["name"] for column in read_schema(path)["columns"]]
+
+def to_dataframe(path, columns=None, drop_columns=[]):
+    """Same as uproot's arrays(library="pd"), with vector columns as object columns of arrays"""
+    import pandas as pd
+    arrays = load(path, columns=columns, drop_columns=drop_columns)
+    return pd.DataFrame({
+        name: (array.split() if isinstance(array, Jagged) else np.asarray(array))
+        for name, array in arrays.items()
+    })
+
+def write(arrays, output_dir, ttree_name="Events"):
+    """Write a dict of flat arrays and Jagged arrays in the same format as Columns::Writer"""
+    os.makedirs(output_dir, exist_ok=True)
+    n_entries = None
+    schema_columns = []
+    for name, array in arrays.items():
+        if isinstance(array, Jagged):
+            n_array_entries = len(array)
+            content = np.asarray(array.content[array.offsets[0]:array.offsets[-1]])
+            offsets = np.asarray(array.offsets, dtype="<i8") - array.offsets[0]
+            dtype = content.dtype.newbyteorder("<")
+            offsets.tofile(os.path.join(output_dir, f"{name}.offsets"))
+            content.astype(dtype).tofile(os.path.join(output_dir, f"{name}.data"))
+            schema_columns.append(
+                {"name": name, "dtype": dtype.str, "data": f"{name}.data", "offsets": f"{name}.offsets"}
+            )
+        else:
+            array = np.asarray(array)
+            n_array_entries = len(array)
+            dtype = array.dtype.newbyteorder("<")
+            array.astype(dtype).tofile(os.path.join(output_dir, f"{name}.bin"))
+            schema_columns.append({"name": name, "dtype": dtype.str, "data": f"{name}.bin"})
+        if n_entries is None:
+            n_entries = n_array_entries
+        elif n_array_entries != n_entries:
+            raise ValueError(f"{name} has {n_array_entries} entries, expected {n_entries}")
+
+    schema = {
+        "format": "columns",
+        "version": 1,
+        "ttree": ttree_name,
+        "n_entries": n_entries or 0,
+        "columns": schema_columns
+    }
+    with open(os.path.join(output_dir, SCHEMA), "w") as f_out:
+        json.dump(schema, f_out, indent=4)
+
+def from_root(root_file, output_dir, ttree_name="Events"):
+    """Convert a ROOT baby (flat and std::vector branches) to columns"""
+    import uproot
+    arrays = {}
+    with uproot.open(root_file) as f_in:
+        for name, values in f_in[ttree_name].arrays(library="np").items():
+            if values.dtype == object:
+                counts = np.array([len(entry) for entry in values], dtype="<i8")
+                offsets = np.zeros(len(values) + 1, dtype="<i8")
+                np.cumsum(counts, out=offsets[1:])
+                content = np.concatenate(values) if len(values) else np.zeros(0)
+                arrays[name] = Jagged(offsets, content)
+            else:
+                arrays[name] = values
+    write(arrays, output_dir, ttree_name=ttree_name)
+
+def merge(input_dirs, output_dir):
+    """Concatenate column directories with the same schema (the columns equivalent of hadd)"""
+    schemas = [read_schema(input_dir) for input_dir in input_dirs]
+    names = [column["name"] for column in schemas[0]["columns"]]
+    for input_dir, schema in zip(input_dirs, schemas):
+        if [column["name"] for column in schema["columns"]] != names:
+            raise ValueError(f"{input_dir} does not have the same columns as {input_dirs[0]}")
+
+    inputs = [load(input_dir) for input_dir in input_dirs]
+    merged = {}
+    for name in names:
+        arrays = [arrays_in[name] for arrays_in in inputs]
+        if isinstance(arrays[0], Jagged):
+            counts = np.concatenate([array.counts() for array in arrays])
+            offsets = np.zeros(len(counts) + 1, dtype="<i8")
+            np.cumsum(counts, out=offsets[1:])
+            content = np.concatenate([np.asarray(array.content) for array in arrays])
+            merged[name] = Jagged(offsets, content)
+        else:
+            merged[name] = np.concatenate([np.asarray(array) for array in arrays])
+    write(merged, output_dir, ttree_name=schemas[0]["ttree"])
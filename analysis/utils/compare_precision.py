@@ -0,0 +1,139 @@
+import argparse
+import uproot
+import numpy as np
+
+from utils.cutflow import Cutflow
+
+def load(root_file, ttree_name):
+    with uproot.open(root_file) as f_in:
+        ttree = f_in[ttree_name]
+        branches = {}
+        for name, branch in ttree.items():
+            # Only flat numerical branches can be compared value by value
+            if branch.interpretation.__class__.__name__ != "AsDtype":
+                continue
+            branches[name] = branch.array(library="np")
+    return branches
+
+KEY_BRANCHES = ["year", "run", "luminosityBlock", "event"]
+
+def event_keys(branches):
+    """
+    Return the (year, run, luminosityBlock, event) of each event; these only identify events
+    within one sample, so both files must hold the same sample(s), e.g. one baby per sample
+    """
+    missing = [name for name in KEY_BRANCHES if name not in branches]
+    if missing:
+        raise KeyError(f"output TTree has no {', '.join(missing)} branch(es) to match events with")
+    keys = np.rec.fromarrays(
+        [branches[name].astype(np.int64) for name in KEY_BRANCHES], names=KEY_BRANCHES
+    )
+    if len(np.unique(keys)) != len(keys):
+        raise ValueError("(year, run, luminosityBlock, event) is not unique; compare one sample at a time")
+    return keys
+
+def compare_cutflows(double_cflow, single_cflow):
+    lines = ["Cutflow (double vs. single)"]
+    double_cutflow = Cutflow.from_file(double_cflow)
+    single_cutflow = Cutflow.from_file(single_cflow)
+    for cut_name in double_cutflow.cut_names():
+        if cut_name not in single_cutflow.cut_names():
+            lines.append(f"  {cut_name}: missing in single-precision cutflow")
+            continue
+        double_cut = double_cutflow[cut_name]
+        single_cut = single_cutflow[cut_name]
+        diff = single_cut.n_pass - double_cut.n_pass
+        diff_wgt = single_cut.n_pass_weighted - double_cut.n_pass_weighted
+        flag = "" if diff == 0 else "  <--"
+        lines.append(
+            f"  {cut_name}: {double_cut.n_pass} vs. {single_cut.n_pass} pass (diff {diff:+d}, "
+            + f"{diff_wgt:+0.4g} wgt){flag}"
+        )
+    return lines
+
+def compare_events(double_branches, single_branches, atol, rtol):
+    lines = []
+    double_keys = event_keys(double_branches)
+    single_keys = event_keys(single_branches)
+    common, double_idxs, single_idxs = np.intersect1d(double_keys, single_keys, return_indices=True)
+    only_double = np.setdiff1d(double_keys, single_keys)
+    only_single = np.setdiff1d(single_keys, double_keys)
+
+    lines.append("Selected events")
+    lines.append(f"  double: {len(double_keys)}")
+    lines.append(f"  single: {len(single_keys)}")
+    lines.append(f"  common: {len(common)}")
+    lines.append(f"  only in double: {len(only_double)}")
+    for year, run, lumi, event in only_double[:20]:
+        lines.append(f"    year={year} run={run} luminosityBlock={lumi} event={event}")
+    lines.append(f"  only in single: {len(only_single)}")
+    for year, run, lumi, event in only_single[:20]:
+        lines.append(f"    year={year} run={run} luminosityBlock={lumi} event={event}")
+
+    lines.append(f"Branches over common events (differs: not within atol={atol} + rtol={rtol}*|double|)")
+    lines.append(f"  {'branch':<40} {'differs':>8} {'max abs diff':>14} {'max rel diff':>14}")
+    for name in sorted(double_branches):
+        if name in KEY_BRANCHES:
+            continue
+        if name not in single_branches:
+            lines.append(f"  {name:<40} missing in single-precision output")
+            continue
+        double_vals = double_branches[name][double_idxs].astype(np.float64)
+        single_vals = single_branches[name][single_idxs].astype(np.float64)
+        same = np.isclose(single_vals, double_vals, atol=atol, rtol=rtol, equal_nan=True)
+        abs_diff = np.abs(single_vals - double_vals)
+        abs_diff[~np.isfinite(abs_diff)] = 0
+        with np.errstate(divide="ignore", invalid="ignore"):
+            rel_diff = np.where(double_vals != 0, abs_diff/np.abs(double_vals), 0)
+        max_abs = abs_diff.max() if len(abs_diff) else 0
+        max_rel = rel_diff.max() if len(rel_diff) else 0
+        n_differ = np.sum(~same)
+        flag = "" if n_differ == 0 else "  <--"
+        lines.append(f"  {name:<40} {n_differ:>8} {max_abs:>14.4g} {max_rel:>14.4g}{flag}")
+    return lines
+
+if __name__ == "__main__":
+    cli = argparse.ArgumentParser(
+        description="Compare the output of a study built in double (default) and single precision"
+    )
+    cli.add_argument(
+        "double_root", type=str,
+        help="Output ROOT file of the default (double-precision) build"
+    )
+    cli.add_argument(
+        "single_root", type=str,
+        help="Output ROOT file of the PRECISION=single build, run over the same input"
+    )
+    cli.add_argument(
+        "--ttree", type=str, default="Events",
+        help="Name of the output TTree"
+    )
+    cli.add_argument(
+        "--cutflows", type=str, nargs=2, default=None, metavar=("DOUBLE_CFLOW", "SINGLE_CFLOW"),
+        help="Cutflow (.cflow) files of the two builds"
+    )
+    cli.add_argument(
+        "--atol", type=float, default=0.,
+        help="Absolute tolerance for values to count as equal"
+    )
+    cli.add_argument(
+        "--rtol", type=float, default=1e-6,
+        help="Relative tolerance for values to count as equal"
+    )
+    cli.add_argument(
+        "--output", type=str, default=None,
+        help="Also write the report to this file"
+    )
+    args = cli.parse_args()
+
+    report = []
+    if args.cutflows:
+        report += compare_cutflows(*args.cutflows)
+    report += compare_events(
+        load(args.double_root, args.ttree), load(args.single_root, args.ttree), args.atol, args.rtol
+    )
+
+    print("\n".join(report))
+    if args.output:
+        with open(args.output, "w") as f_out:
+            f_out.write("\n".join(report) + "\n")
@@ -0,0 +1,132 @@
+import os
+import re
+import gzip
+import argparse
+
+# MadGraph reweight commands, in a reweight card or in the <initrwgt> block of an LHE file:
+#     launch --rwgt_name=C2V_3p0_kW_1p0_kZ_1p0
+#     set anoinputs 1 3.0
+# or
+#     <weight id='rwgt_1'> set param_card anoinputs 1 3.0 # orig: 1.0 </weight>
+LAUNCH_RE = re.compile(r"^\s*launch\s*(?:--rwgt_name\s*=\s*(\S+))?", re.IGNORECASE)
+WEIGHT_RE = re.compile(r"<weight\s+id=['\"]([^'\"]+)['\"][^>]*>(.*?)</weight>", re.DOTALL)
+SET_RE = re.compile(r"set\s+(?:param_card\s+)?(\w+)\s+(\d+)\s+([-+\d.eEdD]+)", re.IGNORECASE)
+
+def read_card(card_file):
+    """Return [(name, {(block, id): value})] for every launch of a MadGraph reweight card"""
+    points = []
+    with open(card_file, "r") as f_in:
+        for line in f_in:
+            line = line.split("#")[0]
+            launch = LAUNCH_RE.match(line)
+            if launch:
+                points.append((launch.group(1) or f"rwgt_{len(points) + 1}", {}))
+                continue
+            setting = SET_RE.search(line)
+            if setting and points:
+                block, param_id, value = setting.groups()
+                points[-1][1][(block.lower(), int(param_id))] = float(value.lower().replace("d", "e"))
+    return points
+
+def read_lhe(lhe_file):
+    """Return [(name, {(block, id): value})] for every <weight> of the <initrwgt> block of an LHE file"""
+    opener = gzip.open if lhe_file.endswith(".gz") else open
+    header = ""
+    with opener(lhe_file, "rt") as f_in:
+        for line in f_in:
+            header += line
+            if "</initrwgt>" in line or "<init>" in line:
+                break
+    points = []
+    for name, commands in WEIGHT_RE.findall(header):
+        settings = {}
+        for block, param_id, value in SET_RE.findall(commands.split("#")[0]):
+            settings[(block.lower(), int(param_id))] = float(value.lower().replace("d", "e"))
+        points.append((name, settings))
+    return points
+
+def read_names(names_file, couplings):
+    """
+    Return [(name, {coupling: value})] from reweight names that spell out the couplings, e.g.
+    C2V_3p0_kW_1p0_kZ_m0p5 (as in data/{PROCESS}_reweights.txt, see make_datacards.py)
+    """
+    points = []
+    with open(names_file, "r") as f_in:
+        for name in f_in.read().split():
+            tokens = name.split("_")
+            values = {}
+            for token_i in range(len(tokens) - 1):
+                if tokens[token_i] in couplings:
+                    values[tokens[token_i]] = float(tokens[token_i + 1].replace("p", ".").replace("m", "-"))
+            points.append((name, values))
+    return points
+
+if __name__ == "__main__":
+    cli = argparse.ArgumentParser(
+        description=(
+            "Write the morphing basis of a sample (data/morphing_bases/{SAMPLE}.txt, see include/core/morphing.h) "
+            + "from its reweight card, from the <initrwgt> block of one of its LHE files, or from a list of "
+            + "reweight names that spell out the couplings"
+        )
+    )
+    cli.add_argument(
+        "input_file", type=str,
+        help="Reweight card (.dat), LHE file (.lhe or .lhe.gz), or list of reweight names (.txt)"
+    )
+    cli.add_argument(
+        "sample", type=str,
+        help="Sample name, i.e. the name of its directory up to _Tune (e.g. VBSWWH_Inclusive_4f)"
+    )
+    cli.add_argument(
+        "--couplings", type=str, nargs="+", default=["C2V", "kW", "kZ"],
+        help="Couplings, in the order of the CouplingMorphing of the study"
+    )
+    cli.add_argument(
+        "--params", type=str, nargs="*", default=[],
+        help="Parameter card entry of each coupling as NAME=BLOCK:ID (e.g. C2V=anoinputs:1); not needed for .txt"
+    )
+    cli.add_argument(
+        "--defaults", type=str, nargs="*", default=[],
+        help="Value of each coupling when a reweight point does not set it, as NAME=VALUE (default: 1)"
+    )
+    cli.add_argument(
+        "--output_dir", type=str, default="data/morphing_bases",
+        help="Directory of the basis files"
+    )
+    args = cli.parse_args()
+
+    defaults = {coupling: 1.0 for coupling in args.couplings}
+    for default in args.defaults:
+        name, value = default.split("=")
+        defaults[name] = float(value)
+
+    if args.input_file.endswith(".txt"):
+        points = read_names(args.input_file, args.couplings)
+    else:
+        params = {}
+        for param in args.params:
+            name, entry = param.split("=")
+            block, param_id = entry.split(":")
+            params[(block.lower(), int(param_id))] = name
+        missing = [coupling for coupling in args.couplings if coupling not in params.values()]
+        if missing:
+            raise ValueError(f"no --params entry for {', '.join(missing)}")
+        if args.input_file.endswith(".lhe") or args.input_file.endswith(".lhe.gz"):
+            points = read_lhe(args.input_file)
+        else:
+            points = read_card(args.input_file)
+        points = [
+            (name, {params[entry]: value for entry, value in settings.items() if entry in params})
+            for name, settings in points
+        ]
+    if not points:
+        raise ValueError(f"no reweight points found in {args.input_file}")
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    output_file = f"{args.output_dir}/{args.sample}.txt"
+    with open(output_file, "w") as f_out:
+        f_out.write(f"# {' '.join(args.couplings)}  (from {os.path.basename(args.input_file)})\n")
+        for name, values in points:
+            couplings = [values.get(coupling, defaults[coupling]) for coupling in args.couplings]
+            f_out.write(" ".join(f"{value:g}" for value in couplings) + f"  # {name}\n")
+    print(f"{len(points)} reweight points written to {output_file}")
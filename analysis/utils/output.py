@@ -0,0 +1,37 @@
+import os
+import glob
+from subprocess import Popen, PIPE
+
+from utils import columns
+
+# Output formats of Output::Writer (include/core/output.h)
+FORMATS = ["ttree", "rntuple", "columns"]
+
+def root_version():
+    stdout, _ = Popen(["root-config", "--version"], stdout=PIPE).communicate()
+    major, minor = stdout.decode("utf-8").strip().replace("/", ".").split(".")[:2]
+    return int(major), int(minor)
+
+def check_hadd(output_format):
+    """RNTuples are written to the same files as TTrees, but hadd only merges them since ROOT 6.32"""
+    if output_format == "rntuple" and root_version() < (6, 32):
+        raise RuntimeError(f"hadd of ROOT {'.'.join(map(str, root_version()))} cannot merge RNTuples (needs 6.32)")
+
+def merge_columns(output_dir, sample_map):
+    """
+    Concatenate the {output_name}_columns directories of the jobs of each group in sample_map
+    into {output_dir}/Run2/{group}_columns, the same way the ROOT files are hadded
+    """
+    for group_name, year_patterns in sample_map.items():
+        input_dirs = []
+        for year, patterns in year_patterns.items():
+            for pattern in patterns:
+                input_dirs += sorted(
+                    input_dir for input_dir in glob.glob(f"{output_dir}/{year}/{pattern}_columns")
+                    if columns.is_columns(input_dir) and input_dir not in input_dirs
+                )
+        if not input_dirs:
+            print(f"WARNING: no columns found for {group_name}")
+            continue
+        print(f"Merging {len(input_dirs)} column directories into {output_dir}/Run2/{group_name}_columns")
+        columns.merge(input_dirs, f"{output_dir}/Run2/{group_name}_columns")